@@ -0,0 +1,326 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "h264bsd_stream.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Bit reader benchmark for the native build. Reads a random buffer as a
+// sequence of fixed-length fields of random width and reports bits per
+// second for:
+//   reference   the original out-of-line h264bsdShowBits32/h264bsdFlushBits
+//               (copied below, before the 64-bit reader)
+//   stream      h264bsdGetBits of h264bsd_stream.h
+//   cache       h264bsdBitCacheGet of h264bsd_stream.h
+// All readers have to return the same fields, checked with their sum.
+//
+// The buffer is then read as variable length codes the way
+// h264bsdDecodeResidualBlockCavlc reads a residual block: 16 bits are
+// shown, the code length is looked up from them and only the code is
+// flushed, so each read depends on the previous lookup. Blocks of 16 codes,
+// the stream structure is updated after each block:
+//   stream vlc  h264bsdShowBits32/h264bsdFlushBits on a local copy of the
+//               stream structure
+//   cache vlc   h264bsdBitCacheShow/h264bsdBitCacheFlush, as in the decoder
+
+typedef struct {
+    size_t size;            // buffer size in bytes
+    int repeat;
+} bench_options;
+
+/*---------------------------- reference reader ----------------------------*/
+
+static __attribute__((noinline)) u32 ref_show_bits32(strmData_t *pStrmData) {
+    i32 bits, shift;
+    u32 out;
+    u8 *pStrm = pStrmData->pStrmCurrPos;
+
+    bits = (i32) pStrmData->strmBuffSize * 8 -
+           (i32) pStrmData->strmBuffReadBits;
+    if (bits >= 32) {
+        u32 bitPosInWord = pStrmData->bitPosInWord;
+        out = ((u32) pStrm[0] << 24) | ((u32) pStrm[1] << 16) |
+              ((u32) pStrm[2] << 8) | ((u32) pStrm[3]);
+        if (bitPosInWord) {
+            out <<= bitPosInWord;
+            out |= (u32) pStrm[4] >> (8 - bitPosInWord);
+        }
+        return out;
+    } else if (bits > 0) {
+        shift = (i32) (24 + pStrmData->bitPosInWord);
+        out = (u32) (*pStrm++) << shift;
+        bits -= (i32) (8 - pStrmData->bitPosInWord);
+        while (bits > 0) {
+            shift -= 8;
+            out |= (u32) (*pStrm++) << shift;
+            bits -= 8;
+        }
+        return out;
+    }
+    return 0;
+}
+
+static __attribute__((noinline)) u32 ref_flush_bits(strmData_t *pStrmData,
+                                                    u32 numBits) {
+    pStrmData->strmBuffReadBits += numBits;
+    pStrmData->bitPosInWord = pStrmData->strmBuffReadBits & 0x7;
+    if (pStrmData->strmBuffReadBits <= 8 * pStrmData->strmBuffSize) {
+        pStrmData->pStrmCurrPos = pStrmData->pStrmBuffStart +
+                                  (pStrmData->strmBuffReadBits >> 3);
+        return HANTRO_OK;
+    }
+    return END_OF_STREAM;
+}
+
+static u32 ref_get_bits(strmData_t *pStrmData, u32 numBits) {
+    u32 out = ref_show_bits32(pStrmData) >> (32 - numBits);
+    if (ref_flush_bits(pStrmData, numBits) == HANTRO_OK) return out;
+    return END_OF_STREAM;
+}
+
+/*-------------------------------- readers ---------------------------------*/
+
+static void init_stream(strmData_t *strm, u8 *data, size_t size) {
+    strm->pStrmBuffStart = strm->pStrmCurrPos = data;
+    strm->bitPosInWord = 0;
+    strm->strmBuffSize = (u32) size;
+    strm->strmBuffReadBits = 0;
+}
+
+// Each reader reads the fields given by widths, numFields of them, and
+// returns the sum of the values read.
+
+static u32 read_reference(u8 *data, size_t size, const u8 *widths,
+                          size_t numFields) {
+    strmData_t strm;
+    u32 sum = 0;
+
+    init_stream(&strm, data, size);
+    for (size_t i = 0; i < numFields; i++) {
+        sum += ref_get_bits(&strm, widths[i]);
+    }
+    return sum;
+}
+
+static u32 read_stream(u8 *data, size_t size, const u8 *widths,
+                       size_t numFields) {
+    strmData_t strm;
+    u32 sum = 0;
+
+    init_stream(&strm, data, size);
+    for (size_t i = 0; i < numFields; i++) {
+        sum += h264bsdGetBits(&strm, widths[i]);
+    }
+    return sum;
+}
+
+static u32 read_cache(u8 *data, size_t size, const u8 *widths,
+                      size_t numFields) {
+    strmData_t strm;
+    bitCache_t cache;
+    u32 sum = 0;
+
+    init_stream(&strm, data, size);
+    h264bsdBitCacheInit(&strm, &cache);
+    for (size_t i = 0; i < numFields; i++) {
+        sum += h264bsdBitCacheGet(&strm, &cache, widths[i]);
+    }
+    (void) h264bsdBitCacheSync(&strm, &cache);
+    return sum;
+}
+
+/*----------------------------- CAVLC readers ------------------------------*/
+
+// Each reader reads codes until numBits bits are consumed, the length of a
+// code (1 to 16) is lengths[] of its first 8 bits. Returns the sum of the
+// codes read, the number of codes in numCodes.
+
+static u32 read_stream_vlc(u8 *data, size_t size, const u8 *lengths,
+                           size_t numBits, size_t *numCodes) {
+    strmData_t strm;
+    u32 sum = 0;
+    size_t count = 0;
+
+    init_stream(&strm, data, size);
+    while (strm.strmBuffReadBits < numBits) {
+        strmData_t local = strm;
+        for (int i = 0; i < 16 && local.strmBuffReadBits < numBits; i++) {
+            u32 bits = h264bsdShowBits32(&local) >> 16;
+            u32 length = lengths[bits >> 8];
+            sum += bits >> (16 - length);
+            (void) h264bsdFlushBits(&local, length);
+            count++;
+        }
+        strm = local;
+    }
+    *numCodes = count;
+    return sum;
+}
+
+static u32 read_cache_vlc(u8 *data, size_t size, const u8 *lengths,
+                          size_t numBits, size_t *numCodes) {
+    strmData_t strm;
+    bitCache_t cache;
+    u32 sum = 0;
+    size_t count = 0;
+
+    init_stream(&strm, data, size);
+    while (strm.strmBuffReadBits < numBits) {
+        h264bsdBitCacheInit(&strm, &cache);
+        for (int i = 0;
+             i < 16 && strm.strmBuffReadBits + cache.used < numBits; i++) {
+            u32 bits = h264bsdBitCacheShow(&strm, &cache, 16);
+            u32 length = lengths[bits >> 8];
+            sum += bits >> (16 - length);
+            h264bsdBitCacheFlush(&cache, length);
+            count++;
+        }
+        (void) h264bsdBitCacheSync(&strm, &cache);
+    }
+    *numCodes = count;
+    return sum;
+}
+
+/*--------------------------------- driver ---------------------------------*/
+
+typedef u32 (*reader_func)(u8 *, size_t, const u8 *, size_t);
+typedef u32 (*vlc_reader_func)(u8 *, size_t, const u8 *, size_t, size_t *);
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: h264bitbench [options]\n"
+            "  -n <KiB>    size of the random buffer (default 4096)\n"
+            "  -r <count>  read the buffer count times (default 20)\n");
+}
+
+int main(int argc, char **argv) {
+    static const struct {
+        const char *name;
+        reader_func read;
+    } readers[] = {
+        {"reference", read_reference},
+        {"stream", read_stream},
+        {"cache", read_cache},
+    };
+    static const struct {
+        const char *name;
+        vlc_reader_func read;
+    } vlcReaders[] = {
+        {"stream vlc", read_stream_vlc},
+        {"cache vlc", read_cache_vlc},
+    };
+    u8 lengths[256];
+    bench_options options = {4096 * 1024, 20};
+    uint32_t seed = 0x12345678;
+    u32 expected = 0;
+    int result = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            options.size = (size_t) atol(argv[++i]) * 1024;
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            options.repeat = atoi(argv[++i]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (options.size < 1024 || options.repeat < 1) {
+        usage();
+        return 2;
+    }
+
+    // field widths 1..16, most syntax elements of a slice are short
+    size_t maxFields = options.size * 8;
+    u8 *data = malloc(options.size);
+    u8 *widths = malloc(maxFields);
+    if (!data || !widths) {
+        fprintf(stderr, "h264bitbench: out of memory\n");
+        free(data);
+        free(widths);
+        return 1;
+    }
+    for (size_t i = 0; i < options.size; i++) {
+        data[i] = (u8) xorshift32(&seed);
+    }
+    size_t numFields = 0, numBits = 0;
+    while (numFields < maxFields) {
+        u8 width = (u8) (1 + (xorshift32(&seed) & 15));
+        if (numBits + width > options.size * 8) break;
+        widths[numFields++] = width;
+        numBits += width;
+    }
+
+    printf("buffer      %zu KiB, %zu fields, %d passes\n",
+           options.size / 1024, numFields, options.repeat);
+    for (size_t r = 0; r < sizeof(readers) / sizeof(readers[0]); r++) {
+        u32 sum = 0;
+        double start = now_seconds();
+        for (int pass = 0; pass < options.repeat; pass++) {
+            sum = readers[r].read(data, options.size, widths, numFields);
+        }
+        double seconds = now_seconds() - start;
+        double bitsPerSecond =
+            (double) numBits * options.repeat / (seconds > 0 ? seconds : 1e-9);
+
+        if (r == 0) {
+            expected = sum;
+        } else if (sum != expected) {
+            fprintf(stderr, "h264bitbench: %s reader mismatch\n",
+                    readers[r].name);
+            result = 1;
+        }
+        printf("%-11s %8.1f Mbit/s  %6.2f ns/field\n", readers[r].name,
+               bitsPerSecond * 1e-6,
+               seconds * 1e9 / ((double) numFields * options.repeat));
+    }
+
+    // code length from the leading zeros of the first 8 bits, as for
+    // Exp-Golomb codes: short codes are the most frequent
+    for (u32 b = 0; b < 256; b++) {
+        u32 zeros = b ? (u32) __builtin_clz(b) - 24 : 8;
+        lengths[b] = (u8) (zeros < 8 ? 2 * zeros + 1 : 16);
+    }
+    for (size_t r = 0; r < sizeof(vlcReaders) / sizeof(vlcReaders[0]); r++) {
+        u32 sum = 0;
+        size_t numCodes = 0;
+        double start = now_seconds();
+        for (int pass = 0; pass < options.repeat; pass++) {
+            sum = vlcReaders[r].read(data, options.size, lengths, numBits,
+                                     &numCodes);
+        }
+        double seconds = now_seconds() - start;
+        if (seconds <= 0) seconds = 1e-9;
+
+        if (r == 0) {
+            expected = sum;
+        } else if (sum != expected) {
+            fprintf(stderr, "h264bitbench: %s reader mismatch\n",
+                    vlcReaders[r].name);
+            result = 1;
+        }
+        printf("%-11s %8.1f Mbit/s  %6.2f ns/code\n", vlcReaders[r].name,
+               (double) numBits * options.repeat / seconds * 1e-6,
+               seconds * 1e9 / ((double) numCodes * options.repeat));
+    }
+
+    free(data);
+    free(widths);
+    return result;
+}
@@ -0,0 +1,741 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "H264SwDecApi.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#ifdef H264DEC_SCHEDULER
+#include "H264SwDecScheduler.h"
+#endif
+
+// Command-line benchmark for the native build. Decodes an Annex B byte
+// stream and reports throughput, per-frame decode latency and peak memory.
+// With -a the stream is converted to length prefixed NAL units (AVCC) and
+// decoded with H264SwDecInput.nalLengthSize.
+// With -j the stream is decoded as several concurrent streams by the
+// multi-stream scheduler (library built with H264DEC_SCHEDULER).
+
+typedef struct {
+    const char *inputPath;
+    const char *yuvPath;
+    const char *md5Path;
+    int repeat;
+    int noOutputReordering;
+    int threads;            // scheduler pool threads, 0 to decode directly
+    int streams;            // concurrent streams decoded by the scheduler
+    int nalLengthSize;      // length field size of AVCC input, 0 for Annex B
+} bench_options;
+
+typedef struct {
+    double *latency;        // decode time of each output frame, seconds
+    size_t numFrames;
+    size_t capacity;
+    double pending;         // decode time since the previous output frame
+    H264SwDecStats decoder; // decoder statistics of the last run
+    FILE *yuvFile;
+    FILE *md5File;
+} bench_stats;
+
+/*------------------------------------ MD5 ---------------------------------*/
+// Straightforward RFC 1321 implementation, only used for -m output.
+
+typedef struct {
+    uint32_t state[4];
+    uint64_t length;
+    uint8_t buffer[64];
+} md5_context;
+
+static const uint32_t md5K[64] = {
+    0xd76aa478,0xe8c7b756,0x242070db,0xc1bdceee,0xf57c0faf,0x4787c62a,
+    0xa8304613,0xfd469501,0x698098d8,0x8b44f7af,0xffff5bb1,0x895cd7be,
+    0x6b901122,0xfd987193,0xa679438e,0x49b40821,0xf61e2562,0xc040b340,
+    0x265e5a51,0xe9b6c7aa,0xd62f105d,0x02441453,0xd8a1e681,0xe7d3fbc8,
+    0x21e1cde6,0xc33707d6,0xf4d50d87,0x455a14ed,0xa9e3e905,0xfcefa3f8,
+    0x676f02d9,0x8d2a4c8a,0xfffa3942,0x8771f681,0x6d9d6122,0xfde5380c,
+    0xa4beea44,0x4bdecfa9,0xf6bb4b60,0xbebfbc70,0x289b7ec6,0xeaa127fa,
+    0xd4ef3085,0x04881d05,0xd9d4d039,0xe6db99e5,0x1fa27cf8,0xc4ac5665,
+    0xf4292244,0x432aff97,0xab9423a7,0xfc93a039,0x655b59c3,0x8f0ccc92,
+    0xffeff47d,0x85845dd1,0x6fa87e4f,0xfe2ce6e0,0xa3014314,0x4e0811a1,
+    0xf7537e82,0xbd3af235,0x2ad7d2bb,0xeb86d391};
+
+static const uint8_t md5R[64] = {
+    7,12,17,22,7,12,17,22,7,12,17,22,7,12,17,22,
+    5, 9,14,20,5, 9,14,20,5, 9,14,20,5, 9,14,20,
+    4,11,16,23,4,11,16,23,4,11,16,23,4,11,16,23,
+    6,10,15,21,6,10,15,21,6,10,15,21,6,10,15,21};
+
+static void md5_block(md5_context *ctx, const uint8_t *block) {
+    uint32_t w[16];
+    uint32_t a = ctx->state[0], b = ctx->state[1];
+    uint32_t c = ctx->state[2], d = ctx->state[3];
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t) block[4 * i] | ((uint32_t) block[4 * i + 1] << 8) |
+               ((uint32_t) block[4 * i + 2] << 16) |
+               ((uint32_t) block[4 * i + 3] << 24);
+    }
+
+    for (int i = 0; i < 64; i++) {
+        uint32_t f, g;
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) & 15;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) & 15;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) & 15;
+        }
+        f += a + md5K[i] + w[g];
+        a = d;
+        d = c;
+        c = b;
+        b += (f << md5R[i]) | (f >> (32 - md5R[i]));
+    }
+
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+}
+
+static void md5_init(md5_context *ctx) {
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->length = 0;
+}
+
+static void md5_update(md5_context *ctx, const uint8_t *data, size_t len) {
+    size_t used = ctx->length & 63;
+
+    ctx->length += len;
+    if (used) {
+        size_t n = 64 - used < len ? 64 - used : len;
+        memcpy(ctx->buffer + used, data, n);
+        data += n;
+        len -= n;
+        if (used + n < 64) return;
+        md5_block(ctx, ctx->buffer);
+    }
+    for (; len >= 64; data += 64, len -= 64) {
+        md5_block(ctx, data);
+    }
+    memcpy(ctx->buffer, data, len);
+}
+
+static void md5_final(md5_context *ctx, uint8_t digest[16]) {
+    static const uint8_t padding[64] = {0x80};
+    uint64_t bits = ctx->length * 8;
+    uint8_t lengthBytes[8];
+    size_t used = ctx->length & 63;
+
+    for (int i = 0; i < 8; i++) {
+        lengthBytes[i] = (uint8_t) (bits >> (8 * i));
+    }
+    md5_update(ctx, padding, used < 56 ? 56 - used : 120 - used);
+    md5_update(ctx, lengthBytes, 8);
+    for (int i = 0; i < 16; i++) {
+        digest[i] = (uint8_t) (ctx->state[i >> 2] >> (8 * (i & 3)));
+    }
+}
+
+/*----------------------------------- Helpers ------------------------------*/
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t count, double p) {
+    if (!count) return 0.0;
+    size_t index = (size_t) (p * (double) (count - 1) + 0.5);
+    return sorted[index];
+}
+
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (length <= 0) {
+        fclose(f);
+        return NULL;
+    }
+
+    uint8_t *data = malloc((size_t) length);
+    if (data && fread(data, 1, (size_t) length, f) != (size_t) length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = (size_t) length;
+    return data;
+}
+
+/*-------------------------------- AVCC Input ------------------------------*/
+// Converts an Annex B stream to NAL units each preceded by a big-endian
+// length field of lengthSize bytes. Trailing zero bytes of the NAL units
+// are dropped. Returns NULL if a NAL unit is too long for the length field.
+static uint8_t *convert_to_avcc(const uint8_t *data, size_t size,
+                                int lengthSize, size_t *outSize) {
+    // a start code is at least 3 bytes, a length field at most 4
+    uint8_t *out = malloc(size + size / 3 + 4);
+    size_t pos = 0, start = 0;
+    int found = 0;
+
+    if (!out) return NULL;
+
+    for (size_t i = 0; i <= size; i++) {
+        int startCode = i + 2 < size && !data[i] && !data[i + 1] &&
+                        data[i + 2] == 1;
+        if (!startCode && i < size) continue;
+
+        if (found) {
+            size_t end = i;
+            while (end > start && !data[end - 1]) end--;
+            size_t length = end - start;
+            if (length >> (8 * lengthSize - 1) >> 1) {
+                free(out);
+                return NULL;
+            }
+            for (int b = lengthSize - 1; b >= 0; b--) {
+                out[pos++] = (uint8_t) (length >> (8 * b));
+            }
+            memcpy(out + pos, data + start, length);
+            pos += length;
+        }
+        if (startCode) {
+            found = 1;
+            start = i + 3;
+            i += 2;
+        }
+    }
+    *outSize = pos;
+    return out;
+}
+
+/*-------------------------------- Write Frame -----------------------------*/
+// Writes and hashes the cropped picture (frame cropping of the SPS), the
+// same output as the reference decoder. The decoder returns the whole
+// macroblock-aligned picture, e.g. 1088 lines for a 1080p stream.
+static void write_picture(bench_stats *stats, const uint8_t *yuv,
+                          const H264SwDecInfo *info) {
+    uint32_t width = info->picWidth, height = info->picHeight;
+    uint32_t left = 0, top = 0, cropWidth = width, cropHeight = height;
+    md5_context ctx;
+
+    if (!stats->yuvFile && !stats->md5File) return;
+    if (info->croppingFlag) {
+        left = info->cropParams.cropLeftOffset;
+        top = info->cropParams.cropTopOffset;
+        cropWidth = info->cropParams.cropOutWidth;
+        cropHeight = info->cropParams.cropOutHeight;
+    }
+
+    md5_init(&ctx);
+    for (int plane = 0; plane < 3; plane++) {
+        // chroma planes have half the size, crop offsets are even
+        uint32_t shift = plane ? 1 : 0;
+        uint32_t stride = width >> shift;
+        const uint8_t *row = yuv + (size_t) stride * (top >> shift) +
+                             (left >> shift);
+        for (uint32_t y = 0; y < cropHeight >> shift; y++) {
+            if (stats->yuvFile) {
+                fwrite(row, 1, cropWidth >> shift, stats->yuvFile);
+            }
+            md5_update(&ctx, row, cropWidth >> shift);
+            row += stride;
+        }
+        yuv += (size_t) stride * (height >> shift);
+    }
+    if (stats->md5File) {
+        uint8_t digest[16];
+        md5_final(&ctx, digest);
+        for (int i = 0; i < 16; i++) {
+            fprintf(stats->md5File, "%02x", digest[i]);
+        }
+        fputc('\n', stats->md5File);
+    }
+}
+
+/*------------------------------- Output Frames ----------------------------*/
+// Takes all pictures the decoder has ready, charges the decode time spent
+// since the previous output frame to the first of them.
+static int output_pictures(H264SwDecInst decInst, bench_stats *stats,
+                           int flush) {
+    H264SwDecPicture picture;
+    H264SwDecInfo info;
+
+    if (H264SwDecGetInfo(decInst, &info) != H264SWDEC_OK) return -1;
+
+    while (H264SwDecNextPicture(decInst, &picture, (u32) flush) ==
+           H264SWDEC_PIC_RDY) {
+        if (stats->numFrames == stats->capacity) {
+            size_t capacity = stats->capacity ? stats->capacity * 2 : 256;
+            double *latency = realloc(stats->latency,
+                                      capacity * sizeof(double));
+            if (!latency) return -1;
+            stats->latency = latency;
+            stats->capacity = capacity;
+        }
+        stats->latency[stats->numFrames++] = stats->pending;
+        stats->pending = 0.0;
+
+        write_picture(stats, (const uint8_t *) picture.pOutputPicture,
+                      &info);
+    }
+    return 0;
+}
+
+/*--------------------------------- Decode File ----------------------------*/
+// Decodes the whole stream once. The decoder removes emulation prevention
+// bytes in place, so it is given a private copy of the input.
+static int decode_stream(const uint8_t *data, size_t size, uint8_t *scratch,
+                         const bench_options *options, bench_stats *stats,
+                         H264SwDecInfo *info) {
+    H264SwDecInst decInst;
+    H264SwDecInput decInput;
+    H264SwDecOutput decOutput;
+    int result = 0;
+
+    memcpy(scratch, data, size);
+
+    if (H264SwDecInit(&decInst, (u32) options->noOutputReordering) !=
+        H264SWDEC_OK) {
+        fprintf(stderr, "h264bench: decoder init failed\n");
+        return -1;
+    }
+
+    memset(&decInput, 0, sizeof(decInput));
+    decInput.pStream = scratch;
+    decInput.dataLen = (u32) size;
+    decInput.nalLengthSize = (u32) options->nalLengthSize;
+
+    while (decInput.dataLen > 0 && result == 0) {
+        double start = now_seconds();
+        H264SwDecRet ret = H264SwDecDecode(decInst, &decInput, &decOutput);
+        stats->pending += now_seconds() - start;
+
+        switch (ret) {
+            case H264SWDEC_HDRS_RDY_BUFF_NOT_EMPTY:
+                H264SwDecGetInfo(decInst, info);
+                break;
+            case H264SWDEC_PIC_RDY:
+            case H264SWDEC_PIC_RDY_BUFF_NOT_EMPTY:
+                result = output_pictures(decInst, stats, 0);
+                break;
+            case H264SWDEC_STRM_PROCESSED:
+            case H264SWDEC_STRM_ERR:
+            case H264SWDEC_OK:
+                break;
+            default:
+                fprintf(stderr, "h264bench: decoding failed (%d)\n", ret);
+                result = -1;
+                break;
+        }
+
+        decInput.dataLen -= (u32) (decOutput.pStrmCurrPos - decInput.pStream);
+        decInput.pStream = decOutput.pStrmCurrPos;
+        decInput.picId++;
+    }
+
+    if (result == 0) {
+        result = output_pictures(decInst, stats, 1);
+    }
+
+    H264SwDecGetStats(decInst, &stats->decoder);
+    H264SwDecRelease(decInst);
+    return result;
+}
+
+#ifdef H264DEC_SCHEDULER
+/*---------------------------- Split Access Units --------------------------*/
+// Start offsets of the access units of an Annex B stream, followed by the
+// stream size. An access unit starts at a non-VCL NAL unit (SEI, parameter
+// sets, delimiter) or a slice with first_mb_in_slice 0 following a slice.
+static size_t *split_access_units(const uint8_t *data, size_t size,
+                                  size_t *count) {
+    size_t *offsets = malloc((size / 3 + 2) * sizeof(size_t));
+    int slice = 0;
+
+    if (!offsets) return NULL;
+
+    *count = 0;
+    offsets[(*count)++] = 0;
+    for (size_t i = 0; i + 4 < size; i++) {
+        if (data[i] || data[i + 1] || data[i + 2] != 1) continue;
+
+        unsigned type = data[i + 3] & 0x1f;
+        if (type == 1 || type == 5) {
+            // first_mb_in_slice is 0 if the first bit of the slice is set
+            if (slice && (data[i + 4] & 0x80)) {
+                offsets[(*count)++] = i;
+            }
+            slice = 1;
+        } else if (type >= 6 && type <= 9) {
+            if (slice) {
+                offsets[(*count)++] = i;
+            }
+            slice = 0;
+        }
+        i += 2;
+    }
+    offsets[*count] = size;
+    return offsets;
+}
+
+/*------------------------------ Scheduled Streams -------------------------*/
+typedef struct {
+    H264SwDecInst decInst;
+    H264SwDecStreamInst streamInst;
+    uint8_t *data;          // private copy of the input
+    bench_stats *stats;     // frames written out, first stream only
+    size_t numFrames;
+    size_t numInputs;       // access units not yet decoded
+    double finish;          // time the last access unit was decoded
+} bench_stream;
+
+// Scheduler callbacks, called on the pool thread decoding the stream
+static void stream_picture(void *userData, H264SwDecPicture *picture) {
+    bench_stream *stream = userData;
+    H264SwDecInfo info;
+
+    stream->numFrames++;
+    if (stream->stats &&
+        H264SwDecGetInfo(stream->decInst, &info) == H264SWDEC_OK) {
+        write_picture(stream->stats,
+                      (const uint8_t *) picture->pOutputPicture, &info);
+    }
+}
+
+static void stream_input_done(void *userData, H264SwDecInput *input,
+                              H264SwDecRet result) {
+    bench_stream *stream = userData;
+
+    (void) input;
+    (void) result;
+    if (--stream->numInputs == 0) {
+        stream->finish = now_seconds();
+    }
+}
+
+/*-------------------------------- Decode Streams --------------------------*/
+// Decodes options->streams copies of the stream concurrently on the
+// scheduler, the access units are submitted to the streams in turns. The
+// first stream has the highest priority, its frames are written out and
+// its finishing time is returned in priorityTime, that of the last stream
+// to finish in lastTime.
+static int decode_streams(const uint8_t *data, size_t size,
+                          const bench_options *options, bench_stats *stats,
+                          H264SwDecInfo *info, size_t *numFrames,
+                          double *priorityTime, double *lastTime) {
+    H264SwDecSchedInst sched;
+    bench_stream *streams;
+    size_t numUnits = 0;
+    size_t *units = split_access_units(data, size, &numUnits);
+    int result = 0;
+
+    streams = calloc((size_t) options->streams, sizeof(bench_stream));
+    if (!units || !streams ||
+        H264SwDecSchedInit(&sched, (u32) options->threads) != H264SWDEC_OK) {
+        fprintf(stderr, "h264bench: scheduler init failed\n");
+        free(streams);
+        free(units);
+        return -1;
+    }
+
+    for (int s = 0; s < options->streams && result == 0; s++) {
+        bench_stream *stream = &streams[s];
+        H264SwDecStreamCallbacks callbacks = {stream_picture,
+                                              stream_input_done, stream};
+
+        stream->data = malloc(size);
+        if (!stream->data ||
+            H264SwDecInit(&stream->decInst,
+                          (u32) options->noOutputReordering) !=
+                H264SWDEC_OK ||
+            H264SwDecSchedAddStream(sched, stream->decInst, s == 0 ? 1 : 0,
+                                    &callbacks, &stream->streamInst) !=
+                H264SWDEC_OK) {
+            fprintf(stderr, "h264bench: stream init failed\n");
+            result = -1;
+            break;
+        }
+        memcpy(stream->data, data, size);
+        stream->stats = s == 0 ? stats : NULL;
+        stream->numInputs = numUnits;
+    }
+
+    double start = now_seconds();
+    for (size_t k = 0; k < numUnits && result == 0; k++) {
+        for (int s = 0; s < options->streams; s++) {
+            H264SwDecInput input;
+
+            memset(&input, 0, sizeof(input));
+            input.pStream = streams[s].data + units[k];
+            input.dataLen = (u32) (units[k + 1] - units[k]);
+            input.picId = (u32) k;
+            if (H264SwDecSchedSubmit(streams[s].streamInst, &input) !=
+                H264SWDEC_OK) {
+                fprintf(stderr, "h264bench: submit failed\n");
+                result = -1;
+                break;
+            }
+        }
+    }
+
+    *numFrames = 0;
+    *priorityTime = *lastTime = 0.0;
+    for (int s = 0; s < options->streams; s++) {
+        bench_stream *stream = &streams[s];
+
+        if (stream->streamInst) {
+            H264SwDecSchedFlush(stream->streamInst, 1);
+            H264SwDecSchedRemoveStream(stream->streamInst);
+        }
+        if (stream->finish > start && stream->finish - start > *lastTime) {
+            *lastTime = stream->finish - start;
+        }
+        *numFrames += stream->numFrames;
+    }
+    if (streams[0].finish > start) {
+        *priorityTime = streams[0].finish - start;
+    }
+    if (streams[0].decInst) {
+        H264SwDecGetInfo(streams[0].decInst, info);
+        H264SwDecGetStats(streams[0].decInst, &stats->decoder);
+    }
+
+    for (int s = 0; s < options->streams; s++) {
+        if (streams[s].decInst) {
+            H264SwDecRelease(streams[s].decInst);
+        }
+        free(streams[s].data);
+    }
+    H264SwDecSchedRelease(sched);
+    free(streams);
+    free(units);
+    return result;
+}
+#endif
+
+/*------------------------------ Print Statistics --------------------------*/
+// Per-stage breakdown, only available when the decoder library was built
+// with H264DEC_STATS.
+static void print_decoder_stats(const H264SwDecStats *s) {
+    const struct {
+        const char *name;
+        u64 time;
+    } stages[] = {
+        {"nal extract", s->nalExtractTime},
+        {"slice header", s->sliceHeaderTime},
+        {"mb layer", s->mbLayerTime},
+        {"intra mb", s->intraMbTime},
+        {"inter mb", s->interMbTime},
+        {"deblocking", s->deblockTime},
+        {"concealment", s->concealTime},
+        {"dpb", s->dpbTime},
+        {"output", s->outputTime},
+        {"thread sync", s->syncTime},
+    };
+    double total = 0.0;
+
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+        total += (double) stages[i].time;
+    }
+
+    printf("stages      (last run)\n");
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+        printf("  %-12s %9.3f ms %5.1f%%\n", stages[i].name,
+               1e-6 * (double) stages[i].time,
+               total > 0.0 ? 100.0 * (double) stages[i].time / total : 0.0);
+    }
+    printf("nal units   %u, %llu bytes\n", s->numNalUnits,
+           (unsigned long long) s->numBytes);
+    printf("slices      %u in %u pictures\n", s->numSlices, s->numPictures);
+    printf("macroblocks intra %u  pcm %u  inter %u  skipped %u  concealed %u\n",
+           s->numIntraMbs, s->numPcmMbs, s->numInterMbs, s->numSkippedMbs,
+           s->numConcealedMbs);
+}
+
+/*------------------------------------ Main --------------------------------*/
+static void usage(void) {
+    fprintf(stderr,
+            "usage: h264bench [options] <input.264>\n"
+            "  -o <file>  write decoded frames as raw YUV 4:2:0, cropped\n"
+            "  -m <file>  write MD5 of each cropped frame, one per line\n"
+            "  -r <n>     decode the stream n times (default 1)\n"
+            "  -d         disable output reordering\n"
+            "  -a <n>     decode as NAL units with n-byte length fields\n"
+            "             (AVCC, n is 1, 2 or 4) instead of Annex B,\n"
+            "             not with -j\n"
+            "  -j <n>     decode on the multi-stream scheduler with n threads\n"
+            "  -s <n>     number of concurrent streams with -j (default 1),\n"
+            "             the first one has priority, only its frames are\n"
+            "             written out\n");
+}
+
+int main(int argc, char **argv) {
+    bench_options options = {NULL, NULL, NULL, 1, 0, 0, 1, 0};
+    bench_stats stats;
+    H264SwDecInfo info;
+    struct rusage usage_info;
+    size_t size = 0;
+    size_t numFrames = 0;
+    double priorityTime = 0.0, lastTime = 0.0;
+    int result = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            options.yuvPath = argv[++i];
+        } else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+            options.md5Path = argv[++i];
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            options.repeat = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-d")) {
+            options.noOutputReordering = 1;
+        } else if (!strcmp(argv[i], "-a") && i + 1 < argc) {
+            options.nalLengthSize = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            options.streams = atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && !options.inputPath) {
+            options.inputPath = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!options.inputPath || options.repeat < 1 || options.threads < 0 ||
+        options.streams < 1 ||
+        (options.nalLengthSize && ((options.nalLengthSize != 1 &&
+                                    options.nalLengthSize != 2 &&
+                                    options.nalLengthSize != 4) ||
+                                   options.threads))) {
+        usage();
+        return 2;
+    }
+#ifndef H264DEC_SCHEDULER
+    if (options.threads) {
+        fprintf(stderr, "h264bench: built without H264DEC_SCHEDULER\n");
+        return 2;
+    }
+#endif
+
+    uint8_t *data = read_file(options.inputPath, &size);
+    if (data && options.nalLengthSize) {
+        uint8_t *avcc = convert_to_avcc(data, size, options.nalLengthSize,
+                                        &size);
+        free(data);
+        data = avcc;
+        if (!data) {
+            fprintf(stderr, "h264bench: cannot convert %s to -a %d\n",
+                    options.inputPath, options.nalLengthSize);
+            return 1;
+        }
+    }
+    uint8_t *scratch = data ? malloc(size) : NULL;
+    if (!scratch) {
+        fprintf(stderr, "h264bench: cannot read %s\n", options.inputPath);
+        free(data);
+        return 1;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    memset(&info, 0, sizeof(info));
+    if (options.yuvPath) stats.yuvFile = fopen(options.yuvPath, "wb");
+    if (options.md5Path) stats.md5File = fopen(options.md5Path, "w");
+    if ((options.yuvPath && !stats.yuvFile) ||
+        (options.md5Path && !stats.md5File)) {
+        fprintf(stderr, "h264bench: cannot open output file\n");
+        result = 1;
+    }
+
+    double start = now_seconds();
+    for (int r = 0; r < options.repeat && result == 0; r++) {
+#ifdef H264DEC_SCHEDULER
+        if (options.threads) {
+            size_t runFrames = 0;
+            if (decode_streams(data, size, &options, &stats, &info,
+                               &runFrames, &priorityTime, &lastTime)) {
+                result = 1;
+            }
+            numFrames += runFrames;
+        } else
+#endif
+        if (decode_stream(data, size, scratch, &options, &stats, &info)) {
+            result = 1;
+        }
+        // frames are written out only once
+        if (stats.yuvFile) {
+            fclose(stats.yuvFile);
+            stats.yuvFile = NULL;
+        }
+        if (stats.md5File) {
+            fclose(stats.md5File);
+            stats.md5File = NULL;
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    getrusage(RUSAGE_SELF, &usage_info);
+    qsort(stats.latency, stats.numFrames, sizeof(double), compare_double);
+    if (!options.threads) {
+        numFrames = stats.numFrames;
+        options.streams = 1;
+    }
+
+    printf("input       %s (%zu bytes)\n", options.inputPath, size);
+    printf("resolution  %ux%u\n", info.picWidth, info.picHeight);
+    if (options.threads) {
+        printf("streams     %d on %d thread%s\n", options.streams,
+               options.threads, options.threads == 1 ? "" : "s");
+    }
+    printf("frames      %zu (%d run%s)\n", numFrames, options.repeat,
+           options.repeat == 1 ? "" : "s");
+    printf("time        %.3f s\n", elapsed);
+    printf("fps         %.1f\n",
+           elapsed > 0.0 ? (double) numFrames / elapsed : 0.0);
+    printf("input rate  %.1f Mbit/s\n",
+           elapsed > 0.0 ? 8e-6 * (double) size * options.repeat *
+                           options.streams / elapsed
+                         : 0.0);
+    if (options.threads) {
+        printf("finish ms   priority stream %.3f  last stream %.3f "
+               "(last run)\n", 1e3 * priorityTime, 1e3 * lastTime);
+    } else {
+        printf("latency ms  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+               1e3 * percentile(stats.latency, stats.numFrames, 0.50),
+               1e3 * percentile(stats.latency, stats.numFrames, 0.90),
+               1e3 * percentile(stats.latency, stats.numFrames, 0.99),
+               1e3 * percentile(stats.latency, stats.numFrames, 1.00));
+    }
+    printf("peak RSS    %ld KiB\n", usage_info.ru_maxrss);
+    if (stats.decoder.enabled) {
+        print_decoder_stats(&stats.decoder);
+    }
+
+    if (stats.yuvFile) fclose(stats.yuvFile);
+    if (stats.md5File) fclose(stats.md5File);
+    free(stats.latency);
+    free(scratch);
+    free(data);
+    return result;
+}
@@ -0,0 +1,217 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "h264bsd_vlc.h"
+#include "h264bsd_util.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Exp-Golomb benchmark, native and WebAssembly (run with node). Decodes a
+// synthetic stream of ue(v) code words and reports code words per second
+// for:
+//   reference   the original decoder testing the code length one leading
+//               bit at a time (copied below, before the count of leading
+//               zeros over a 64-bit read)
+//   decoder     h264bsdDecodeExpGolombUnsigned
+// The code numbers follow a geometric distribution of the code length, as
+// mb_skip_run, mb_type, mvd and the other ue(v)/se(v) elements mostly are
+// short. Every 4096th code word is 59 to 63 bits long to exercise the long
+// code path. Both decoders have to return the encoded code numbers.
+
+typedef struct {
+    size_t numCodes;
+    int repeat;
+} bench_options;
+
+/*--------------------------- reference decoder ----------------------------*/
+
+static __attribute__((noinline)) u32 ref_decode_ue(strmData_t *pStrmData,
+                                                   u32 *codeNum) {
+    u32 bits, numZeros;
+
+    bits = h264bsdShowBits32(pStrmData);
+
+    if (bits >= 0x80000000) {
+        h264bsdFlushBits(pStrmData, 1);
+        *codeNum = 0;
+        return HANTRO_OK;
+    } else if (bits >= 0x40000000) {
+        if (h264bsdFlushBits(pStrmData, 3) == END_OF_STREAM) return HANTRO_NOK;
+        *codeNum = 1 + ((bits >> 29) & 0x1);
+        return HANTRO_OK;
+    } else if (bits >= 0x20000000) {
+        if (h264bsdFlushBits(pStrmData, 5) == END_OF_STREAM) return HANTRO_NOK;
+        *codeNum = 3 + ((bits >> 27) & 0x3);
+        return HANTRO_OK;
+    } else if (bits >= 0x10000000) {
+        if (h264bsdFlushBits(pStrmData, 7) == END_OF_STREAM) return HANTRO_NOK;
+        *codeNum = 7 + ((bits >> 25) & 0x7);
+        return HANTRO_OK;
+    }
+
+    numZeros = 4 + h264bsdCountLeadingZeros(bits, 28);
+    // longer code words do not occur in the benchmark stream
+    if (numZeros == 32) return HANTRO_NOK;
+    h264bsdFlushBits(pStrmData, numZeros + 1);
+    bits = h264bsdGetBits(pStrmData, numZeros);
+    if (bits == END_OF_STREAM) return HANTRO_NOK;
+    *codeNum = (1U << numZeros) - 1 + bits;
+    return HANTRO_OK;
+}
+
+/*--------------------------------- stream ---------------------------------*/
+
+typedef struct {
+    u8 *data;
+    size_t pos;             // number of bits written
+} bit_writer;
+
+static void put_bits(bit_writer *writer, uint64_t value, u32 numBits) {
+    while (numBits--) {
+        if ((value >> numBits) & 1) {
+            writer->data[writer->pos >> 3] |= (u8) (0x80 >> (writer->pos & 7));
+        }
+        writer->pos++;
+    }
+}
+
+static uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Code numbers of the benchmark stream, code length 2 * numZeros + 1 where
+// numZeros is geometric, capped at 16, or 29 to 31 for every 4096th one
+static void make_codes(u32 *codes, size_t numCodes) {
+    uint32_t seed = 0x2545f491;
+
+    for (size_t i = 0; i < numCodes; i++) {
+        u32 numZeros;
+        if ((i & 4095) == 4095) {
+            numZeros = 29 + xorshift32(&seed) % 3;
+        } else {
+            u32 r = xorshift32(&seed) | 0x10000;
+            numZeros = (u32) __builtin_ctz(r);
+        }
+        u32 suffix = numZeros ? xorshift32(&seed) >> (32 - numZeros) : 0;
+        codes[i] = (u32) ((1ULL << numZeros) - 1 + suffix);
+    }
+}
+
+/*--------------------------------- driver ---------------------------------*/
+
+typedef u32 (*decoder_func)(strmData_t *, u32 *);
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// Decode numCodes code words, returns the number of decoded code numbers
+// differing from the encoded ones
+static size_t decode_all(decoder_func decode, u8 *data, size_t size,
+                         const u32 *codes, size_t numCodes) {
+    strmData_t strm;
+    size_t errors = 0;
+
+    strm.pStrmBuffStart = strm.pStrmCurrPos = data;
+    strm.bitPosInWord = 0;
+    strm.strmBuffSize = (u32) size;
+    strm.strmBuffReadBits = 0;
+    for (size_t i = 0; i < numCodes; i++) {
+        u32 codeNum;
+        if (decode(&strm, &codeNum) != HANTRO_OK || codeNum != codes[i]) {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: h264uebench [options]\n"
+            "  -n <count>  number of code words (default 4000000)\n"
+            "  -r <count>  decode the stream count times (default 20)\n");
+}
+
+int main(int argc, char **argv) {
+    static const struct {
+        const char *name;
+        decoder_func decode;
+    } decoders[] = {
+        {"reference", ref_decode_ue},
+        {"decoder", h264bsdDecodeExpGolombUnsigned},
+    };
+    bench_options options = {4000000, 20};
+    bit_writer writer;
+    int result = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            options.numCodes = (size_t) atol(argv[++i]);
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            options.repeat = atoi(argv[++i]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (options.numCodes < 1 || options.repeat < 1) {
+        usage();
+        return 2;
+    }
+
+    // at most 63 bits per code word, rbsp_stop_one_bit and zero padding
+    size_t size = (options.numCodes * 63 + 7) / 8 + 8;
+    u32 *codes = malloc(options.numCodes * sizeof(u32));
+    writer.data = calloc(size, 1);
+    if (!codes || !writer.data) {
+        fprintf(stderr, "h264uebench: out of memory\n");
+        free(codes);
+        free(writer.data);
+        return 1;
+    }
+    make_codes(codes, options.numCodes);
+    writer.pos = 0;
+    for (size_t i = 0; i < options.numCodes; i++) {
+        uint64_t value = (uint64_t) codes[i] + 1;
+        u32 numZeros = 63 - (u32) __builtin_clzll(value);
+        put_bits(&writer, value, 2 * numZeros + 1);
+    }
+    size_t numBits = writer.pos;
+    put_bits(&writer, 1, 1);
+    size = (writer.pos + 7) / 8;
+
+    printf("stream      %zu code words, %.2f bits/code word, %d passes\n",
+           options.numCodes, (double) numBits / (double) options.numCodes,
+           options.repeat);
+    for (size_t d = 0; d < sizeof(decoders) / sizeof(decoders[0]); d++) {
+        size_t errors = 0;
+        double start = now_seconds();
+        for (int pass = 0; pass < options.repeat; pass++) {
+            errors += decode_all(decoders[d].decode, writer.data, size, codes,
+                                 options.numCodes);
+        }
+        double seconds = now_seconds() - start;
+        if (seconds <= 0) seconds = 1e-9;
+
+        if (errors) {
+            fprintf(stderr, "h264uebench: %s decoded %zu code words wrong\n",
+                    decoders[d].name, errors);
+            result = 1;
+        }
+        printf("%-11s %8.1f Mcode/s  %8.1f Mbit/s\n", decoders[d].name,
+               (double) options.numCodes * options.repeat / seconds * 1e-6,
+               (double) numBits * options.repeat / seconds * 1e-6);
+    }
+
+    free(codes);
+    free(writer.data);
+    return result;
+}
@@ -4,97 +4,257 @@
 #include <string.h>
 #include <emscripten/emscripten.h>
 
-// Decoder state
-static H264SwDecInst decInst = NULL;
-static H264SwDecInput decInput;
-static H264SwDecOutput decOutput;
-static H264SwDecPicture decPicture;
-static H264SwDecInfo decInfo;
+#ifdef H264DEC_SCHEDULER
+#include "H264SwDecScheduler.h"
+#include <pthread.h>
+#endif
 
-// Picture callback pointer (JS registers this)
-static void (*pictureCallback)(uint8_t *yuv, int width, int height) = NULL;
+typedef void (*h264_picture_cb)(uint8_t *yuv, int width, int height);
 
-// Stream buffer for accumulating incomplete NAL units
-static uint8_t *streamBuffer = NULL;
-static size_t streamBufferSize = 0;
-static size_t streamBufferCapacity = 0;
+// Metadata of an output frame. Passed by pointer to the frame callback, the
+// structure lives in the decoder instance and is valid during the callback.
+// All fields are 32-bit so JS can read them with HEAPU32/HEAP32.
+typedef struct {
+    uint32_t width;         // decoded size in pixels, multiple of 16
+    uint32_t height;
+    uint32_t cropLeft;      // visible rectangle inside the decoded frame
+    uint32_t cropTop;
+    uint32_t cropWidth;
+    uint32_t cropHeight;
+    uint32_t picId;         // decode order number of the picture
+    uint32_t isIdr;
+    uint32_t numErrMbs;     // concealed macroblocks, 0 for an intact frame
+    int32_t picOrderCnt;    // display order, restarts at each IDR
+} h264_frame_info;
+
+typedef void (*h264_frame_cb)(uint8_t *yuv, const h264_frame_info *info);
+
+// Decoder instance, one per stream. All instances share the module heap.
+typedef struct {
+    H264SwDecInst decInst;
+    H264SwDecInput decInput;
+    H264SwDecOutput decOutput;
+    H264SwDecPicture decPicture;
+    H264SwDecInfo decInfo;
+    H264SwDecStats decStats;
+
+    // Picture callback pointers (JS registers these)
+    h264_picture_cb pictureCallback;
+    h264_frame_cb frameCallback;
+    h264_frame_info frameInfo;
+
+    // Stream buffer for accumulating incomplete NAL units. Bytes in
+    // [streamBufferPos, streamBufferEnd) are pending, the decoder consumes
+    // them by advancing streamBufferPos and new data is appended at
+    // streamBufferEnd.
+    uint8_t *streamBuffer;
+    size_t streamBufferPos;
+    size_t streamBufferEnd;
+    size_t streamBufferCapacity;
+} h264_decoder;
+
+// Instance used by the legacy single-stream API (h264_init etc.)
+static h264_decoder *defaultDecoder = NULL;
+static h264_picture_cb defaultCallback = NULL;
+static h264_frame_cb defaultFrameCallback = NULL;
 
 #define INITIAL_BUFFER_CAPACITY (512 * 1024)  // 512KB initial capacity
 
-/*----------------------------- Initialization -----------------------------*/
+/*------------------------------ Create Decoder ----------------------------*/
 EMSCRIPTEN_KEEPALIVE
-int h264_init(int noOutputReordering) {
-    if (decInst) return 0; // already initialized
+h264_decoder *h264_create(int noOutputReordering) {
+    h264_decoder *dec = calloc(1, sizeof(h264_decoder));
+    if (!dec) return NULL;
 
-    H264SwDecRet ret = H264SwDecInit(&decInst, (u32) noOutputReordering);
-    if (ret != H264SWDEC_OK) return -1;
+    H264SwDecRet ret = H264SwDecInit(&dec->decInst, (u32) noOutputReordering);
+    if (ret != H264SWDEC_OK) {
+        free(dec);
+        return NULL;
+    }
 
     // Initialize stream buffer
-    streamBufferCapacity = INITIAL_BUFFER_CAPACITY;
-    streamBuffer = malloc(streamBufferCapacity);
-    if (!streamBuffer) {
-        H264SwDecRelease(decInst);
-        decInst = NULL;
-        return -1;
+    dec->streamBufferCapacity = INITIAL_BUFFER_CAPACITY;
+    dec->streamBuffer = malloc(dec->streamBufferCapacity);
+    if (!dec->streamBuffer) {
+        H264SwDecRelease(dec->decInst);
+        free(dec);
+        return NULL;
     }
-    streamBufferSize = 0;
+    dec->streamBufferPos = 0;
+    dec->streamBufferEnd = 0;
 
-    return 0;
+    return dec;
+}
+
+/*------------------------------ Destroy Decoder ---------------------------*/
+EMSCRIPTEN_KEEPALIVE
+void h264_destroy(h264_decoder *dec) {
+    if (!dec) return;
+
+    if (dec->decInst) {
+        H264SwDecRelease(dec->decInst);
+    }
+    free(dec->streamBuffer);
+    free(dec);
 }
 
 /*---------------------------- Set Picture Callback ------------------------*/
 EMSCRIPTEN_KEEPALIVE
-void h264_set_callback(void (*cb)(uint8_t *yuv, int width, int height)) {
-    pictureCallback = cb;
+void h264_decoder_set_callback(h264_decoder *dec, h264_picture_cb cb) {
+    if (!dec) return;
+    dec->pictureCallback = cb;
+}
+
+/*----------------------------- Set Frame Callback -------------------------*/
+// The frame callback receives the frame metadata along with the picture and
+// is called instead of the picture callback when both are set.
+EMSCRIPTEN_KEEPALIVE
+void h264_decoder_set_frame_callback(h264_decoder *dec, h264_frame_cb cb) {
+    if (!dec) return;
+    dec->frameCallback = cb;
+}
+
+/*------------------------- Remove Consumed Bytes --------------------------*/
+static void consume_bytes(h264_decoder *dec, size_t bytesConsumed) {
+    if (bytesConsumed > 0 &&
+        bytesConsumed <= dec->streamBufferEnd - dec->streamBufferPos) {
+        dec->streamBufferPos += bytesConsumed;
+
+        // Rewind for free once everything has been consumed
+        if (dec->streamBufferPos == dec->streamBufferEnd) {
+            dec->streamBufferPos = 0;
+            dec->streamBufferEnd = 0;
+        }
+    }
+}
+
+/*------------------------- Reserve Input Space ----------------------------*/
+// Make room for length bytes at the write cursor. Pending bytes are moved
+// to the front only when the tail of the buffer runs out.
+static uint8_t *reserve_input(h264_decoder *dec, size_t length) {
+    if (dec->streamBufferEnd + length > dec->streamBufferCapacity) {
+        size_t pending = dec->streamBufferEnd - dec->streamBufferPos;
+
+        if (dec->streamBufferPos > 0) {
+            memmove(dec->streamBuffer, dec->streamBuffer + dec->streamBufferPos,
+                    pending);
+            dec->streamBufferPos = 0;
+            dec->streamBufferEnd = pending;
+        }
+
+        if (pending + length > dec->streamBufferCapacity) {
+            size_t newCapacity = dec->streamBufferCapacity;
+            while (newCapacity < pending + length) {
+                newCapacity *= 2;
+            }
+            uint8_t *newBuffer = realloc(dec->streamBuffer, newCapacity);
+            if (!newBuffer) {
+                return NULL; // Out of memory
+            }
+            dec->streamBuffer = newBuffer;
+            dec->streamBufferCapacity = newCapacity;
+        }
+    }
+
+    return dec->streamBuffer + dec->streamBufferEnd;
+}
+
+/*---------------------------- Get Input Buffer ----------------------------*/
+// Returns a region of at least size bytes inside the stream buffer. JS may
+// write the next chunk there and pass the same pointer to
+// h264_decoder_decode, which then skips the copy. The pointer is valid until
+// the next call into the decoder.
+EMSCRIPTEN_KEEPALIVE
+uint8_t *h264_decoder_get_input_buffer(h264_decoder *dec, size_t size) {
+    if (!dec || size == 0) return NULL;
+    return reserve_input(dec, size);
+}
+
+/*---------------------------- Fill Frame Metadata -------------------------*/
+static void fill_frame_info(h264_decoder *dec) {
+    h264_frame_info *info = &dec->frameInfo;
+
+    info->width = dec->decInfo.picWidth;
+    info->height = dec->decInfo.picHeight;
+    if (dec->decInfo.croppingFlag) {
+        info->cropLeft = dec->decInfo.cropParams.cropLeftOffset;
+        info->cropTop = dec->decInfo.cropParams.cropTopOffset;
+        info->cropWidth = dec->decInfo.cropParams.cropOutWidth;
+        info->cropHeight = dec->decInfo.cropParams.cropOutHeight;
+    } else {
+        info->cropLeft = 0;
+        info->cropTop = 0;
+        info->cropWidth = dec->decInfo.picWidth;
+        info->cropHeight = dec->decInfo.picHeight;
+    }
+    info->picId = dec->decPicture.picId;
+    info->isIdr = dec->decPicture.isIdrPicture;
+    info->numErrMbs = dec->decPicture.nbrOfErrMBs;
+    info->picOrderCnt = dec->decPicture.picOrderCnt;
+}
+
+/*--------------------------- Output Ready Pictures ------------------------*/
+static void output_pictures(h264_decoder *dec) {
+    while (H264SwDecNextPicture(dec->decInst, &dec->decPicture, 0) ==
+           H264SWDEC_PIC_RDY) {
+        if (!dec->decPicture.pOutputPicture) continue;
+
+        if (dec->frameCallback) {
+            fill_frame_info(dec);
+            dec->frameCallback((uint8_t *) dec->decPicture.pOutputPicture,
+                               &dec->frameInfo);
+        } else if (dec->pictureCallback) {
+            dec->pictureCallback((uint8_t *) dec->decPicture.pOutputPicture,
+                                 (int) dec->decInfo.picWidth,
+                                 (int) dec->decInfo.picHeight);
+        }
+    }
 }
 
 /*---------------------------- Decode H.264 Buffer ------------------------*/
 EMSCRIPTEN_KEEPALIVE
-int h264_decode(uint8_t *buffer, size_t length) {
-    if (!decInst || !buffer || length == 0) return -1;
+int h264_decoder_decode(h264_decoder *dec, uint8_t *buffer, size_t length) {
+    if (!dec || !dec->decInst || !buffer || length == 0) return -1;
 
-    // Ensure we have enough capacity in the buffer
-    if (streamBufferSize + length > streamBufferCapacity) {
-        size_t newCapacity = streamBufferCapacity;
-        while (newCapacity < streamBufferSize + length) {
-            newCapacity *= 2;
+    if (buffer == dec->streamBuffer + dec->streamBufferEnd) {
+        // Data was written in place through h264_decoder_get_input_buffer
+        if (dec->streamBufferEnd + length > dec->streamBufferCapacity) {
+            return -1;
         }
-        uint8_t *newBuffer = realloc(streamBuffer, newCapacity);
-        if (!newBuffer) {
+    } else {
+        // Append new data to the buffer
+        uint8_t *dst = reserve_input(dec, length);
+        if (!dst) {
             return -1; // Out of memory
         }
-        streamBuffer = newBuffer;
-        streamBufferCapacity = newCapacity;
+        memcpy(dst, buffer, length);
     }
+    dec->streamBufferEnd += length;
 
-    // Append new data to the buffer
-    memcpy(streamBuffer + streamBufferSize, buffer, length);
-    streamBufferSize += length;
-    
-    while (streamBufferSize > 0) {
-        decInput.pStream = streamBuffer;
-        decInput.dataLen = streamBufferSize;
-        decInput.intraConcealmentMethod = 0; // gray concealment
+    while (dec->streamBufferPos < dec->streamBufferEnd) {
+        uint8_t *readPtr = dec->streamBuffer + dec->streamBufferPos;
 
-        H264SwDecRet ret = H264SwDecDecode(decInst, &decInput, &decOutput);
+        dec->decInput.pStream = readPtr;
+        dec->decInput.dataLen = dec->streamBufferEnd - dec->streamBufferPos;
+        dec->decInput.intraConcealmentMethod = 0; // gray concealment
+
+        H264SwDecRet ret = H264SwDecDecode(dec->decInst, &dec->decInput,
+                                           &dec->decOutput);
 
         // Calculate how many bytes were consumed
         size_t bytesConsumed = 0;
-        if (decOutput.pStrmCurrPos && decOutput.pStrmCurrPos >= streamBuffer) {
-            bytesConsumed = decOutput.pStrmCurrPos - streamBuffer;
+        if (dec->decOutput.pStrmCurrPos &&
+            dec->decOutput.pStrmCurrPos >= readPtr) {
+            bytesConsumed = dec->decOutput.pStrmCurrPos - readPtr;
         }
 
         switch (ret) {
             // Headers ready
             case H264SWDEC_HDRS_RDY_BUFF_NOT_EMPTY: {
-                H264SwDecGetInfo(decInst, &decInfo);  // query video info
+                H264SwDecGetInfo(dec->decInst, &dec->decInfo);  // query video info
 
                 // Remove consumed bytes from buffer
-                if (bytesConsumed > 0 && bytesConsumed <= streamBufferSize) {
-                    memmove(streamBuffer, streamBuffer + bytesConsumed, 
-                            streamBufferSize - bytesConsumed);
-                    streamBufferSize -= bytesConsumed;
-                }
+                consume_bytes(dec, bytesConsumed);
                 // Continue processing remaining data
                 continue;
             }
@@ -102,22 +262,15 @@ int h264_decode(uint8_t *buffer, size_t length) {
             // Picture(s) ready
             case H264SWDEC_PIC_RDY:
             case H264SWDEC_PIC_RDY_BUFF_NOT_EMPTY: {
+                // Next picture gets the next decode order number
+                dec->decInput.picId++;
+
                 // Output all ready pictures
-                while (H264SwDecNextPicture(decInst, &decPicture, 0) == H264SWDEC_PIC_RDY) {
-                    if (pictureCallback && decPicture.pOutputPicture) {
-                        pictureCallback((uint8_t *) decPicture.pOutputPicture,
-                                        (int) decInfo.picWidth,
-                                        (int) decInfo.picHeight);
-                    }
-                }
+                output_pictures(dec);
 
                 // Remove consumed bytes from buffer
-                if (bytesConsumed > 0 && bytesConsumed <= streamBufferSize) {
-                    memmove(streamBuffer, streamBuffer + bytesConsumed, 
-                            streamBufferSize - bytesConsumed);
-                    streamBufferSize -= bytesConsumed;
-                }
-                
+                consume_bytes(dec, bytesConsumed);
+
                 // Continue processing if buffer not empty
                 if (ret == H264SWDEC_PIC_RDY_BUFF_NOT_EMPTY) {
                     continue;
@@ -129,29 +282,23 @@ int h264_decode(uint8_t *buffer, size_t length) {
             case H264SWDEC_STRM_PROCESSED: {
                 // All current data processed, need more data
                 // Remove consumed bytes from buffer
-                if (bytesConsumed > 0 && bytesConsumed <= streamBufferSize) {
-                    memmove(streamBuffer, streamBuffer + bytesConsumed, 
-                            streamBufferSize - bytesConsumed);
-                    streamBufferSize -= bytesConsumed;
-                }
+                consume_bytes(dec, bytesConsumed);
                 return ret;
             }
 
             // Stream error
             case H264SWDEC_STRM_ERR: {
                 // Try to recover by removing consumed bytes
-                if (bytesConsumed > 0 && bytesConsumed <= streamBufferSize) {
-                    memmove(streamBuffer, streamBuffer + bytesConsumed, 
-                            streamBufferSize - bytesConsumed);
-                    streamBufferSize -= bytesConsumed;
-                } else if (streamBufferSize > 0) {
+                if (bytesConsumed > 0 &&
+                    bytesConsumed <= dec->streamBufferEnd - dec->streamBufferPos) {
+                    consume_bytes(dec, bytesConsumed);
+                } else {
                     // Skip one byte and try again (error recovery)
-                    memmove(streamBuffer, streamBuffer + 1, streamBufferSize - 1);
-                    streamBufferSize -= 1;
+                    consume_bytes(dec, 1);
                 }
-                
+
                 // If no more data, return the error
-                if (streamBufferSize == 0) {
+                if (dec->streamBufferPos == dec->streamBufferEnd) {
                     return ret;
                 }
                 // Otherwise try to continue
@@ -160,11 +307,7 @@ int h264_decode(uint8_t *buffer, size_t length) {
 
             default:
                 // For any other return value, remove consumed bytes and exit
-                if (bytesConsumed > 0 && bytesConsumed <= streamBufferSize) {
-                    memmove(streamBuffer, streamBuffer + bytesConsumed, 
-                            streamBufferSize - bytesConsumed);
-                    streamBufferSize -= bytesConsumed;
-                }
+                consume_bytes(dec, bytesConsumed);
                 return ret;
         }
     }
@@ -172,25 +315,421 @@ int h264_decode(uint8_t *buffer, size_t length) {
     return 0;
 }
 
+/*------------------------- Decode Framed NAL Units ------------------------*/
+// Decode the NAL units of one access unit whose boundaries are already known
+// (RTP depacketizer, MP4 demuxer). data holds count NAL units back to back,
+// without start codes, sizes[i] is the length of the i-th one. The stream
+// buffer is not used, so no start code scanning or copying takes place.
+EMSCRIPTEN_KEEPALIVE
+int h264_decoder_decode_nals(h264_decoder *dec, uint8_t *data,
+                             const uint32_t *sizes, int count) {
+    if (!dec || !dec->decInst || !data || !sizes || count <= 0) return -1;
+
+    int result = H264SWDEC_STRM_PROCESSED;
+
+    for (int i = 0; i < count; i++) {
+        uint8_t *nal = data;
+        data += sizes[i];
+
+        if (sizes[i] == 0) continue;
+
+        dec->decInput.pStream = nal;
+        dec->decInput.dataLen = sizes[i];
+        dec->decInput.intraConcealmentMethod = 0; // gray concealment
+
+        H264SwDecRet ret;
+        do {
+            ret = H264SwDecDecode(dec->decInst, &dec->decInput, &dec->decOutput);
+
+            switch (ret) {
+                case H264SWDEC_HDRS_RDY_BUFF_NOT_EMPTY:
+                    H264SwDecGetInfo(dec->decInst, &dec->decInfo);  // query video info
+                    break;
+
+                case H264SWDEC_PIC_RDY:
+                case H264SWDEC_PIC_RDY_BUFF_NOT_EMPTY:
+                    dec->decInput.picId++;
+                    output_pictures(dec);
+                    result = H264SWDEC_PIC_RDY;
+                    break;
+
+                case H264SWDEC_STRM_PROCESSED:
+                    break;
+
+                default:
+                    // Drop the NAL unit, keep going with the next one
+                    if (result != H264SWDEC_PIC_RDY) result = ret;
+                    break;
+            }
+
+            // BUFF_NOT_EMPTY: the NAL unit was not consumed yet, feed it again
+        } while ((ret == H264SWDEC_HDRS_RDY_BUFF_NOT_EMPTY ||
+                  ret == H264SWDEC_PIC_RDY_BUFF_NOT_EMPTY) &&
+                 dec->decOutput.pStrmCurrPos < nal + sizes[i]);
+    }
+
+    return result;
+}
+
+/*----------------------------- Reset Stream Buffer ------------------------*/
+EMSCRIPTEN_KEEPALIVE
+void h264_decoder_reset_buffer(h264_decoder *dec) {
+    if (!dec) return;
+    dec->streamBufferPos = 0;
+    dec->streamBufferEnd = 0;
+}
+
+/*------------------------------- Get Statistics ---------------------------*/
+// Returns a pointer to the decoder's H264SwDecStats, refreshed on each call.
+// The structure starts with eleven 64-bit fields (ten stage times in
+// nanoseconds and numBytes) followed by 32-bit fields beginning with
+// enabled, which is 0 unless the module was built with H264DEC_STATS.
+EMSCRIPTEN_KEEPALIVE
+const H264SwDecStats *h264_decoder_get_stats(h264_decoder *dec) {
+    if (!dec) return NULL;
+    if (H264SwDecGetStats(dec->decInst, &dec->decStats) != H264SWDEC_OK) {
+        return NULL;
+    }
+    return &dec->decStats;
+}
+
+/*------------------------------------------------------------------------------
+    Legacy single-stream API, operates on a module-wide default instance
+------------------------------------------------------------------------------*/
+
+/*----------------------------- Initialization -----------------------------*/
+EMSCRIPTEN_KEEPALIVE
+int h264_init(int noOutputReordering) {
+    if (defaultDecoder) return 0; // already initialized
+
+    defaultDecoder = h264_create(noOutputReordering);
+    if (!defaultDecoder) return -1;
+
+    h264_decoder_set_callback(defaultDecoder, defaultCallback);
+    h264_decoder_set_frame_callback(defaultDecoder, defaultFrameCallback);
+    return 0;
+}
+
+/*---------------------------- Set Picture Callback ------------------------*/
+EMSCRIPTEN_KEEPALIVE
+void h264_set_callback(h264_picture_cb cb) {
+    defaultCallback = cb;
+    h264_decoder_set_callback(defaultDecoder, cb);
+}
+
+/*----------------------------- Set Frame Callback -------------------------*/
+EMSCRIPTEN_KEEPALIVE
+void h264_set_frame_callback(h264_frame_cb cb) {
+    defaultFrameCallback = cb;
+    h264_decoder_set_frame_callback(defaultDecoder, cb);
+}
+
+/*---------------------------- Decode H.264 Buffer ------------------------*/
+EMSCRIPTEN_KEEPALIVE
+int h264_decode(uint8_t *buffer, size_t length) {
+    return h264_decoder_decode(defaultDecoder, buffer, length);
+}
+
+/*------------------------- Decode Framed NAL Units ------------------------*/
+EMSCRIPTEN_KEEPALIVE
+int h264_decode_nals(uint8_t *data, const uint32_t *sizes, int count) {
+    return h264_decoder_decode_nals(defaultDecoder, data, sizes, count);
+}
+
+/*---------------------------- Get Input Buffer ----------------------------*/
+EMSCRIPTEN_KEEPALIVE
+uint8_t *h264_get_input_buffer(size_t size) {
+    return h264_decoder_get_input_buffer(defaultDecoder, size);
+}
+
 /*----------------------------- Reset Stream Buffer ------------------------*/
 EMSCRIPTEN_KEEPALIVE
 void h264_reset_buffer(void) {
-    streamBufferSize = 0;
+    h264_decoder_reset_buffer(defaultDecoder);
+}
+
+/*------------------------------- Get Statistics ---------------------------*/
+EMSCRIPTEN_KEEPALIVE
+const H264SwDecStats *h264_get_stats(void) {
+    return h264_decoder_get_stats(defaultDecoder);
 }
 
 /*----------------------------- Release Decoder ---------------------------*/
 EMSCRIPTEN_KEEPALIVE
 void h264_release(void) {
-    if (decInst) {
-        H264SwDecRelease(decInst);
-        decInst = NULL;
+    h264_destroy(defaultDecoder);
+    defaultDecoder = NULL;
+}
+
+#ifdef H264DEC_SCHEDULER
+/*------------------------------------------------------------------------------
+    Multi-stream scheduler, decodes many instances on a pool of threads.
+    The pool threads run in web workers and never call into JS: finished
+    frames are copied into a queue of the stream, which the page thread
+    empties with h264_sched_poll or h264_sched_drain.
+------------------------------------------------------------------------------*/
+
+// Output frame queued by a scheduled stream. info comes first so JS can
+// read it at the frame pointer, the yuv pointer follows at byte offset 40.
+// The picture holds width * height * 3 / 2 bytes.
+typedef struct h264_sched_frame {
+    h264_frame_info info;
+    uint8_t *yuv;
+    struct h264_sched_frame *next;
+} h264_sched_frame;
+
+// Stream decoded by the scheduler. The frame queue, pending count and last
+// result are written by the pool threads, protected by mutex.
+typedef struct {
+    h264_decoder *dec;
+    H264SwDecStreamInst streamInst;
+    uint32_t nextPicId;
+    pthread_mutex_t mutex;
+    h264_sched_frame *head;
+    h264_sched_frame *tail;
+    h264_sched_frame *polled;   // last frame polled, freed by the next poll
+    uint32_t numPending;        // submitted inputs not decoded yet
+    int lastResult;             // result of the last decoded input
+} h264_sched_stream;
+
+/*---------------------------- Queue Finished Frame ------------------------*/
+// Called on the pool thread decoding the stream (or the one flushing it),
+// the decoder instance belongs to that thread during the call.
+static void sched_picture_ready(void *userData, H264SwDecPicture *pic) {
+    h264_sched_stream *stream = userData;
+    h264_decoder *dec = stream->dec;
+
+    if (!pic->pOutputPicture) return;
+
+    dec->decPicture = *pic;
+    H264SwDecGetInfo(dec->decInst, &dec->decInfo);
+    fill_frame_info(dec);
+
+    size_t size = (size_t) dec->frameInfo.width * dec->frameInfo.height * 3 / 2;
+    h264_sched_frame *frame = malloc(sizeof(h264_sched_frame) + size);
+    if (!frame) return; // Out of memory, frame dropped
+
+    frame->info = dec->frameInfo;
+    frame->yuv = (uint8_t *) (frame + 1);
+    frame->next = NULL;
+    memcpy(frame->yuv, pic->pOutputPicture, size);
+
+    pthread_mutex_lock(&stream->mutex);
+    if (stream->tail) {
+        stream->tail->next = frame;
+    } else {
+        stream->head = frame;
+    }
+    stream->tail = frame;
+    pthread_mutex_unlock(&stream->mutex);
+}
+
+/*------------------------------ Release Input -----------------------------*/
+static void sched_input_done(void *userData, H264SwDecInput *input,
+                             H264SwDecRet result) {
+    h264_sched_stream *stream = userData;
+
+    free(input->pStream);
+
+    pthread_mutex_lock(&stream->mutex);
+    stream->numPending--;
+    stream->lastResult = result;
+    pthread_mutex_unlock(&stream->mutex);
+}
+
+/*-------------------------------- Take Frame ------------------------------*/
+static h264_sched_frame *sched_take_frame(h264_sched_stream *stream) {
+    pthread_mutex_lock(&stream->mutex);
+    h264_sched_frame *frame = stream->head;
+    if (frame) {
+        stream->head = frame->next;
+        if (!stream->head) stream->tail = NULL;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    return frame;
+}
+
+/*----------------------------- Create Scheduler ---------------------------*/
+// Pool threads are web workers, the page has to be cross-origin isolated.
+// Returns NULL on failure.
+EMSCRIPTEN_KEEPALIVE
+H264SwDecSchedInst h264_sched_create(int numThreads) {
+    H264SwDecSchedInst sched;
+
+    if (numThreads <= 0) return NULL;
+    if (H264SwDecSchedInit(&sched, (u32) numThreads) != H264SWDEC_OK) {
+        return NULL;
+    }
+    return sched;
+}
+
+/*----------------------------- Destroy Scheduler --------------------------*/
+// All streams have to be removed first.
+EMSCRIPTEN_KEEPALIVE
+void h264_sched_destroy(H264SwDecSchedInst sched) {
+    H264SwDecSchedRelease(sched);
+}
+
+/*-------------------------------- Add Stream ------------------------------*/
+// Hand a decoder created with h264_create over to the scheduler, streams
+// with higher priority are decoded first. The decoder must not be used
+// directly until the stream has been removed.
+EMSCRIPTEN_KEEPALIVE
+h264_sched_stream *h264_sched_add_stream(H264SwDecSchedInst sched,
+                                         h264_decoder *dec, uint32_t priority) {
+    if (!sched || !dec || !dec->decInst) return NULL;
+
+    h264_sched_stream *stream = calloc(1, sizeof(h264_sched_stream));
+    if (!stream) return NULL;
+
+    stream->dec = dec;
+    pthread_mutex_init(&stream->mutex, NULL);
+
+    H264SwDecStreamCallbacks callbacks = {
+        sched_picture_ready, sched_input_done, stream
+    };
+    if (H264SwDecSchedAddStream(sched, dec->decInst, priority, &callbacks,
+                                &stream->streamInst) != H264SWDEC_OK) {
+        pthread_mutex_destroy(&stream->mutex);
+        free(stream);
+        return NULL;
     }
-    
-    // Free stream buffer
-    if (streamBuffer) {
-        free(streamBuffer);
-        streamBuffer = NULL;
+    return stream;
+}
+
+/*------------------------------- Remove Stream ----------------------------*/
+// Waits until the submitted inputs have been decoded, frames not fetched
+// yet are dropped. The decoder is left to the caller (h264_destroy).
+EMSCRIPTEN_KEEPALIVE
+void h264_sched_remove_stream(h264_sched_stream *stream) {
+    if (!stream) return;
+
+    H264SwDecSchedRemoveStream(stream->streamInst);
+
+    h264_sched_frame *frame;
+    while ((frame = sched_take_frame(stream)) != NULL) {
+        free(frame);
     }
-    streamBufferSize = 0;
-    streamBufferCapacity = 0;
+    free(stream->polled);
+    pthread_mutex_destroy(&stream->mutex);
+    free(stream);
+}
+
+/*------------------------------- Set Priority -----------------------------*/
+EMSCRIPTEN_KEEPALIVE
+int h264_sched_set_priority(h264_sched_stream *stream, uint32_t priority) {
+    if (!stream) return -1;
+    return H264SwDecSchedSetPriority(stream->streamInst, priority);
+}
+
+/*--------------------------------- Submit ---------------------------------*/
+// Queue one access unit (Annex B byte stream) for decoding and return at
+// once. The data is copied, so buffer may be reused right away. Inputs are
+// numbered in submission order and the number is reported as picId of the
+// frame decoded from the input.
+EMSCRIPTEN_KEEPALIVE
+int h264_sched_submit(h264_sched_stream *stream, uint8_t *buffer,
+                      size_t length) {
+    if (!stream || !buffer || length == 0) return -1;
+
+    uint8_t *data = malloc(length);
+    if (!data) return -1; // Out of memory
+    memcpy(data, buffer, length);
+
+    H264SwDecInput input;
+    memset(&input, 0, sizeof(input));
+    input.pStream = data;
+    input.dataLen = (u32) length;
+    input.picId = stream->nextPicId;
+    input.intraConcealmentMethod = 0; // gray concealment
+
+    pthread_mutex_lock(&stream->mutex);
+    stream->numPending++;
+    pthread_mutex_unlock(&stream->mutex);
+
+    H264SwDecRet ret = H264SwDecSchedSubmit(stream->streamInst, &input);
+    if (ret != H264SWDEC_OK) {
+        pthread_mutex_lock(&stream->mutex);
+        stream->numPending--;
+        pthread_mutex_unlock(&stream->mutex);
+        free(data);
+        return ret;
+    }
+
+    stream->nextPicId++;
+    return 0;
+}
+
+/*----------------------------- Pending Inputs -----------------------------*/
+// Number of submitted inputs not decoded yet, for throttling the submits.
+EMSCRIPTEN_KEEPALIVE
+int h264_sched_pending(h264_sched_stream *stream) {
+    if (!stream) return -1;
+
+    pthread_mutex_lock(&stream->mutex);
+    int pending = (int) stream->numPending;
+    pthread_mutex_unlock(&stream->mutex);
+    return pending;
+}
+
+/*------------------------------- Last Result ------------------------------*/
+// H264SwDecRet of the last decoded input, H264SWDEC_PIC_RDY if it finished
+// a picture.
+EMSCRIPTEN_KEEPALIVE
+int h264_sched_last_result(h264_sched_stream *stream) {
+    if (!stream) return -1;
+
+    pthread_mutex_lock(&stream->mutex);
+    int result = stream->lastResult;
+    pthread_mutex_unlock(&stream->mutex);
+    return result;
+}
+
+/*---------------------------------- Poll ----------------------------------*/
+// Returns the oldest finished frame of the stream, NULL if none. The frame
+// is valid until the next h264_sched_poll or h264_sched_remove_stream call
+// for the stream.
+EMSCRIPTEN_KEEPALIVE
+const h264_sched_frame *h264_sched_poll(h264_sched_stream *stream) {
+    if (!stream) return NULL;
+
+    free(stream->polled);
+    stream->polled = sched_take_frame(stream);
+    return stream->polled;
+}
+
+/*---------------------------------- Drain ---------------------------------*/
+// Passes all finished frames of the stream to the frame or picture callback
+// of its decoder, on the calling thread. Returns the number of frames.
+EMSCRIPTEN_KEEPALIVE
+int h264_sched_drain(h264_sched_stream *stream) {
+    if (!stream) return -1;
+
+    h264_decoder *dec = stream->dec;
+    h264_sched_frame *frame;
+    int count = 0;
+
+    while ((frame = sched_take_frame(stream)) != NULL) {
+        if (dec->frameCallback) {
+            dec->frameCallback(frame->yuv, &frame->info);
+        } else if (dec->pictureCallback) {
+            dec->pictureCallback(frame->yuv, (int) frame->info.width,
+                                 (int) frame->info.height);
+        }
+        free(frame);
+        count++;
+    }
+    return count;
+}
+
+/*---------------------------------- Flush ---------------------------------*/
+// Waits until the submitted inputs have been decoded, at the end of the
+// stream the frames buffered for reordering are then queued too. Blocks the
+// calling thread: on the page thread call it only once h264_sched_pending
+// has reached 0.
+EMSCRIPTEN_KEEPALIVE
+int h264_sched_flush(h264_sched_stream *stream, int endOfStream) {
+    if (!stream) return -1;
+    return H264SwDecSchedFlush(stream->streamInst, endOfStream ? 1 : 0);
 }
+#endif /* H264DEC_SCHEDULER */
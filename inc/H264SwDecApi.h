@@ -73,7 +73,10 @@ extern "C"
     /* typedef of the Decoder instance */
     typedef void *H264SwDecInst;
 
-    /* Input structure */
+    /* Input structure. Zero-initialize the structure (e.g. memset) before
+     * filling it in, fields added in later API versions are then left at
+     * their default. Since version 2.4 nalLengthSize is checked and a
+     * value other than 0, 1, 2 or 4 returns H264SWDEC_PARAM_ERR */
     typedef struct
     {
         u8  *pStream;            /* Pointer to stream to be decoded          */
@@ -81,6 +84,10 @@ extern "C"
         u32  picId;              /* Identifier for the picture to be decoded */
         u32 intraConcealmentMethod; /* 0 = Gray concealment for intra
                                        1 = Reference concealment for intra */
+        u32 nalLengthSize;      /* 0 = Annex B byte stream
+                                   1, 2 or 4 = NAL units each preceded by
+                                   a big-endian length field of this many
+                                   bytes (AVCC), no start code scanning */
 
     } H264SwDecInput;
 
@@ -100,6 +107,8 @@ extern "C"
         u32 isIdrPicture;       /* Flag to indicate if the picture is an
                                    IDR picture */
         u32 nbrOfErrMBs;        /* Number of concealed MB's in the picture  */
+        i32 picOrderCnt;        /* Picture order count, relative to the
+                                   previous IDR picture or MMCO 5 */
     } H264SwDecPicture;
 
 /*------------------------------------------------------------------------------
@@ -128,6 +137,33 @@ extern "C"
         CropParams cropParams;
     } H264SwDecInfo;
 
+    /* Decoding statistics, see H264SwDecGetStats. Times are accumulated
+     * nanoseconds and counters totals since H264SwDecInit */
+    typedef struct
+    {
+        u64 nalExtractTime;     /* NAL unit extraction from the stream      */
+        u64 sliceHeaderTime;    /* slice header decoding                    */
+        u64 mbLayerTime;        /* macroblock layer parsing                 */
+        u64 intraMbTime;        /* reconstruction of intra macroblocks      */
+        u64 interMbTime;        /* reconstruction of inter macroblocks      */
+        u64 deblockTime;        /* deblocking filtering                     */
+        u64 concealTime;        /* error concealment                        */
+        u64 dpbTime;            /* picture order count and DPB handling     */
+        u64 outputTime;         /* retrieving pictures for display          */
+        u64 syncTime;           /* waiting for slices and pictures finished
+                                 * by worker threads (H264DEC_THREADS)      */
+        u64 numBytes;           /* stream bytes consumed                    */
+        u32 enabled;            /* 0 if decoder built without H264DEC_STATS */
+        u32 numNalUnits;
+        u32 numSlices;
+        u32 numPictures;
+        u32 numIntraMbs;        /* I_4x4 and I_16x16 macroblocks            */
+        u32 numPcmMbs;
+        u32 numInterMbs;        /* coded inter macroblocks                  */
+        u32 numSkippedMbs;
+        u32 numConcealedMbs;
+    } H264SwDecStats;
+
     /* Version information */
     typedef struct
     {
@@ -157,6 +193,9 @@ extern "C"
 
     H264SwDecApiVersion H264SwDecGetAPIVersion(void);
 
+    H264SwDecRet H264SwDecGetStats(H264SwDecInst   decInst,
+                                   H264SwDecStats *pStats);
+
     /* function prototype for API trace */
     void H264SwDecTrace(char *);
 
@@ -0,0 +1,98 @@
+/*------------------------------------------------------------------------------
+
+    Table of contents
+
+    1. Include Headers
+
+    2. User Structures
+
+    3. Prototypes of Scheduler API functions
+
+------------------------------------------------------------------------------*/
+
+#ifndef H264SWDECSCHEDULER_H
+#define H264SWDECSCHEDULER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*------------------------------------------------------------------------------
+    1. Include Headers
+------------------------------------------------------------------------------*/
+
+    #include "basetype.h"
+    #include "H264SwDecApi.h"
+
+/*------------------------------------------------------------------------------
+    2. User Structures
+--------------------------------------------------------------------------------
+
+    The scheduler decodes many decoder instances (streams) on a fixed pool of
+    threads. Input buffers submitted for a stream, normally one access unit
+    each, are decoded in submission order, one at a time: an instance runs on
+    one pool thread at a time and is handed back to the pool after each
+    input, so a stream with higher priority waits at most for the inputs
+    already being decoded. A stream is preferably decoded by the thread that
+    decoded its previous input, idle threads steal streams queued for the
+    others.
+
+    The scheduler does not take ownership of the decoder instances, an
+    instance shall not be used directly while it belongs to the scheduler.
+    Pool threads decode slices of a picture themselves, so the decoder shall
+    be built without H264DEC_THREADS (the build stops otherwise).
+
+    In the WebAssembly module the pool threads run in web workers, the
+    h264_sched_* functions of h264.c queue the finished frames of each
+    stream for the page thread to fetch with h264_sched_poll or
+    h264_sched_drain.
+
+------------------------------------------------------------------------------*/
+
+    /* typedefs of the scheduler and stream instances */
+    typedef void *H264SwDecSchedInst;
+    typedef void *H264SwDecStreamInst;
+
+    /* Stream callbacks, called on the pool thread decoding the stream, or on
+     * the thread calling H264SwDecSchedFlush, never concurrently for one
+     * stream. Picture is valid during the callback only */
+    typedef struct
+    {
+        void (*pictureReady)(void *pUserData, H264SwDecPicture *pPicture);
+        void (*inputDone)(void *pUserData, H264SwDecInput *pInput,
+                          H264SwDecRet result);
+        void *pUserData;
+    } H264SwDecStreamCallbacks;
+
+/*------------------------------------------------------------------------------
+    3. Prototypes of Scheduler API functions
+------------------------------------------------------------------------------*/
+
+    H264SwDecRet H264SwDecSchedInit(H264SwDecSchedInst *schedInst,
+                                    u32                 numThreads);
+
+    void H264SwDecSchedRelease(H264SwDecSchedInst schedInst);
+
+    H264SwDecRet H264SwDecSchedAddStream(H264SwDecSchedInst schedInst,
+                                         H264SwDecInst decInst,
+                                         u32 priority,
+                                         H264SwDecStreamCallbacks *pCallbacks,
+                                         H264SwDecStreamInst *streamInst);
+
+    void H264SwDecSchedRemoveStream(H264SwDecStreamInst streamInst);
+
+    H264SwDecRet H264SwDecSchedSetPriority(H264SwDecStreamInst streamInst,
+                                           u32                 priority);
+
+    H264SwDecRet H264SwDecSchedSubmit(H264SwDecStreamInst streamInst,
+                                      H264SwDecInput     *pInput);
+
+    H264SwDecRet H264SwDecSchedFlush(H264SwDecStreamInst streamInst,
+                                     u32                 endOfStream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H264SWDECSCHEDULER_H */
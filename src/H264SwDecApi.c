@@ -29,6 +29,7 @@
           H264SwDecDecode
           H264SwDecGetAPIVersion
           H264SwDecNextPicture
+          H264SwDecGetStats
 
 ------------------------------------------------------------------------------*/
 
@@ -52,7 +53,16 @@
 ------------------------------------------------------------------------------*/
 
 #define H264SWDEC_MAJOR_VERSION 2
-#define H264SWDEC_MINOR_VERSION 3
+#define H264SWDEC_MINOR_VERSION 6
+
+/*
+    2.4     H264SwDecInput.nalLengthSize, length prefixed (AVCC) input.
+            H264SwDecInput has to be zero-initialized by callers that do not
+            set the new field, H264SwDecDecode returns H264SWDEC_PARAM_ERR
+            for a value other than 0, 1, 2 or 4.
+    2.5     H264SwDecGetStats and H264SwDecStats.
+    2.6     H264SwDecPicture.picOrderCnt.
+*/
 
 /*------------------------------------------------------------------------------
     2. External compiler flags
@@ -61,6 +71,7 @@
 H264DEC_TRACE           Trace H264 Decoder API function calls.
 H264DEC_EVALUATION      Compile evaluation version, restricts number of frames
                         that can be decoded
+H264DEC_STATS           Collect decoding statistics, see H264SwDecGetStats
 
 --------------------------------------------------------------------------------
     3. Module defines
@@ -77,6 +88,12 @@ H264DEC_EVALUATION      Compile evaluation version, restricts number of frames
 #define H264DEC_EVALUATION_LIMIT   500
 #endif
 
+/*------------------------------------------------------------------------------
+    4. Local function prototypes
+------------------------------------------------------------------------------*/
+
+static u32 GetNalUnitLength(u8 *pStream, u32 lengthSize);
+
 void H264SwDecTrace(char *string) {
     UNUSED(string);
 }
@@ -313,6 +330,10 @@ void H264SwDecRelease(H264SwDecInst decInst)
 
         Functional description:
             Decode stream data. Calls h264bsdDecode to do the actual decoding.
+            If pInput->nalLengthSize is non-zero the stream is a sequence
+            of NAL units each preceded by a big-endian length field (AVCC
+            format) and NAL unit boundaries are taken from the length
+            fields instead of searching for start codes.
 
         Input:
             decInst     decoder instance
@@ -347,6 +368,7 @@ H264SwDecRet H264SwDecDecode(H264SwDecInst decInst, H264SwDecInput *pInput,
     decContainer_t *pDecCont;
     u32 strmLen;
     u32 numReadBytes;
+    u32 lengthSize, nalLen;
     u8 *tmpStream;
     u32 decResult = 0;
     H264SwDecRet returnValue = H264SWDEC_STRM_PROCESSED;
@@ -366,6 +388,13 @@ H264SwDecRet H264SwDecDecode(H264SwDecInst decInst, H264SwDecInput *pInput,
         return(H264SWDEC_PARAM_ERR);
     }
 
+    if (pInput->nalLengthSize != 0 && pInput->nalLengthSize != 1 &&
+        pInput->nalLengthSize != 2 && pInput->nalLengthSize != 4)
+    {
+        DEC_API_TRC("H264SwDecDecode# ERROR: Invalid NAL length size");
+        return(H264SWDEC_PARAM_ERR);
+    }
+
     pDecCont = (decContainer_t *)decInst;
 
     /* Check if decoder is in an incorrect mode */
@@ -401,6 +430,37 @@ H264SwDecRet H264SwDecDecode(H264SwDecInst decInst, H264SwDecInput *pInput,
             decResult = H264BSD_HDRS_RDY;
             pDecCont->decStat = INITIALIZED;
         }
+        else if (pInput->nalLengthSize) /* Length prefixed NAL units */
+        {
+            lengthSize = pInput->nalLengthSize;
+            if (strmLen <= lengthSize)
+            {
+                /* nothing but (part of) a length field left */
+                decResult = H264BSD_ERROR;
+                numReadBytes = strmLen;
+            }
+            else
+            {
+                nalLen = GetNalUnitLength(tmpStream, lengthSize);
+                /* truncated NAL unit, decode what is available */
+                nalLen = MIN(nalLen, strmLen - lengthSize);
+
+                if (nalLen == 0)
+                {
+                    decResult = H264BSD_RDY;
+                    numReadBytes = 0;
+                }
+                else
+                    decResult = h264bsdDecode(&pDecCont->storage,
+                        tmpStream + lengthSize, nalLen, pInput->picId,
+                        &numReadBytes);
+
+                /* NAL unit is either consumed as a whole or not at all
+                 * (decoding continues from the same NAL unit) */
+                if (numReadBytes || nalLen == 0)
+                    numReadBytes = lengthSize + nalLen;
+            }
+        }
         else /* Continue decoding normally */
         {
             decResult = h264bsdDecode(&pDecCont->storage, tmpStream, strmLen,
@@ -467,6 +527,16 @@ H264SwDecRet H264SwDecDecode(H264SwDecInst decInst, H264SwDecInput *pInput,
 
     } while (strmLen);
 
+#ifdef H264DEC_THREADS
+    /* slices decoded in parallel refer to the stream buffer of this call ->
+     * finish them before returning */
+    if (h264bsdFinishSliceJobs(&pDecCont->storage) == H264BSD_PIC_RDY)
+    {
+        pDecCont->picNumber++;
+        returnValue = H264SWDEC_PIC_RDY;
+    }
+#endif
+
 #ifdef H264DEC_TRACE
     sprintf(pDecCont->str, "H264SwDecDecode# OK: DecResult %d",
             returnValue);
@@ -532,7 +602,11 @@ H264SwDecRet H264SwDecNextPicture(H264SwDecInst decInst,
 
     decContainer_t *pDecCont;
     u32 numErrMbs, isIdrPic, picId;
+    i32 picOrderCnt;
     u32 *pOutPic;
+#ifdef H264DEC_STATS
+    u64 statsTime;
+#endif
 
     DEC_API_TRC("H264SwDecNextPicture#");
 
@@ -551,10 +625,17 @@ H264SwDecRet H264SwDecNextPicture(H264SwDecInst decInst,
 #endif
 
     if (flushBuffer)
+    {
+        STATS_START(statsTime);
         h264bsdFlushBuffer(&pDecCont->storage);
+        STATS_STOP(&pDecCont->storage, outputTime, statsTime);
+    }
 
+    /* adds to outputTime itself, except for the time waiting for the
+     * picture to be finished by the worker threads */
     pOutPic = (u32*)h264bsdNextOutputPicture(&pDecCont->storage, &picId,
-                                             &isIdrPic, &numErrMbs);
+                                             &isIdrPic, &numErrMbs,
+                                             &picOrderCnt);
 
     if (pOutPic == NULL)
     {
@@ -567,10 +648,84 @@ H264SwDecRet H264SwDecNextPicture(H264SwDecInst decInst,
         pOutput->picId          = picId;
         pOutput->isIdrPicture   = isIdrPic;
         pOutput->nbrOfErrMBs    = numErrMbs;
+        pOutput->picOrderCnt    = picOrderCnt;
         DEC_API_TRC("H264SwDecNextPicture# OK: return H264SWDEC_PIC_RDY");
         return(H264SWDEC_PIC_RDY);
     }
 
 }
 
+/*------------------------------------------------------------------------------
+
+    Function: H264SwDecGetStats
+
+        Functional description:
+            Read the decoding statistics collected since H264SwDecInit. The
+            statistics are only collected if the decoder was built with
+            H264DEC_STATS, otherwise all fields including enabled are zero.
+
+        Input:
+            decInst     decoder instance.
+
+        Output:
+            pStats      pointer to statistics structure where data is written
+
+        Returns:
+            H264SWDEC_OK            success
+            H264SWDEC_PARAM_ERR     invalid parameters
 
+------------------------------------------------------------------------------*/
+
+H264SwDecRet H264SwDecGetStats(H264SwDecInst decInst, H264SwDecStats *pStats)
+{
+
+    DEC_API_TRC("H264SwDecGetStats#");
+
+    if (decInst == NULL || pStats == NULL)
+    {
+        DEC_API_TRC("H264SwDecGetStats# ERROR: decInst or pStats is NULL");
+        return(H264SWDEC_PARAM_ERR);
+    }
+
+#ifdef H264DEC_STATS
+    *pStats = ((decContainer_t*)decInst)->storage.stats;
+    pStats->enabled = 1;
+#else
+    H264SwDecMemset(pStats, 0, sizeof(H264SwDecStats));
+#endif
+
+    DEC_API_TRC("H264SwDecGetStats# OK");
+
+    return(H264SWDEC_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: GetNalUnitLength
+
+        Functional description:
+            Read big-endian NAL unit length field of a length prefixed
+            (AVCC) stream.
+
+        Input:
+            pStream     pointer to the length field
+            lengthSize  size of the length field in bytes, 1, 2 or 4
+
+        Returns:
+            length of the NAL unit in bytes
+
+------------------------------------------------------------------------------*/
+
+static u32 GetNalUnitLength(u8 *pStream, u32 lengthSize)
+{
+
+    u32 i;
+    u32 len = 0;
+
+    for (i = 0; i < lengthSize; i++)
+        len = (len << 8) | pStream[i];
+
+    return(len);
+
+}
@@ -0,0 +1,872 @@
+/*------------------------------------------------------------------------------
+
+    Table of contents
+
+     1. Include headers
+     2. External compiler flags
+     3. Module defines
+     4. Local function prototypes
+     5. Functions
+          H264SwDecSchedInit
+          H264SwDecSchedRelease
+          H264SwDecSchedAddStream
+          H264SwDecSchedRemoveStream
+          H264SwDecSchedSetPriority
+          H264SwDecSchedSubmit
+          H264SwDecSchedFlush
+          PoolThread
+          TakeStream
+          RunStream
+          QueueStream
+          DecodeInput
+          OutputPictures
+
+------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+    1. Include headers
+------------------------------------------------------------------------------*/
+
+#include <pthread.h>
+
+#include "basetype.h"
+#include "H264SwDecApi.h"
+#include "H264SwDecScheduler.h"
+#include "h264bsd_util.h"
+
+/*------------------------------------------------------------------------------
+    2. External compiler flags
+--------------------------------------------------------------------------------
+
+H264DEC_THREADS     Must not be defined, pool threads decode the slices of a
+                    picture themselves
+
+--------------------------------------------------------------------------------
+    3. Module defines
+------------------------------------------------------------------------------*/
+
+#ifdef H264DEC_THREADS
+#error "H264DEC_SCHEDULER requires the decoder built without H264DEC_THREADS"
+#endif
+
+/* initial size of the input ring of a stream, doubled when full */
+#define SCHED_INITIAL_INPUTS 16
+
+/* states of a stream: no inputs, waiting in a run queue, being decoded */
+#define STREAM_IDLE     0
+#define STREAM_QUEUED   1
+#define STREAM_RUNNING  2
+
+/* stream decoded by the scheduler. State, inputs and home are protected by
+ * the mutex of the stream, run queue link by the mutex of the pool thread
+ * whose queue the stream is in, priority is accessed with atomic
+ * operations */
+typedef struct schedStream
+{
+    struct scheduler *sched;
+    H264SwDecInst decInst;
+    H264SwDecStreamCallbacks callbacks;
+    u32 priority;
+    u32 state;
+    u32 home;                       /* pool thread preferred for decoding */
+    H264SwDecInput *input;          /* ring of submitted inputs */
+    u32 inputSize;
+    u32 inputHead;
+    u32 numInputs;
+    struct schedStream *next;
+    pthread_mutex_t mutex;
+    pthread_cond_t idle;
+} schedStream_t;
+
+/* pool thread and its run queue of streams */
+typedef struct
+{
+    struct scheduler *sched;
+    pthread_t thread;
+    u32 index;
+    pthread_mutex_t mutex;
+    schedStream_t *head;
+    schedStream_t *tail;
+} schedThread_t;
+
+/* Streams queued in all run queues are counted in numQueued (atomic), idle
+ * pool threads wait on workReady. Lock order is stream, run queue,
+ * scheduler */
+typedef struct scheduler
+{
+    schedThread_t *thread;
+    u32 numThreads;
+    u32 nextHome;
+    u32 numQueued;
+    u32 numIdle;
+    u32 quit;
+    pthread_mutex_t mutex;
+    pthread_cond_t workReady;
+} scheduler_t;
+
+/*------------------------------------------------------------------------------
+    4. Local function prototypes
+------------------------------------------------------------------------------*/
+
+static void *PoolThread(void *arg);
+static schedStream_t *TakeStream(scheduler_t *sched, u32 self);
+static void RunStream(schedStream_t *stream, u32 self);
+static void QueueStream(schedStream_t *stream);
+static H264SwDecRet DecodeInput(schedStream_t *stream,
+    H264SwDecInput *pInput);
+static void OutputPictures(schedStream_t *stream, u32 flushBuffer);
+
+/*------------------------------------------------------------------------------
+
+    Function: H264SwDecSchedInit
+
+        Functional description:
+            Create a scheduler and its pool of threads.
+
+        Inputs:
+            numThreads  number of pool threads
+
+        Outputs:
+            schedInst   pointer to the scheduler instance is stored here
+
+        Returns:
+            H264SWDEC_OK            success
+            H264SWDEC_PARAM_ERR     invalid parameters
+            H264SWDEC_MEMFAIL       memory allocation failed
+            H264SWDEC_INITFAIL      thread creation failed
+
+------------------------------------------------------------------------------*/
+
+H264SwDecRet H264SwDecSchedInit(H264SwDecSchedInst *schedInst, u32 numThreads)
+{
+
+/* Variables */
+
+    u32 i;
+    scheduler_t *sched;
+
+/* Code */
+
+    if (schedInst == NULL || numThreads == 0)
+        return(H264SWDEC_PARAM_ERR);
+
+    sched = (scheduler_t*)H264SwDecMalloc(sizeof(scheduler_t), 1);
+    if (sched == NULL)
+        return(H264SWDEC_MEMFAIL);
+    H264SwDecMemset(sched, 0, sizeof(scheduler_t));
+
+    sched->thread = (schedThread_t*)H264SwDecMalloc(sizeof(schedThread_t),
+        numThreads);
+    if (sched->thread == NULL)
+    {
+        H264SwDecFree(sched);
+        return(H264SWDEC_MEMFAIL);
+    }
+    H264SwDecMemset(sched->thread, 0, numThreads * sizeof(schedThread_t));
+
+    pthread_mutex_init(&sched->mutex, NULL);
+    pthread_cond_init(&sched->workReady, NULL);
+    for (i = 0; i < numThreads; i++)
+    {
+        sched->thread[i].sched = sched;
+        sched->thread[i].index = i;
+        pthread_mutex_init(&sched->thread[i].mutex, NULL);
+    }
+
+    /* threads created so far are shut down if creation fails */
+    for (i = 0; i < numThreads; i++)
+    {
+        if (pthread_create(&sched->thread[i].thread, NULL, PoolThread,
+                sched->thread + i))
+            break;
+        sched->numThreads++;
+    }
+    if (sched->numThreads < numThreads)
+    {
+        H264SwDecSchedRelease(sched);
+        return(H264SWDEC_INITFAIL);
+    }
+
+    *schedInst = sched;
+
+    return(H264SWDEC_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: H264SwDecSchedRelease
+
+        Functional description:
+            Shut down the pool threads and free the scheduler. All streams
+            shall have been removed.
+
+        Inputs:
+            schedInst   scheduler instance
+
+        Outputs:
+            none
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void H264SwDecSchedRelease(H264SwDecSchedInst schedInst)
+{
+
+/* Variables */
+
+    u32 i;
+    scheduler_t *sched;
+
+/* Code */
+
+    if (schedInst == NULL)
+        return;
+
+    sched = (scheduler_t*)schedInst;
+
+    pthread_mutex_lock(&sched->mutex);
+    sched->quit = HANTRO_TRUE;
+    pthread_cond_broadcast(&sched->workReady);
+    pthread_mutex_unlock(&sched->mutex);
+
+    for (i = 0; i < sched->numThreads; i++)
+        pthread_join(sched->thread[i].thread, NULL);
+
+    for (i = 0; i < sched->numThreads; i++)
+        pthread_mutex_destroy(&sched->thread[i].mutex);
+    pthread_cond_destroy(&sched->workReady);
+    pthread_mutex_destroy(&sched->mutex);
+
+    H264SwDecFree(sched->thread);
+    H264SwDecFree(sched);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: H264SwDecSchedAddStream
+
+        Functional description:
+            Add a decoder instance to the scheduler. New streams are given
+            home pool threads in turns.
+
+        Inputs:
+            schedInst   scheduler instance
+            decInst     initialized decoder instance
+            priority    priority of the stream, streams with higher value
+                        are decoded first
+            pCallbacks  callbacks of the stream, pictureReady and inputDone
+                        may be NULL
+
+        Outputs:
+            streamInst  pointer to the stream instance is stored here
+
+        Returns:
+            H264SWDEC_OK            success
+            H264SWDEC_PARAM_ERR     invalid parameters
+            H264SWDEC_MEMFAIL       memory allocation failed
+
+------------------------------------------------------------------------------*/
+
+H264SwDecRet H264SwDecSchedAddStream(H264SwDecSchedInst schedInst,
+    H264SwDecInst decInst, u32 priority, H264SwDecStreamCallbacks *pCallbacks,
+    H264SwDecStreamInst *streamInst)
+{
+
+/* Variables */
+
+    scheduler_t *sched;
+    schedStream_t *stream;
+
+/* Code */
+
+    if (schedInst == NULL || decInst == NULL || pCallbacks == NULL ||
+        streamInst == NULL)
+        return(H264SWDEC_PARAM_ERR);
+
+    sched = (scheduler_t*)schedInst;
+
+    stream = (schedStream_t*)H264SwDecMalloc(sizeof(schedStream_t), 1);
+    if (stream == NULL)
+        return(H264SWDEC_MEMFAIL);
+    H264SwDecMemset(stream, 0, sizeof(schedStream_t));
+
+    stream->input = (H264SwDecInput*)H264SwDecMalloc(sizeof(H264SwDecInput),
+        SCHED_INITIAL_INPUTS);
+    if (stream->input == NULL)
+    {
+        H264SwDecFree(stream);
+        return(H264SWDEC_MEMFAIL);
+    }
+    stream->inputSize = SCHED_INITIAL_INPUTS;
+
+    stream->sched = sched;
+    stream->decInst = decInst;
+    stream->callbacks = *pCallbacks;
+    stream->priority = priority;
+    stream->state = STREAM_IDLE;
+    pthread_mutex_init(&stream->mutex, NULL);
+    pthread_cond_init(&stream->idle, NULL);
+
+    pthread_mutex_lock(&sched->mutex);
+    stream->home = sched->nextHome;
+    sched->nextHome = (sched->nextHome + 1) % sched->numThreads;
+    pthread_mutex_unlock(&sched->mutex);
+
+    *streamInst = stream;
+
+    return(H264SWDEC_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: H264SwDecSchedRemoveStream
+
+        Functional description:
+            Wait until the inputs submitted for the stream have been decoded
+            and remove the stream from the scheduler. Pictures still
+            buffered in the decoder are not output, see H264SwDecSchedFlush.
+            The decoder instance may be used directly or released afterwards.
+
+        Inputs:
+            streamInst  stream instance
+
+        Outputs:
+            none
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void H264SwDecSchedRemoveStream(H264SwDecStreamInst streamInst)
+{
+
+/* Variables */
+
+    schedStream_t *stream;
+
+/* Code */
+
+    if (streamInst == NULL)
+        return;
+
+    stream = (schedStream_t*)streamInst;
+
+    (void)H264SwDecSchedFlush(stream, HANTRO_FALSE);
+
+    pthread_cond_destroy(&stream->idle);
+    pthread_mutex_destroy(&stream->mutex);
+    H264SwDecFree(stream->input);
+    H264SwDecFree(stream);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: H264SwDecSchedSetPriority
+
+        Functional description:
+            Change the priority of a stream, e.g. when the stream gets or
+            loses focus. Takes effect when the stream is next picked from
+            a run queue.
+
+        Inputs:
+            streamInst  stream instance
+            priority    new priority, streams with higher value are decoded
+                        first
+
+        Outputs:
+            none
+
+        Returns:
+            H264SWDEC_OK            success
+            H264SWDEC_PARAM_ERR     invalid parameters
+
+------------------------------------------------------------------------------*/
+
+H264SwDecRet H264SwDecSchedSetPriority(H264SwDecStreamInst streamInst,
+    u32 priority)
+{
+
+/* Code */
+
+    if (streamInst == NULL)
+        return(H264SWDEC_PARAM_ERR);
+
+    __atomic_store_n(&((schedStream_t*)streamInst)->priority, priority,
+        __ATOMIC_RELAXED);
+
+    return(H264SWDEC_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: H264SwDecSchedSubmit
+
+        Functional description:
+            Queue stream data for decoding, normally one access unit. Inputs
+            of a stream are decoded in the order submitted, the input is
+            decoded as a whole as with repeated H264SwDecDecode calls. The
+            decoder modifies the stream data, which shall remain valid until
+            inputDone has been called for the input. Returns immediately, an
+            idle stream is queued to the run queue of its home thread.
+
+        Inputs:
+            streamInst  stream instance
+            pInput      input to be decoded, the structure is copied
+
+        Outputs:
+            none
+
+        Returns:
+            H264SWDEC_OK            success
+            H264SWDEC_PARAM_ERR     invalid parameters
+            H264SWDEC_MEMFAIL       memory allocation failed
+
+------------------------------------------------------------------------------*/
+
+H264SwDecRet H264SwDecSchedSubmit(H264SwDecStreamInst streamInst,
+    H264SwDecInput *pInput)
+{
+
+/* Variables */
+
+    u32 i, size;
+    schedStream_t *stream;
+    H264SwDecInput *input;
+
+/* Code */
+
+    if (streamInst == NULL || pInput == NULL || pInput->pStream == NULL ||
+        pInput->dataLen == 0)
+        return(H264SWDEC_PARAM_ERR);
+
+    stream = (schedStream_t*)streamInst;
+
+    pthread_mutex_lock(&stream->mutex);
+
+    if (stream->numInputs == stream->inputSize)
+    {
+        size = 2 * stream->inputSize;
+        input = (H264SwDecInput*)H264SwDecMalloc(sizeof(H264SwDecInput),
+            size);
+        if (input == NULL)
+        {
+            pthread_mutex_unlock(&stream->mutex);
+            return(H264SWDEC_MEMFAIL);
+        }
+        for (i = 0; i < stream->numInputs; i++)
+            input[i] = stream->input[(stream->inputHead + i) %
+                stream->inputSize];
+        H264SwDecFree(stream->input);
+        stream->input = input;
+        stream->inputSize = size;
+        stream->inputHead = 0;
+    }
+
+    stream->input[(stream->inputHead + stream->numInputs) %
+        stream->inputSize] = *pInput;
+    stream->numInputs++;
+
+    /* queued or running stream is picked again when the current input has
+     * been decoded */
+    if (stream->state == STREAM_IDLE)
+    {
+        stream->state = STREAM_QUEUED;
+        QueueStream(stream);
+    }
+
+    pthread_mutex_unlock(&stream->mutex);
+
+    return(H264SWDEC_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: H264SwDecSchedFlush
+
+        Functional description:
+            Wait until the inputs submitted for the stream have been
+            decoded. At the end of the stream the pictures buffered in the
+            decoder are then output by the calling thread, inputs shall not
+            be submitted meanwhile.
+
+        Inputs:
+            streamInst  stream instance
+            endOfStream flag to output all buffered pictures
+
+        Outputs:
+            none
+
+        Returns:
+            H264SWDEC_OK            success
+            H264SWDEC_PARAM_ERR     invalid parameters
+
+------------------------------------------------------------------------------*/
+
+H264SwDecRet H264SwDecSchedFlush(H264SwDecStreamInst streamInst,
+    u32 endOfStream)
+{
+
+/* Variables */
+
+    schedStream_t *stream;
+
+/* Code */
+
+    if (streamInst == NULL)
+        return(H264SWDEC_PARAM_ERR);
+
+    stream = (schedStream_t*)streamInst;
+
+    pthread_mutex_lock(&stream->mutex);
+    while (stream->state != STREAM_IDLE)
+        pthread_cond_wait(&stream->idle, &stream->mutex);
+    pthread_mutex_unlock(&stream->mutex);
+
+    if (endOfStream)
+        OutputPictures(stream, HANTRO_TRUE);
+
+    return(H264SWDEC_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: PoolThread
+
+        Functional description:
+            Pool thread main loop, decode one input of a queued stream at a
+            time until the scheduler is released.
+
+------------------------------------------------------------------------------*/
+
+void *PoolThread(void *arg)
+{
+
+/* Variables */
+
+    schedThread_t *thread;
+    scheduler_t *sched;
+    schedStream_t *stream;
+
+/* Code */
+
+    thread = (schedThread_t*)arg;
+    sched = thread->sched;
+
+    for (;;)
+    {
+        if ((stream = TakeStream(sched, thread->index)) != NULL)
+        {
+            RunStream(stream, thread->index);
+            continue;
+        }
+
+        /* queued count is checked with the mutex locked, see QueueStream */
+        pthread_mutex_lock(&sched->mutex);
+        while (!sched->quit &&
+               !__atomic_load_n(&sched->numQueued, __ATOMIC_SEQ_CST))
+        {
+            sched->numIdle++;
+            pthread_cond_wait(&sched->workReady, &sched->mutex);
+            sched->numIdle--;
+        }
+        if (sched->quit)
+        {
+            pthread_mutex_unlock(&sched->mutex);
+            break;
+        }
+        pthread_mutex_unlock(&sched->mutex);
+    }
+
+    return(NULL);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: TakeStream
+
+        Functional description:
+            Take the queued stream with the highest priority from the run
+            queues. Streams of the own queue are preferred over equal
+            priority streams of the other queues, which are stolen only
+            when the own queue has nothing better. Streams of equal priority
+            are taken in queuing order.
+
+        Returns:
+            pointer to the stream, NULL if none queued or the stream was
+            taken by another thread meanwhile
+
+------------------------------------------------------------------------------*/
+
+schedStream_t *TakeStream(scheduler_t *sched, u32 self)
+{
+
+/* Variables */
+
+    u32 i, j, priority, best, bestPriority;
+    schedThread_t *thread;
+    schedStream_t *stream, *prev, *bestStream, *bestPrev;
+
+/* Code */
+
+    if (!__atomic_load_n(&sched->numQueued, __ATOMIC_SEQ_CST))
+        return(NULL);
+
+    /* find the queue having the highest priority stream, own queue first */
+    best = sched->numThreads;
+    bestPriority = 0;
+    for (i = 0; i < sched->numThreads; i++)
+    {
+        j = (self + i) % sched->numThreads;
+        thread = sched->thread + j;
+        pthread_mutex_lock(&thread->mutex);
+        for (stream = thread->head; stream != NULL; stream = stream->next)
+        {
+            priority = __atomic_load_n(&stream->priority, __ATOMIC_RELAXED);
+            if (best == sched->numThreads || priority > bestPriority)
+            {
+                best = j;
+                bestPriority = priority;
+            }
+        }
+        pthread_mutex_unlock(&thread->mutex);
+    }
+    if (best == sched->numThreads)
+        return(NULL);
+
+    /* queue may have changed meanwhile, take its best stream anyway */
+    thread = sched->thread + best;
+    pthread_mutex_lock(&thread->mutex);
+    bestStream = bestPrev = NULL;
+    bestPriority = 0;
+    for (prev = NULL, stream = thread->head; stream != NULL;
+         prev = stream, stream = stream->next)
+    {
+        priority = __atomic_load_n(&stream->priority, __ATOMIC_RELAXED);
+        if (bestStream == NULL || priority > bestPriority)
+        {
+            bestStream = stream;
+            bestPrev = prev;
+            bestPriority = priority;
+        }
+    }
+    if (bestStream != NULL)
+    {
+        if (bestPrev != NULL)
+            bestPrev->next = bestStream->next;
+        else
+            thread->head = bestStream->next;
+        if (thread->tail == bestStream)
+            thread->tail = bestPrev;
+        bestStream->next = NULL;
+        (void)__atomic_sub_fetch(&sched->numQueued, 1, __ATOMIC_SEQ_CST);
+    }
+    pthread_mutex_unlock(&thread->mutex);
+
+    return(bestStream);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: RunStream
+
+        Functional description:
+            Decode the first submitted input of a stream taken from a run
+            queue. The stream is then queued again to the run queue of the
+            calling thread if it has more inputs, so that streams of higher
+            priority submitted meanwhile get decoded first.
+
+------------------------------------------------------------------------------*/
+
+void RunStream(schedStream_t *stream, u32 self)
+{
+
+/* Variables */
+
+    H264SwDecInput input;
+    H264SwDecRet result;
+
+/* Code */
+
+    pthread_mutex_lock(&stream->mutex);
+    input = stream->input[stream->inputHead];
+    stream->inputHead = (stream->inputHead + 1) % stream->inputSize;
+    stream->numInputs--;
+    stream->state = STREAM_RUNNING;
+    pthread_mutex_unlock(&stream->mutex);
+
+    result = DecodeInput(stream, &input);
+    if (stream->callbacks.inputDone != NULL)
+        stream->callbacks.inputDone(stream->callbacks.pUserData, &input,
+            result);
+
+    pthread_mutex_lock(&stream->mutex);
+    stream->home = self;
+    if (stream->numInputs)
+    {
+        stream->state = STREAM_QUEUED;
+        QueueStream(stream);
+    }
+    else
+    {
+        stream->state = STREAM_IDLE;
+        pthread_cond_broadcast(&stream->idle);
+    }
+    pthread_mutex_unlock(&stream->mutex);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: QueueStream
+
+        Functional description:
+            Append a stream to the run queue of its home thread and wake up
+            an idle pool thread, if any. Called with the mutex of the stream
+            locked. The queued count is incremented before the idle count is
+            checked, a thread going idle checks the queued count after
+            incrementing the idle count, both with the scheduler mutex
+            locked, so no wakeup is lost.
+
+------------------------------------------------------------------------------*/
+
+void QueueStream(schedStream_t *stream)
+{
+
+/* Variables */
+
+    scheduler_t *sched;
+    schedThread_t *thread;
+
+/* Code */
+
+    sched = stream->sched;
+    thread = sched->thread + stream->home;
+
+    pthread_mutex_lock(&thread->mutex);
+    stream->next = NULL;
+    if (thread->tail != NULL)
+        thread->tail->next = stream;
+    else
+        thread->head = stream;
+    thread->tail = stream;
+    (void)__atomic_add_fetch(&sched->numQueued, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&thread->mutex);
+
+    pthread_mutex_lock(&sched->mutex);
+    if (sched->numIdle)
+        pthread_cond_signal(&sched->workReady);
+    pthread_mutex_unlock(&sched->mutex);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: DecodeInput
+
+        Functional description:
+            Decode an input of a stream until all of its data has been
+            consumed, pictures are output as they become ready.
+
+        Returns:
+            H264SWDEC_PIC_RDY           a picture was decoded
+            H264SWDEC_STRM_PROCESSED    data decoded, no picture finished
+            error code of H264SwDecDecode if decoding of some data failed
+            and no picture was finished
+
+------------------------------------------------------------------------------*/
+
+H264SwDecRet DecodeInput(schedStream_t *stream, H264SwDecInput *pInput)
+{
+
+/* Variables */
+
+    u32 consumed;
+    H264SwDecInput input;
+    H264SwDecOutput output;
+    H264SwDecRet ret, result;
+
+/* Code */
+
+    input = *pInput;
+    result = H264SWDEC_STRM_PROCESSED;
+
+    while (input.dataLen)
+    {
+        output.pStrmCurrPos = input.pStream;
+        ret = H264SwDecDecode(stream->decInst, &input, &output);
+
+        switch (ret)
+        {
+            case H264SWDEC_PIC_RDY:
+            case H264SWDEC_PIC_RDY_BUFF_NOT_EMPTY:
+                OutputPictures(stream, HANTRO_FALSE);
+                result = H264SWDEC_PIC_RDY;
+                break;
+
+            case H264SWDEC_HDRS_RDY_BUFF_NOT_EMPTY:
+            case H264SWDEC_STRM_PROCESSED:
+                break;
+
+            default:
+                if (result != H264SWDEC_PIC_RDY)
+                    result = ret;
+                break;
+        }
+
+        consumed = output.pStrmCurrPos >= input.pStream &&
+                   output.pStrmCurrPos <= input.pStream + input.dataLen ?
+                   (u32)(output.pStrmCurrPos - input.pStream) : input.dataLen;
+
+        /* decoder did not advance, e.g. invalid parameters -> input
+         * dropped. Buffer not empty returns resume at the same position */
+        if (!consumed && ret != H264SWDEC_PIC_RDY_BUFF_NOT_EMPTY &&
+            ret != H264SWDEC_HDRS_RDY_BUFF_NOT_EMPTY)
+            break;
+
+        input.pStream += consumed;
+        input.dataLen -= consumed;
+    }
+
+    return(result);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: OutputPictures
+
+        Functional description:
+            Pass the pictures ready for display to the stream callback.
+
+------------------------------------------------------------------------------*/
+
+void OutputPictures(schedStream_t *stream, u32 flushBuffer)
+{
+
+/* Variables */
+
+    H264SwDecPicture picture;
+
+/* Code */
+
+    while (H264SwDecNextPicture(stream->decInst, &picture, flushBuffer) ==
+           H264SWDEC_PIC_RDY)
+    {
+        if (stream->callbacks.pictureReady != NULL)
+            stream->callbacks.pictureReady(stream->callbacks.pUserData,
+                &picture);
+    }
+
+}
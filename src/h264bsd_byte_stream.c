@@ -33,6 +33,7 @@
 
 #include "h264bsd_byte_stream.h"
 #include "h264bsd_util.h"
+#include "h264bsd_simd.h"
 
 /*------------------------------------------------------------------------------
     2. External compiler flags
@@ -48,6 +49,10 @@
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
 
+#ifdef H264DEC_SIMD
+static u32 SkipToZeroPair(const u8 *pStrm, u32 len);
+#endif
+
 /*------------------------------------------------------------------------------
 
     Function name: ExtractNalUnit
@@ -135,6 +140,21 @@ u32 h264bsdExtractNalUnit(u8 *pByteStream, u32 len, strmData_t *pStrmData,
         /*lint -e(716) while(1) used consciously */
         while (1)
         {
+#ifdef H264DEC_SIMD
+            /* start code prefixes and emulation prevention sequences both
+             * begin with two zero bytes -> jump directly to the next such
+             * pair */
+            if (!zeroCount)
+            {
+                tmp = SkipToZeroPair(readPtr, len - byteCount);
+                if (tmp)
+                {
+                    readPtr += tmp;
+                    byteCount += tmp;
+                    zeroCount = (readPtr[-1] == 0x00) ? 1 : 0;
+                }
+            }
+#endif
             byte = *readPtr++;
             byteCount++;
             if (!byte)
@@ -197,6 +217,23 @@ u32 h264bsdExtractNalUnit(u8 *pByteStream, u32 len, strmData_t *pStrmData,
         zeroCount = 0;
         for (i = tmp; i--;)
         {
+#ifdef H264DEC_SIMD
+            /* copy runs without a pair of zero bytes as a whole, nothing
+             * needs to be moved before the first emulation prevention byte */
+            if (!zeroCount)
+            {
+                u32 run = SkipToZeroPair(readPtr, i + 1);
+                if (run)
+                {
+                    if (writePtr != readPtr)
+                        memmove(writePtr, readPtr, run);
+                    readPtr += run;
+                    writePtr += run;
+                    i -= run;
+                    zeroCount = (readPtr[-1] == 0x00) ? 1 : 0;
+                }
+            }
+#endif
             if ((zeroCount == 2) && (*readPtr == 0x03))
             {
                 /* emulation prevention byte shall be followed by one of the
@@ -235,3 +272,53 @@ u32 h264bsdExtractNalUnit(u8 *pByteStream, u32 len, strmData_t *pStrmData,
 
 }
 
+#ifdef H264DEC_SIMD
+/*------------------------------------------------------------------------------
+
+    Function name: SkipToZeroPair
+
+        Functional description:
+            Find the first position in the buffer where two consecutive
+            zero bytes start. The buffer is examined 16 bytes at a time and
+            only as long as at least 17 bytes are available, so at least one
+            byte at the end of the buffer is always left for the caller.
+
+        Inputs:
+            pStrm       pointer to the buffer
+            len         number of bytes available
+
+        Outputs:
+            none
+
+        Returns:
+            number of bytes that can be skipped, i.e. none of them starts a
+            pair of zero bytes
+
+------------------------------------------------------------------------------*/
+
+static u32 SkipToZeroPair(const u8 *pStrm, u32 len)
+{
+
+/* Variables */
+
+    u32 count = 0, pos;
+    v16u8 curr, next, pair;
+
+/* Code */
+
+    while (count + 17 <= len)
+    {
+        curr = h264bsdLoad16(pStrm + count);
+        next = h264bsdLoad16(pStrm + count + 1);
+        pair = (v16u8)((curr == 0) & (next == 0));
+
+        pos = h264bsdFirstSetByte(pair);
+        count += pos;
+        if (pos < 16)
+            break;
+    }
+
+    return(count);
+
+}
+#endif
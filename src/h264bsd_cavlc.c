@@ -67,62 +67,225 @@
 
 #define VLC_NOT_FOUND 0xFFFFFFFEU
 
-/* VLC tables for coeff_token. Because of long codes (max. 16 bits) some of the
- * tables have been splitted into multiple separate tables. Each array/table
- * element has the following structure:
+/* value of the length field of coeff token information word marking an
+ * escape to the second level table, offset to the table on bits [5,15] */
+#define ESCAPE_TC 0x1F
+/* macro to obtain escape table offset from the coeff token information word */
+#define ESCAPE_OFFSET(coeffToken) ((coeffToken) >> 5)
+
+/* VLC tables for coeff_token. Each table is indexed with the first 9 bits
+ * (8 bits for nC == -1) of the code word so that all but the longest codes
+ * are resolved with a single look-up. Codes longer than that are marked with
+ * ESCAPE_TC in the length field, remaining bits of the element give offset
+ * to the escape table which is then indexed with the next bits of the code
+ * word. Each array/table element has the following structure:
  * [5 bits for tot.coeff.] [6 bits for tr.ones] [5 bits for VLC length]
  * If there is a 0x0000 value, it means that there is not corresponding VLC
  * codeword for that index. */
 
-/* VLC lengths up to 6 bits, 0 <= nC < 2 */
-static const u16 coeffToken0_0[32] = {
-    0x0000,0x0000,0x0000,0x2066,0x1026,0x0806,0x1865,0x1865,
+/* first 9 bits, 0 <= nC < 2 */
+static const u16 coeffToken0[512] = {
+    0x001f,0x101f,0x201f,0x301f,0x3869,0x2849,0x2029,0x1809,
+    0x3068,0x3068,0x2048,0x2048,0x1828,0x1828,0x1008,0x1008,
+    0x2867,0x2867,0x2867,0x2867,0x1847,0x1847,0x1847,0x1847,
+    0x2066,0x2066,0x2066,0x2066,0x2066,0x2066,0x2066,0x2066,
+    0x1026,0x1026,0x1026,0x1026,0x1026,0x1026,0x1026,0x1026,
+    0x0806,0x0806,0x0806,0x0806,0x0806,0x0806,0x0806,0x0806,
+    0x1865,0x1865,0x1865,0x1865,0x1865,0x1865,0x1865,0x1865,
+    0x1865,0x1865,0x1865,0x1865,0x1865,0x1865,0x1865,0x1865,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
     0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
     0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
-    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822};
-
-/* VLC lengths up to 10 bits, 0 <= nC < 2 */
-static const u16 coeffToken0_1[48] = {
-    0x0000,0x0000,0x0000,0x0000,0x406a,0x304a,0x282a,0x200a,
-    0x3869,0x3869,0x2849,0x2849,0x2029,0x2029,0x1809,0x1809,
-    0x3068,0x3068,0x3068,0x3068,0x2048,0x2048,0x2048,0x2048,
-    0x1828,0x1828,0x1828,0x1828,0x1008,0x1008,0x1008,0x1008,
-    0x2867,0x2867,0x2867,0x2867,0x2867,0x2867,0x2867,0x2867,
-    0x1847,0x1847,0x1847,0x1847,0x1847,0x1847,0x1847,0x1847};
-
-/* VLC lengths up to 14 bits, 0 <= nC < 2 */
-static const u16 coeffToken0_2[56] = {
-    0x606e,0x584e,0x502e,0x500e,0x586e,0x504e,0x482e,0x480e,
-    0x400d,0x400d,0x484d,0x484d,0x402d,0x402d,0x380d,0x380d,
-    0x506d,0x506d,0x404d,0x404d,0x382d,0x382d,0x300d,0x300d,
-    0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,
-    0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,
-    0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,
-    0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b};
-
-/* VLC lengths up to 16 bits, 0 <= nC < 2 */
-static const u16 coeffToken0_3[32] = {
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,
+    0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001};
+
+/* next 7 bits of escaped codes, 0 <= nC < 2 */
+static const u16 coeffToken0Esc[512] = {
     0x0000,0x0000,0x682f,0x682f,0x8010,0x8050,0x8030,0x7810,
     0x8070,0x7850,0x7830,0x7010,0x7870,0x7050,0x7030,0x6810,
     0x706f,0x706f,0x684f,0x684f,0x602f,0x602f,0x600f,0x600f,
-    0x686f,0x686f,0x604f,0x604f,0x582f,0x582f,0x580f,0x580f};
-
-/* VLC lengths up to 6 bits, 2 <= nC < 4 */
-static const u16 coeffToken2_0[32] = {
-    0x0000,0x0000,0x0000,0x0000,0x3866,0x2046,0x2026,0x1006,
-    0x3066,0x1846,0x1826,0x0806,0x2865,0x2865,0x1025,0x1025,
-    0x2064,0x2064,0x2064,0x2064,0x1864,0x1864,0x1864,0x1864,
-    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043};
-
-/* VLC lengths up to 9 bits, 2 <= nC < 4 */
-static const u16 coeffToken2_1[32] = {
-    0x0000,0x0000,0x0000,0x0000,0x4869,0x3849,0x3829,0x3009,
+    0x686f,0x686f,0x604f,0x604f,0x582f,0x582f,0x580f,0x580f,
+    0x606e,0x606e,0x606e,0x606e,0x584e,0x584e,0x584e,0x584e,
+    0x502e,0x502e,0x502e,0x502e,0x500e,0x500e,0x500e,0x500e,
+    0x586e,0x586e,0x586e,0x586e,0x504e,0x504e,0x504e,0x504e,
+    0x482e,0x482e,0x482e,0x482e,0x480e,0x480e,0x480e,0x480e,
+    0x400d,0x400d,0x400d,0x400d,0x400d,0x400d,0x400d,0x400d,
+    0x484d,0x484d,0x484d,0x484d,0x484d,0x484d,0x484d,0x484d,
+    0x402d,0x402d,0x402d,0x402d,0x402d,0x402d,0x402d,0x402d,
+    0x380d,0x380d,0x380d,0x380d,0x380d,0x380d,0x380d,0x380d,
+    0x506d,0x506d,0x506d,0x506d,0x506d,0x506d,0x506d,0x506d,
+    0x404d,0x404d,0x404d,0x404d,0x404d,0x404d,0x404d,0x404d,
+    0x382d,0x382d,0x382d,0x382d,0x382d,0x382d,0x382d,0x382d,
+    0x300d,0x300d,0x300d,0x300d,0x300d,0x300d,0x300d,0x300d,
+    0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,
+    0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,
+    0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,
+    0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,0x486b,
+    0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,
+    0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,
+    0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,
+    0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,0x384b,
+    0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,
+    0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,
+    0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,
+    0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,0x302b,
+    0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,
+    0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,
+    0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,
+    0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,0x280b,
+    0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,
+    0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,
+    0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,
+    0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,
+    0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,
+    0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,
+    0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,
+    0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,0x406a,
+    0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,
+    0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,
+    0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,
+    0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,
+    0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,
+    0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,
+    0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,
+    0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,0x304a,
+    0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,
+    0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,
+    0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,
+    0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,
+    0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,
+    0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,
+    0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,
+    0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,0x282a,
+    0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,
+    0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,
+    0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,
+    0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,
+    0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,
+    0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,
+    0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,
+    0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a,0x200a};
+
+/* first 9 bits, 2 <= nC < 4 */
+static const u16 coeffToken2[512] = {
+    0x001f,0x041f,0x081f,0x0c1f,0x4869,0x3849,0x3829,0x3009,
     0x2808,0x2808,0x3048,0x3048,0x3028,0x3028,0x2008,0x2008,
     0x4067,0x4067,0x4067,0x4067,0x2847,0x2847,0x2847,0x2847,
-    0x2827,0x2827,0x2827,0x2827,0x1807,0x1807,0x1807,0x1807};
-
-/* VLC lengths up to 14 bits, 2 <= nC < 4 */
-static const u16 coeffToken2_2[128] = {
+    0x2827,0x2827,0x2827,0x2827,0x1807,0x1807,0x1807,0x1807,
+    0x3866,0x3866,0x3866,0x3866,0x3866,0x3866,0x3866,0x3866,
+    0x2046,0x2046,0x2046,0x2046,0x2046,0x2046,0x2046,0x2046,
+    0x2026,0x2026,0x2026,0x2026,0x2026,0x2026,0x2026,0x2026,
+    0x1006,0x1006,0x1006,0x1006,0x1006,0x1006,0x1006,0x1006,
+    0x3066,0x3066,0x3066,0x3066,0x3066,0x3066,0x3066,0x3066,
+    0x1846,0x1846,0x1846,0x1846,0x1846,0x1846,0x1846,0x1846,
+    0x1826,0x1826,0x1826,0x1826,0x1826,0x1826,0x1826,0x1826,
+    0x0806,0x0806,0x0806,0x0806,0x0806,0x0806,0x0806,0x0806,
+    0x2865,0x2865,0x2865,0x2865,0x2865,0x2865,0x2865,0x2865,
+    0x2865,0x2865,0x2865,0x2865,0x2865,0x2865,0x2865,0x2865,
+    0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,
+    0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,
+    0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,
+    0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,
+    0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,
+    0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,
+    0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,
+    0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,
+    0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,
+    0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,0x0822,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002};
+
+/* next 5 bits of escaped codes, 2 <= nC < 4 */
+static const u16 coeffToken2Esc[128] = {
     0x0000,0x0000,0x786d,0x786d,0x806e,0x804e,0x802e,0x800e,
     0x782e,0x780e,0x784e,0x702e,0x704d,0x704d,0x700d,0x700d,
     0x706d,0x706d,0x684d,0x684d,0x682d,0x682d,0x680d,0x680d,
@@ -140,35 +303,77 @@ static const u16 coeffToken2_2[128] = {
     0x402b,0x402b,0x402b,0x402b,0x402b,0x402b,0x402b,0x402b,
     0x380b,0x380b,0x380b,0x380b,0x380b,0x380b,0x380b,0x380b};
 
-/* VLC lengths up to 6 bits, 4 <= nC < 8 */
-static const u16 coeffToken4_0[64] = {
-    0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,
-    0x1806,0x3846,0x3826,0x1006,0x4866,0x3046,0x3026,0x0806,
-    0x2825,0x2825,0x2845,0x2845,0x2025,0x2025,0x2045,0x2045,
-    0x1825,0x1825,0x4065,0x4065,0x1845,0x1845,0x1025,0x1025,
-    0x3864,0x3864,0x3864,0x3864,0x3064,0x3064,0x3064,0x3064,
-    0x2864,0x2864,0x2864,0x2864,0x2064,0x2064,0x2064,0x2064,
-    0x1864,0x1864,0x1864,0x1864,0x1044,0x1044,0x1044,0x1044,
-    0x0824,0x0824,0x0824,0x0824,0x0004,0x0004,0x0004,0x0004};
-
-/* VLC lengths up to 10 bits, 4 <= nC < 8 */
-static const u16 coeffToken4_1[128] = {
+/* first 9 bits, 4 <= nC < 8 */
+static const u16 coeffToken4[512] = {
+    0x001f,0x005f,0x009f,0x00df,0x011f,0x015f,0x019f,0x6829,
+    0x6009,0x6849,0x6029,0x5809,0x6869,0x6049,0x5829,0x5009,
+    0x6068,0x6068,0x5848,0x5848,0x5028,0x5028,0x4808,0x4808,
+    0x5868,0x5868,0x5048,0x5048,0x4828,0x4828,0x4008,0x4008,
+    0x3807,0x3807,0x3807,0x3807,0x3007,0x3007,0x3007,0x3007,
+    0x4847,0x4847,0x4847,0x4847,0x2807,0x2807,0x2807,0x2807,
+    0x5067,0x5067,0x5067,0x5067,0x4047,0x4047,0x4047,0x4047,
+    0x4027,0x4027,0x4027,0x4027,0x2007,0x2007,0x2007,0x2007,
+    0x1806,0x1806,0x1806,0x1806,0x1806,0x1806,0x1806,0x1806,
+    0x3846,0x3846,0x3846,0x3846,0x3846,0x3846,0x3846,0x3846,
+    0x3826,0x3826,0x3826,0x3826,0x3826,0x3826,0x3826,0x3826,
+    0x1006,0x1006,0x1006,0x1006,0x1006,0x1006,0x1006,0x1006,
+    0x4866,0x4866,0x4866,0x4866,0x4866,0x4866,0x4866,0x4866,
+    0x3046,0x3046,0x3046,0x3046,0x3046,0x3046,0x3046,0x3046,
+    0x3026,0x3026,0x3026,0x3026,0x3026,0x3026,0x3026,0x3026,
+    0x0806,0x0806,0x0806,0x0806,0x0806,0x0806,0x0806,0x0806,
+    0x2825,0x2825,0x2825,0x2825,0x2825,0x2825,0x2825,0x2825,
+    0x2825,0x2825,0x2825,0x2825,0x2825,0x2825,0x2825,0x2825,
+    0x2845,0x2845,0x2845,0x2845,0x2845,0x2845,0x2845,0x2845,
+    0x2845,0x2845,0x2845,0x2845,0x2845,0x2845,0x2845,0x2845,
+    0x2025,0x2025,0x2025,0x2025,0x2025,0x2025,0x2025,0x2025,
+    0x2025,0x2025,0x2025,0x2025,0x2025,0x2025,0x2025,0x2025,
+    0x2045,0x2045,0x2045,0x2045,0x2045,0x2045,0x2045,0x2045,
+    0x2045,0x2045,0x2045,0x2045,0x2045,0x2045,0x2045,0x2045,
+    0x1825,0x1825,0x1825,0x1825,0x1825,0x1825,0x1825,0x1825,
+    0x1825,0x1825,0x1825,0x1825,0x1825,0x1825,0x1825,0x1825,
+    0x4065,0x4065,0x4065,0x4065,0x4065,0x4065,0x4065,0x4065,
+    0x4065,0x4065,0x4065,0x4065,0x4065,0x4065,0x4065,0x4065,
+    0x1845,0x1845,0x1845,0x1845,0x1845,0x1845,0x1845,0x1845,
+    0x1845,0x1845,0x1845,0x1845,0x1845,0x1845,0x1845,0x1845,
+    0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,
+    0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,0x1025,
+    0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,
+    0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,
+    0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,
+    0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,0x3864,
+    0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,
+    0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,
+    0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,
+    0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,0x3064,
+    0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,
+    0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,
+    0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,
+    0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,0x2864,
+    0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,
+    0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,
+    0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,
+    0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,0x2064,
+    0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,
+    0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,
+    0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,
+    0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,0x1864,
+    0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,
+    0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,
+    0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,
+    0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,0x1044,
+    0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,
+    0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,
+    0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,
+    0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,0x0824,
+    0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,
+    0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,
+    0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,
+    0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,0x0004,0x0004};
+
+/* next 1 bits of escaped codes, 4 <= nC < 8 */
+static const u16 coeffToken4Esc[14] = {
     0x0000,0x800a,0x806a,0x804a,0x802a,0x780a,0x786a,0x784a,
-    0x782a,0x700a,0x706a,0x704a,0x702a,0x680a,0x6829,0x6829,
-    0x6009,0x6009,0x6849,0x6849,0x6029,0x6029,0x5809,0x5809,
-    0x6869,0x6869,0x6049,0x6049,0x5829,0x5829,0x5009,0x5009,
-    0x6068,0x6068,0x6068,0x6068,0x5848,0x5848,0x5848,0x5848,
-    0x5028,0x5028,0x5028,0x5028,0x4808,0x4808,0x4808,0x4808,
-    0x5868,0x5868,0x5868,0x5868,0x5048,0x5048,0x5048,0x5048,
-    0x4828,0x4828,0x4828,0x4828,0x4008,0x4008,0x4008,0x4008,
-    0x3807,0x3807,0x3807,0x3807,0x3807,0x3807,0x3807,0x3807,
-    0x3007,0x3007,0x3007,0x3007,0x3007,0x3007,0x3007,0x3007,
-    0x4847,0x4847,0x4847,0x4847,0x4847,0x4847,0x4847,0x4847,
-    0x2807,0x2807,0x2807,0x2807,0x2807,0x2807,0x2807,0x2807,
-    0x5067,0x5067,0x5067,0x5067,0x5067,0x5067,0x5067,0x5067,
-    0x4047,0x4047,0x4047,0x4047,0x4047,0x4047,0x4047,0x4047,
-    0x4027,0x4027,0x4027,0x4027,0x4027,0x4027,0x4027,0x4027,
-    0x2007,0x2007,0x2007,0x2007,0x2007,0x2007,0x2007,0x2007};
+    0x782a,0x700a,0x706a,0x704a,0x702a,0x680a};
 
 /* fixed 6 bit length VLC, nC <= 8 */
 static const u16 coeffToken8[64] = {
@@ -181,16 +386,40 @@ static const u16 coeffToken8[64] = {
     0x6806,0x6826,0x6846,0x6866,0x7006,0x7026,0x7046,0x7066,
     0x7806,0x7826,0x7846,0x7866,0x8006,0x8026,0x8046,0x8066};
 
-/* VLC lengths up to 3 bits, nC == -1 */
-static const u16 coeffTokenMinus1_0[8] = {
-    0x0000,0x1043,0x0002,0x0002,0x0821,0x0821,0x0821,0x0821};
-
-/* VLC lengths up to 8 bits, nC == -1 */
-static const u16 coeffTokenMinus1_1[32] = {
+/* first 8 bits, nC == -1 */
+static const u16 coeffTokenMinus1[256] = {
     0x2067,0x2067,0x2048,0x2028,0x1847,0x1847,0x1827,0x1827,
     0x2006,0x2006,0x2006,0x2006,0x1806,0x1806,0x1806,0x1806,
     0x1006,0x1006,0x1006,0x1006,0x1866,0x1866,0x1866,0x1866,
-    0x1026,0x1026,0x1026,0x1026,0x0806,0x0806,0x0806,0x0806};
+    0x1026,0x1026,0x1026,0x1026,0x0806,0x0806,0x0806,0x0806,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,0x1043,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,0x0002,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,
+    0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821,0x0821};
 
 /* VLC tables for total_zeros. One table containing longer code, totalZeros_1,
  * has been broken into two separate tables. Table elements have the
@@ -301,6 +530,31 @@ static const u8 totalZeros_13[8] = {0x03,0x13,0x32,0x32,0x21,0x21,0x21,0x21};
 
 static const u8 totalZeros_14[4] = {0x02,0x12,0x21,0x21};
 
+static const u8 totalZeros_15[2] = {0x01,0x11};
+
+/* VLC tables for total_zeros of chroma DC blocks */
+static const u8 totalZerosChromaDc_1[8] = {
+    0x33,0x23,0x12,0x12,0x01,0x01,0x01,0x01};
+
+static const u8 totalZerosChromaDc_2[8] = {
+    0x22,0x22,0x12,0x12,0x01,0x01,0x01,0x01};
+
+static const u8 totalZerosChromaDc_3[8] = {
+    0x11,0x11,0x11,0x11,0x01,0x01,0x01,0x01};
+
+/* total_zeros tables and number of bits to shift the 9 bit input to get the
+ * table index. Indexed by totalCoeff-1 for luma blocks and by totalCoeff+14
+ * for chroma DC blocks. Zero value from totalZeros_1_0 indicates that the
+ * code word is longer than 5 bits and totalZeros_1_1 has to be used */
+static const u8 * const totalZerosTable[18] = {
+    totalZeros_1_0, totalZeros_2, totalZeros_3, totalZeros_4, totalZeros_5,
+    totalZeros_6, totalZeros_7, totalZeros_8, totalZeros_9, totalZeros_10,
+    totalZeros_11, totalZeros_12, totalZeros_13, totalZeros_14, totalZeros_15,
+    totalZerosChromaDc_1, totalZerosChromaDc_2, totalZerosChromaDc_3};
+
+static const u8 totalZerosShift[18] = {
+    4,3,3,4,4,3,3,3,3,4,5,5,6,7,8,6,6,6};
+
 /* VLC tables for run_before. Table elements have the following structure:
  * [4 bits for info] [4bits for VLC length]
  */
@@ -317,52 +571,13 @@ static const u8 runBefore_2[4] = {0x22,0x12,0x01,0x01};
 
 static const u8 runBefore_1[2] = {0x11,0x01};
 
-/* following four macros are used to handle stream buffer "cache" in the CAVLC
- * decoding function */
-
-/* macro to initialize stream buffer cache, fills the buffer (32 bits) */
-#define BUFFER_INIT(value, bits) \
-{ \
-    (bits) = 32; \
-    (value) = h264bsdShowBits32(pStrmData); \
-}
-
-/* macro to read numBits bits from the buffer, bits will be written to
- * outVal. Refills the buffer if not enough bits left */
-#define BUFFER_SHOW(value, bits, outVal, numBits) \
-{ \
-    if ((bits) < (numBits)) \
-    { \
-        if(h264bsdFlushBits(pStrmData,32-(bits)) == END_OF_STREAM) \
-            return(HANTRO_NOK); \
-        (value) = h264bsdShowBits32(pStrmData); \
-        (bits) = 32; \
-    } \
-    (outVal) = (value) >> (32 - (numBits)); \
-}
-
-/* macro to flush numBits bits from the buffer */
-#define BUFFER_FLUSH(value, bits, numBits) \
-{ \
-    (value) <<= (numBits); \
-    (bits) -= (numBits); \
-}
+/* run_before tables and number of bits to shift the 11 bit input to get the
+ * table index, indexed by zerosLeft-1 */
+static const u8 * const runBeforeTable[6] = {
+    runBefore_1, runBefore_2, runBefore_3, runBefore_4, runBefore_5,
+    runBefore_6};
 
-/* macro to read and flush  numBits bits from the buffer, bits will be written
- * to outVal. Refills the buffer if not enough bits left */
-#define BUFFER_GET(value, bits, outVal, numBits) \
-{ \
-    if ((bits) < (numBits)) \
-    { \
-        if(h264bsdFlushBits(pStrmData,32-(bits)) == END_OF_STREAM) \
-            return(HANTRO_NOK); \
-        (value) = h264bsdShowBits32(pStrmData); \
-        (bits) = 32; \
-    } \
-    (outVal) = (value) >> (32 - (numBits)); \
-    (value) <<= (numBits); \
-    (bits) -= (numBits); \
-}
+static const u8 runBeforeShift[6] = {10,9,9,8,8,8};
 
 /*------------------------------------------------------------------------------
     4. Local function prototypes
@@ -407,37 +622,21 @@ u32 DecodeCoeffToken(u32 bits, u32 nc)
 
     if (nc < 2)
     {
-        if (bits >= 0x8000)
-        {
-            value = 0x0001;
-        }
-        else if (bits >= 0x0C00)
-            value = coeffToken0_0[bits >> 10];
-        else if (bits >= 0x0100)
-            value = coeffToken0_1[bits >> 6];
-        else if (bits >= 0x0020)
-            value = coeffToken0_2[(bits>>2)-8];
-        else
-            value = coeffToken0_3[bits];
+        value = coeffToken0[bits >> 7];
+        if (LENGTH_TC(value) == ESCAPE_TC)
+            value = coeffToken0Esc[ESCAPE_OFFSET(value) + (bits & 0x7F)];
     }
     else if (nc < 4)
     {
-        if (bits >= 0x8000)
-        {
-            value = bits & 0x4000 ? 0x0002 : 0x0822;
-        }
-        else if (bits >= 0x1000)
-            value = coeffToken2_0[bits >> 10];
-        else if (bits >= 0x0200)
-            value = coeffToken2_1[bits >> 7];
-        else
-            value = coeffToken2_2[bits>>2];
+        value = coeffToken2[bits >> 7];
+        if (LENGTH_TC(value) == ESCAPE_TC)
+            value = coeffToken2Esc[ESCAPE_OFFSET(value) + ((bits >> 2) & 0x1F)];
     }
     else if (nc < 8)
     {
-        value = coeffToken4_0[bits >> 10];
-        if (!value)
-            value = coeffToken4_1[bits>>6];
+        value = coeffToken4[bits >> 7];
+        if (LENGTH_TC(value) == ESCAPE_TC)
+            value = coeffToken4Esc[ESCAPE_OFFSET(value) + ((bits >> 6) & 0x1)];
     }
     else if (nc <= 16)
     {
@@ -445,9 +644,7 @@ u32 DecodeCoeffToken(u32 bits, u32 nc)
     }
     else
     {
-        value = coeffTokenMinus1_0[bits >> 13];
-        if (!value)
-            value = coeffTokenMinus1_1[bits>>8];
+        value = coeffTokenMinus1[bits >> 8];
     }
 
     return(value);
@@ -478,41 +675,12 @@ u32 DecodeLevelPrefix(u32 bits)
 
 /* Code */
 
-    if (bits >= 0x8000)
-        numZeros = 0;
-    else if (bits >= 0x4000)
-        numZeros = 1;
-    else if (bits >= 0x2000)
-        numZeros = 2;
-    else if (bits >= 0x1000)
-        numZeros = 3;
-    else if (bits >= 0x0800)
-        numZeros = 4;
-    else if (bits >= 0x0400)
-        numZeros = 5;
-    else if (bits >= 0x0200)
-        numZeros = 6;
-    else if (bits >= 0x0100)
-        numZeros = 7;
-    else if (bits >= 0x0080)
-        numZeros = 8;
-    else if (bits >= 0x0040)
-        numZeros = 9;
-    else if (bits >= 0x0020)
-        numZeros = 10;
-    else if (bits >= 0x0010)
-        numZeros = 11;
-    else if (bits >= 0x0008)
-        numZeros = 12;
-    else if (bits >= 0x0004)
-        numZeros = 13;
-    else if (bits >= 0x0002)
-        numZeros = 14;
-    else if (bits >= 0x0001)
-        numZeros = 15;
-    else /* more than 15 zeros encountered which is an error */
+    /* more than 15 zeros encountered which is an error */
+    if (!bits)
         return(VLC_NOT_FOUND);
 
+    numZeros = COUNT_LEADING_ZEROS(bits) - 16;
+
     return(numZeros);
 
 }
@@ -540,102 +708,17 @@ u32 DecodeTotalZeros(u32 bits, u32 totalCoeff, u32 isChromaDC)
 
 /* Variables */
 
-    u32 value = 0x0;
+    u32 i, value;
 
 /* Code */
 
     ASSERT(totalCoeff);
+    ASSERT(isChromaDC ? totalCoeff < 4 : totalCoeff < 16);
 
-    if (!isChromaDC)
-    {
-        ASSERT(totalCoeff < 16);
-        switch (totalCoeff)
-        {
-            case 1:
-                value = totalZeros_1_0[bits >> 4];
-                if (!value)
-                    value = totalZeros_1_1[bits];
-                break;
-
-            case 2:
-                value = totalZeros_2[bits >> 3];
-                break;
-
-            case 3:
-                value = totalZeros_3[bits >> 3];
-                break;
-
-            case 4:
-                value = totalZeros_4[bits >> 4];
-                break;
-
-            case 5:
-                value = totalZeros_5[bits >> 4];
-                break;
-
-            case 6:
-                value = totalZeros_6[bits >> 3];
-                break;
-
-            case 7:
-                value = totalZeros_7[bits >> 3];
-                break;
-
-            case 8:
-                value = totalZeros_8[bits >> 3];
-                break;
-
-            case 9:
-                value = totalZeros_9[bits >> 3];
-                break;
-
-            case 10:
-                value = totalZeros_10[bits >> 4];
-                break;
-
-            case 11:
-                value = totalZeros_11[bits >> 5];
-                break;
-
-            case 12:
-                value = totalZeros_12[bits >> 5];
-                break;
-
-            case 13:
-                value = totalZeros_13[bits >> 6];
-                break;
-
-            case 14:
-                value = totalZeros_14[bits >> 7];
-                break;
-
-            default: /* case 15 */
-                value = (bits >> 8) ? 0x11 : 0x01;
-                break;
-        }
-    }
-    else
-    {
-        ASSERT(totalCoeff < 4);
-        bits >>= 6;
-        if (bits > 3)
-            value = 0x01;
-        else
-        {
-            if (totalCoeff == 3)
-                value = 0x11;
-            else if (bits > 1)
-            {
-                value = 0x12;
-            }
-            else if (totalCoeff == 2)
-                value = 0x22;
-            else if (bits)
-                value = 0x23;
-            else
-                value = 0x33;
-        }
-    }
+    i = isChromaDC ? totalCoeff + 14 : totalCoeff - 1;
+    value = totalZerosTable[i][bits >> totalZerosShift[i]];
+    if (!value)
+        value = totalZeros_1_1[bits];
 
     return(value);
 
@@ -662,58 +745,27 @@ u32 DecodeRunBefore(u32 bits, u32 zerosLeft)
 
 /* Variables */
 
-    u32 value = 0x0;
+    u32 value, length;
 
 /* Code */
 
-    switch (zerosLeft)
+    if (zerosLeft <= 6)
+        value = runBeforeTable[zerosLeft-1][bits >> runBeforeShift[zerosLeft-1]];
+    else
     {
-        case 1:
-            value = runBefore_1[bits>>10];
-            break;
-
-        case 2:
-            value = runBefore_2[bits>>9];
-            break;
-
-        case 3:
-            value = runBefore_3[bits>>9];
-            break;
-
-        case 4:
-            value = runBefore_4[bits>>8];
-            break;
-
-        case 5:
-            value = runBefore_5[bits>>8];
-            break;
-
-        case 6:
-            value = runBefore_6[bits>>8];
-            break;
-
-        default:
-            if (bits >= 0x100)
-                value = ((7-(bits>>8))<<4)+0x3;
-            else if (bits >= 0x80)
-                value = 0x74;
-            else if (bits >= 0x40)
-                value = 0x85;
-            else if (bits >= 0x20)
-                value = 0x96;
-            else if (bits >= 0x10)
-                value = 0xa7;
-            else if (bits >= 0x8)
-                value = 0xb8;
-            else if (bits >= 0x4)
-                value = 0xc9;
-            else if (bits >= 0x2)
-                value = 0xdA;
-            else if (bits)
-                value = 0xeB;
-            if (INFO(value) > zerosLeft)
-                value = 0;
-            break;
+        /* three bit codes for run_before 0 to 6, longer ones are unary,
+         * code length (4 to 11) determined by the leading zeros */
+        if (bits >= 0x100)
+            value = ((7-(bits>>8))<<4)+0x3;
+        else if (bits)
+        {
+            length = COUNT_LEADING_ZEROS(bits) - 20;
+            value = ((length + 3) << 4) + length;
+        }
+        else
+            value = 0;
+        if (INFO(value) > zerosLeft)
+            value = 0;
     }
 
     return(value);
@@ -759,8 +811,7 @@ u32 h264bsdDecodeResidualBlockCavlc(
     i32 level[16];
     u32 run[16];
     /* stream "cache" */
-    u32 bufferValue;
-    u32 bufferBits;
+    bitCache_t cache;
 
 /* Code */
 
@@ -772,15 +823,14 @@ u32 h264bsdDecodeResidualBlockCavlc(
 
     /* assume that coeffLevel array has been "cleaned" by caller */
 
-    BUFFER_INIT(bufferValue, bufferBits);
+    h264bsdBitCacheInit(pStrmData, &cache);
 
-    /*lint -e774 disable lint warning on always false comparison */
-    BUFFER_SHOW(bufferValue, bufferBits, bit, 16);
-    /*lint +e774 */
+    /* freshly initialized cache holds at least 57 bits */
+    bit = h264bsdBitCacheShow(pStrmData, &cache, 16);
     tmp = DecodeCoeffToken(bit, (u32)nc);
     if (!tmp)
         return(HANTRO_NOK);
-    BUFFER_FLUSH(bufferValue, bufferBits, LENGTH_TC(tmp));
+    h264bsdBitCacheFlush(&cache, LENGTH_TC(tmp));
 
     totalCoeff = TOTAL_COEFF(tmp);
     if (totalCoeff > maxNumCoeff)
@@ -793,7 +843,9 @@ u32 h264bsdDecodeResidualBlockCavlc(
         /* nonzero coefficients: +/- 1 */
         if (trailingOnes)
         {
-            BUFFER_GET(bufferValue, bufferBits, bit, trailingOnes);
+            bit = h264bsdBitCacheGet(pStrmData, &cache, trailingOnes);
+            if (bit == END_OF_STREAM)
+                return(HANTRO_NOK);
             tmp = 1 << (trailingOnes - 1);
             for (; tmp; i++)
             {
@@ -810,34 +862,46 @@ u32 h264bsdDecodeResidualBlockCavlc(
 
         for (; i < totalCoeff; i++)
         {
-            BUFFER_SHOW(bufferValue, bufferBits, bit, 16);
-            levelPrefix = DecodeLevelPrefix(bit);
+            bit = h264bsdBitCacheShow(pStrmData, &cache, 20);
+            if (bit == END_OF_STREAM)
+                return(HANTRO_NOK);
+            levelPrefix = DecodeLevelPrefix(bit >> 4);
             if (levelPrefix == VLC_NOT_FOUND)
                 return(HANTRO_NOK);
-            BUFFER_FLUSH(bufferValue, bufferBits, levelPrefix+1);
 
+            /* level_prefix below 14: prefix, the '1' bit and suffixLength
+             * bits of level_suffix (at most 13+1+6 bits) are all within the
+             * 20 bits shown */
             if (levelPrefix < 14)
-                tmp = suffixLength;
-            else if (levelPrefix == 14)
             {
-                tmp = suffixLength ? suffixLength : 4;
+                tmp = levelPrefix + 1 + suffixLength;
+                levelPrefix = (levelPrefix << suffixLength) +
+                    ((bit >> (20 - tmp)) & ((1 << suffixLength) - 1));
+                h264bsdBitCacheFlush(&cache, tmp);
             }
             else
             {
-                /* setting suffixLength to 1 here corresponds to adding 15
-                 * to levelCode value if levelPrefix == 15 and
-                 * suffixLength == 0 */
-                if (!suffixLength)
-                    suffixLength = 1;
-                tmp = 12;
-            }
+                h264bsdBitCacheFlush(&cache, levelPrefix+1);
+
+                if (levelPrefix == 14)
+                {
+                    tmp = suffixLength ? suffixLength : 4;
+                }
+                else
+                {
+                    /* setting suffixLength to 1 here corresponds to adding 15
+                     * to levelCode value if levelPrefix == 15 and
+                     * suffixLength == 0 */
+                    if (!suffixLength)
+                        suffixLength = 1;
+                    tmp = 12;
+                }
 
-            if (suffixLength)
                 levelPrefix <<= suffixLength;
 
-            if (tmp)
-            {
-                BUFFER_GET(bufferValue, bufferBits, levelSuffix, tmp);
+                levelSuffix = h264bsdBitCacheGet(pStrmData, &cache, tmp);
+                if (levelSuffix == END_OF_STREAM)
+                    return(HANTRO_NOK);
                 levelPrefix += levelSuffix;
             }
 
@@ -861,12 +925,14 @@ u32 h264bsdDecodeResidualBlockCavlc(
         /* zero runs */
         if (totalCoeff < maxNumCoeff)
         {
-            BUFFER_SHOW(bufferValue, bufferBits, bit,9);
+            bit = h264bsdBitCacheShow(pStrmData, &cache, 9);
+            if (bit == END_OF_STREAM)
+                return(HANTRO_NOK);
             zerosLeft = DecodeTotalZeros(bit, totalCoeff,
                                         (u32)(maxNumCoeff == 4));
             if (!zerosLeft)
                 return(HANTRO_NOK);
-            BUFFER_FLUSH(bufferValue, bufferBits, LENGTH(zerosLeft));
+            h264bsdBitCacheFlush(&cache, LENGTH(zerosLeft));
             zerosLeft = INFO(zerosLeft);
         }
         else
@@ -876,11 +942,13 @@ u32 h264bsdDecodeResidualBlockCavlc(
         {
             if (zerosLeft > 0)
             {
-                BUFFER_SHOW(bufferValue, bufferBits, bit,11);
+                bit = h264bsdBitCacheShow(pStrmData, &cache, 11);
+                if (bit == END_OF_STREAM)
+                    return(HANTRO_NOK);
                 tmp = DecodeRunBefore(bit, zerosLeft);
                 if (!tmp)
                     return(HANTRO_NOK);
-                BUFFER_FLUSH(bufferValue, bufferBits, LENGTH(tmp));
+                h264bsdBitCacheFlush(&cache, LENGTH(tmp));
                 run[i] = INFO(tmp);
                 zerosLeft -= run[i]++;
             }
@@ -908,7 +976,7 @@ u32 h264bsdDecodeResidualBlockCavlc(
     else
         levelSuffix = 0;
 
-    if (h264bsdFlushBits(pStrmData, 32-bufferBits) != HANTRO_OK)
+    if (h264bsdBitCacheSync(pStrmData, &cache) != HANTRO_OK)
         return(HANTRO_NOK);
 
     return((totalCoeff << 4) | (levelSuffix << 16));
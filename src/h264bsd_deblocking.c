@@ -23,7 +23,7 @@
      3. Module defines
      4. Local function prototypes
      5. Functions
-          h264bsdFilterPicture
+          h264bsdFilterMbRows
           FilterVerLumaEdge
           FilterHorLumaEdge
           FilterHorLuma
@@ -36,10 +36,17 @@
           IsSliceBoundaryOnLeft
           IsSliceBoundaryOnTop
           GetMbFilteringFlags
+          IsStaticMb
+          IsZeroBsMb
           GetLumaEdgeThresholds
           GetChromaEdgeThresholds
           FilterLuma
           FilterChroma
+          LoadTransposed
+          StoreTransposed
+          EdgeMask
+          FilterLanes
+          FilterEdge
 
 ------------------------------------------------------------------------------*/
 
@@ -52,6 +59,7 @@
 #include "h264bsd_macroblock_layer.h"
 #include "h264bsd_deblocking.h"
 #include "h264bsd_dpb.h"
+#include "h264bsd_simd.h"
 
 #ifdef H264DEC_OMXDL
 #include "omxtypes.h"
@@ -166,6 +174,10 @@ static u32 IsSliceBoundaryOnTop(mbStorage_t *mb);
 
 static u32 GetMbFilteringFlags(mbStorage_t *mb);
 
+static u32 IsStaticMb(mbStorage_t *mb);
+
+static u32 IsZeroBsMb(mbStorage_t *mb, u32 flags);
+
 #ifndef H264DEC_OMXDL
 
 static u32 GetBoundaryStrengths(mbStorage_t *mb, bS_t *bs, u32 flags);
@@ -176,6 +188,7 @@ static void FilterLuma(u8 *data, bS_t *bS, edgeThreshold_t *thresholds,
 static void FilterChroma(u8 *cb, u8 *cr, bS_t *bS, edgeThreshold_t *thresholds,
         u32 imageWidth);
 
+#ifndef H264DEC_SIMD
 static void FilterVerLumaEdge( u8 *data, u32 bS, edgeThreshold_t *thresholds,
         u32 imageWidth);
 static void FilterHorLumaEdge( u8 *data, u32 bS, edgeThreshold_t *thresholds,
@@ -189,6 +202,13 @@ static void FilterHorChromaEdge( u8 *data, u32 bS, edgeThreshold_t *thresholds,
   i32 imageWidth);
 static void FilterHorChroma( u8 *data, u32 bS, edgeThreshold_t *thresholds,
   i32 imageWidth);
+#else
+static void LoadTransposed(const u8 *row0, const u8 *row8, u32 width,
+    v16u8 *pix);
+static void StoreTransposed(u8 *row0, u8 *row8, u32 width, const v16u8 *pix);
+static u32 FilterEdge(v16u8 *pix, const u32 *bS, edgeThreshold_t *thresholds,
+    u32 chroma);
+#endif /* H264DEC_SIMD */
 
 static void GetLumaEdgeThresholds(
   edgeThreshold_t *thresholds,
@@ -318,6 +338,94 @@ u32 GetMbFilteringFlags(mbStorage_t *mb)
 
 }
 
+/*------------------------------------------------------------------------------
+
+    Function: IsStaticMb
+
+        Functional description:
+          Function to determine if a macroblock is an inter macroblock with
+          a single 16x16 partition and no luma coefficients, i.e. all the 4x4
+          blocks share the same motion vector and reference picture and none
+          of them contain coefficients.
+
+------------------------------------------------------------------------------*/
+u32 IsStaticMb(mbStorage_t *mb)
+{
+
+/* Variables */
+
+    u32 i;
+
+/* Code */
+
+    ASSERT(mb);
+
+    /* totalCoeff is cleared for skipped macroblocks */
+    if (mb->mbType == P_Skip)
+        return(HANTRO_TRUE);
+
+    if (mb->mbType != P_L0_16x16)
+        return(HANTRO_FALSE);
+
+    for (i = 0; i < 16; i++)
+        if (mb->totalCoeff[i])
+            return(HANTRO_FALSE);
+
+    return(HANTRO_TRUE);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: IsZeroBsMb
+
+        Functional description:
+          Fast check for macroblocks that need no filtering at all, typical
+          for P_Skip runs of static content. Function returns HANTRO_TRUE if
+          the macroblock and its neighbours across the edges to be filtered
+          are all static (see IsStaticMb) and use the same reference picture
+          with motion vectors differing less than one pixel, in which case
+          all the bS values of the macroblock would be zero. HANTRO_FALSE
+          means that bS values have to be computed by GetBoundaryStrengths.
+
+------------------------------------------------------------------------------*/
+u32 IsZeroBsMb(mbStorage_t *mb, u32 flags)
+{
+
+/* Variables */
+
+    mbStorage_t *mbN;
+
+/* Code */
+
+    ASSERT(mb);
+    ASSERT(flags);
+
+    if (!IsStaticMb(mb))
+        return(HANTRO_FALSE);
+
+    if (flags & FILTER_LEFT_EDGE)
+    {
+        mbN = mb->mbA;
+        if (!IsStaticMb(mbN) || (mb->refAddr[0] != mbN->refAddr[0]) ||
+            (ABS(mb->mv[0].hor - mbN->mv[0].hor) >= 4) ||
+            (ABS(mb->mv[0].ver - mbN->mv[0].ver) >= 4))
+            return(HANTRO_FALSE);
+    }
+
+    if (flags & FILTER_TOP_EDGE)
+    {
+        mbN = mb->mbB;
+        if (!IsStaticMb(mbN) || (mb->refAddr[0] != mbN->refAddr[0]) ||
+            (ABS(mb->mv[0].hor - mbN->mv[0].hor) >= 4) ||
+            (ABS(mb->mv[0].ver - mbN->mv[0].ver) >= 4))
+            return(HANTRO_FALSE);
+    }
+
+    return(HANTRO_TRUE);
+
+}
+
 /*------------------------------------------------------------------------------
 
     Function: InnerBoundaryStrength
@@ -548,20 +656,30 @@ u32 EdgeBoundaryStrengthLeft(mbStorage_t *mb1, mbStorage_t *mb2)
 #endif /* H264DEC_OMXDL */
 /*------------------------------------------------------------------------------
 
-    Function: h264bsdFilterPicture
+    Function: h264bsdFilterMbRows
 
         Functional description:
-          Perform deblocking filtering for a picture. Filter does not copy
-          the original picture anywhere but filtering is performed directly
-          on the original image. Parameters controlling the filtering process
+          Perform deblocking filtering for macroblock rows firstRow ..
+          firstRow+numRows-1 of a picture. Filter does not copy the original
+          picture anywhere but filtering is performed directly on the
+          original image. Parameters controlling the filtering process
           are computed based on information in macroblock structures of the
           filtered macroblock, macroblock above and macroblock on the left of
           the filtered one.
 
+          Filtering a row modifies up to three pixel rows at the bottom of
+          the macroblock row above it and reads the unfiltered pixels of the
+          row itself, so rows have to be filtered in increasing order and a
+          row may be filtered only after all of its macroblocks have been
+          reconstructed and the intra prediction of the row below (which
+          uses its unfiltered bottom pixels) is done.
+
         Inputs:
           image         pointer to image to be filtered
           mb            pointer to macroblock data structure of the top-left
                         macroblock of the picture
+          firstRow      first macroblock row to be filtered
+          numRows       number of macroblock rows to be filtered
 
         Outputs:
           image         filtered image stored here
@@ -571,15 +689,17 @@ u32 EdgeBoundaryStrengthLeft(mbStorage_t *mb1, mbStorage_t *mb2)
 
 ------------------------------------------------------------------------------*/
 #ifndef H264DEC_OMXDL
-void h264bsdFilterPicture(
+void h264bsdFilterMbRows(
   image_t *image,
-  mbStorage_t *mb)
+  mbStorage_t *mb,
+  u32 firstRow,
+  u32 numRows)
 {
 
 /* Variables */
 
     u32 flags;
-    u32 picSizeInMbs, mbRow, mbCol;
+    u32 picSizeInMbs, mbRow, mbCol, lastRow;
     u32 picWidthInMbs;
     u8 *data;
     mbStorage_t *pMb;
@@ -593,18 +713,22 @@ void h264bsdFilterPicture(
     ASSERT(image->data);
     ASSERT(image->width);
     ASSERT(image->height);
+    ASSERT(firstRow + numRows <= image->height);
 
     picWidthInMbs = image->width;
     data = image->data;
     picSizeInMbs = picWidthInMbs * image->height;
+    lastRow = firstRow + numRows;
 
-    pMb = mb;
+    pMb = mb + firstRow * picWidthInMbs;
 
-    for (mbRow = 0, mbCol = 0; mbRow < image->height; pMb++)
+    for (mbRow = firstRow, mbCol = 0; mbRow < lastRow; pMb++)
     {
         flags = GetMbFilteringFlags(pMb);
 
-        if (flags)
+        /* macroblocks with all bS values zero are skipped without computing
+         * the boundary strengths or touching the pixel data */
+        if (flags && !IsZeroBsMb(pMb, flags))
         {
             /* GetBoundaryStrengths function returns non-zero value if any of
              * the bS values for the macroblock being processed was non-zero */
@@ -638,6 +762,7 @@ void h264bsdFilterPicture(
 
 }
 
+#ifndef H264DEC_SIMD
 /*------------------------------------------------------------------------------
 
     Function: FilterVerLumaEdge
@@ -1119,7 +1244,7 @@ void FilterHorChroma(
     }
 
 }
-
+#endif /* H264DEC_SIMD */
 
 /*------------------------------------------------------------------------------
 
@@ -1531,6 +1656,7 @@ void GetChromaEdgeThresholds(
 
 }
 
+#ifndef H264DEC_SIMD
 /*------------------------------------------------------------------------------
 
     Function: FilterLuma
@@ -1735,24 +1861,574 @@ void FilterChroma(
     }
 }
 
+#else /* H264DEC_SIMD */
+
+/*------------------------------------------------------------------------------
+
+    Function: InterleaveLo8, InterleaveHi8, InterleaveLo16, InterleaveHi16,
+              InterleaveLo32, InterleaveHi32, InterleaveLo64, InterleaveHi64
+
+        Functional description:
+            Interleave 8-, 16-, 32- or 64-bit units from the low (or high)
+            halves of two vectors, building blocks of the transposes.
+
+------------------------------------------------------------------------------*/
+
+static inline v16u8 InterleaveLo8(v16u8 a, v16u8 b)
+{
+    return(__builtin_shufflevector(a, b,
+        0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23));
+}
+
+static inline v16u8 InterleaveHi8(v16u8 a, v16u8 b)
+{
+    return(__builtin_shufflevector(a, b,
+        8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31));
+}
+
+static inline v16u8 InterleaveLo16(v16u8 a, v16u8 b)
+{
+    return((v16u8)__builtin_shufflevector((v8i16)a, (v8i16)b,
+        0, 8, 1, 9, 2, 10, 3, 11));
+}
+
+static inline v16u8 InterleaveHi16(v16u8 a, v16u8 b)
+{
+    return((v16u8)__builtin_shufflevector((v8i16)a, (v8i16)b,
+        4, 12, 5, 13, 6, 14, 7, 15));
+}
+
+static inline v16u8 InterleaveLo32(v16u8 a, v16u8 b)
+{
+    return((v16u8)__builtin_shufflevector((v4u32)a, (v4u32)b, 0, 4, 1, 5));
+}
+
+static inline v16u8 InterleaveHi32(v16u8 a, v16u8 b)
+{
+    return((v16u8)__builtin_shufflevector((v4u32)a, (v4u32)b, 2, 6, 3, 7));
+}
+
+static inline v16u8 InterleaveLo64(v16u8 a, v16u8 b)
+{
+    return((v16u8)__builtin_shufflevector((v2u64)a, (v2u64)b, 0, 2));
+}
+
+static inline v16u8 InterleaveHi64(v16u8 a, v16u8 b)
+{
+    return((v16u8)__builtin_shufflevector((v2u64)a, (v2u64)b, 1, 3));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LoadTransposed
+
+        Functional description:
+            Load 8 pixels from each of 16 rows and transpose them so that
+            pix[i] holds column i of all rows. Rows 0..7 are read starting
+            from 'row0' and rows 8..15 starting from 'row8', line length
+            'width'.
+
+------------------------------------------------------------------------------*/
+
+static void LoadTransposed(const u8 *row0, const u8 *row8, u32 width,
+    v16u8 *pix)
+{
+
+/* Variables */
+
+    u32 i;
+    u64 x, y;
+    v16u8 t[8], u[8], v[8];
+
+/* Code */
+
+    /* pairs of rows, 16-bit unit j holds column j of both */
+    for (i = 0; i < 8; i++)
+    {
+        if (i == 4)
+            row0 = row8;
+        memcpy(&x, row0, 8);
+        memcpy(&y, row0 + width, 8);
+        row0 += 2*width;
+        t[i] = InterleaveLo8((v16u8)(v2u64){x, 0}, (v16u8)(v2u64){y, 0});
+    }
+
+    /* groups of four rows, 32-bit unit j holds column j (or j+4) */
+    for (i = 0; i < 8; i += 2)
+    {
+        u[i] = InterleaveLo16(t[i], t[i+1]);
+        u[i+1] = InterleaveHi16(t[i], t[i+1]);
+    }
+
+    /* groups of eight rows, 64-bit unit holds one column */
+    for (i = 0; i < 8; i += 4)
+    {
+        v[i] = InterleaveLo32(u[i], u[i+2]);
+        v[i+1] = InterleaveHi32(u[i], u[i+2]);
+        v[i+2] = InterleaveLo32(u[i+1], u[i+3]);
+        v[i+3] = InterleaveHi32(u[i+1], u[i+3]);
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        pix[2*i] = InterleaveLo64(v[i], v[i+4]);
+        pix[2*i+1] = InterleaveHi64(v[i], v[i+4]);
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: StoreTransposed
+
+        Functional description:
+            Inverse of LoadTransposed, transpose columns back to rows and
+            store 8 pixels of each of the 16 rows.
+
+------------------------------------------------------------------------------*/
+
+static void StoreTransposed(u8 *row0, u8 *row8, u32 width, const v16u8 *pix)
+{
+
+/* Variables */
+
+    u32 i, j;
+    v2u64 x;
+    v16u8 a[8], b[8];
+
+/* Code */
+
+    /* 16-bit unit i holds two columns of row i (rows 8..15 in odd a) */
+    for (i = 0; i < 8; i += 2)
+    {
+        a[i] = InterleaveLo8(pix[i], pix[i+1]);
+        a[i+1] = InterleaveHi8(pix[i], pix[i+1]);
+    }
+
+    /* 32-bit unit holds four columns of a row */
+    for (i = 0; i < 2; i++)
+    {
+        b[4*i] = InterleaveLo16(a[i], a[i+2]);
+        b[4*i+1] = InterleaveHi16(a[i], a[i+2]);
+        b[4*i+2] = InterleaveLo16(a[i+4], a[i+6]);
+        b[4*i+3] = InterleaveHi16(a[i+4], a[i+6]);
+    }
+
+    /* 64-bit unit holds one row */
+    for (i = 0; i < 8; i += 4)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            x = (v2u64)InterleaveLo32(b[i+j], b[i+j+2]);
+            memcpy(row0, &x[0], 8);
+            memcpy(row0 + width, &x[1], 8);
+            x = (v2u64)InterleaveHi32(b[i+j], b[i+j+2]);
+            memcpy(row0 + 2*width, &x[0], 8);
+            memcpy(row0 + 3*width, &x[1], 8);
+            row0 += 4*width;
+        }
+        row0 = row8;
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: Select, Min16, Max16, Abs16
+
+        Functional description:
+            Lane-wise helpers for 16-bit lanes, 'mask' lanes are all ones or
+            all zeros.
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 Select(v8i16 mask, v8i16 a, v8i16 b)
+{
+    return((a & mask) | (b & ~mask));
+}
+
+static inline v8i16 Min16(v8i16 a, v8i16 b)
+{
+    return(Select(a < b, a, b));
+}
+
+static inline v8i16 Max16(v8i16 a, v8i16 b)
+{
+    return(Select(a > b, a, b));
+}
+
+static inline v8i16 Abs16(v8i16 a)
+{
+    v8i16 s = a >> 15;
+    return((a ^ s) - s);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: EdgeMask
+
+        Functional description:
+            Determine which of 8 lanes of an edge are filtered, i.e. have
+            non-zero bS and sample differences below alpha and beta. x[0..7]
+            hold samples p3, p2, p1, p0, q0, q1, q2 and q3 of each lane.
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 EdgeMask(const v8i16 *x, v8i16 bS, i16 alpha, i16 beta)
+{
+    return((bS != 0) & (Abs16(x[3] - x[4]) < alpha) &
+           (Abs16(x[2] - x[3]) < beta) & (Abs16(x[5] - x[4]) < beta));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterLanes
+
+        Functional description:
+            Filter 8 lanes of an edge, x[0..7] hold samples p3..q3 of each
+            lane. Lane-wise bS and tc0 determine the filter, only lanes set
+            in 'filt' are modified. Computes the same result as the scalar
+            edge filters for any combination of bS values.
+
+------------------------------------------------------------------------------*/
+
+static inline void FilterLanes(v8i16 *x, v8i16 filt, v8i16 bS, v8i16 tc0,
+    i16 alpha, i16 beta, u32 strong, u32 chroma)
+{
+
+/* Variables */
+
+    v8i16 p0, p1, p2, q0, q1, q2;
+    v8i16 ap, aq, tc, delta, tmp;
+    v8i16 np0, np1, nq0, nq1;
+    v8i16 sp, sq;
+
+/* Code */
+
+    p2 = x[1]; p1 = x[2]; p0 = x[3];
+    q0 = x[4]; q1 = x[5]; q2 = x[6];
+
+    /* bS < 4 */
+    delta = ((q0 - p0) * 4 + (p1 - q1) + 4) >> 3;
+    if (chroma)
+    {
+        tc = tc0 + 1;
+        ap = aq = (v8i16){0};
+    }
+    else
+    {
+        ap = Abs16(p2 - p0) < beta;
+        aq = Abs16(q2 - q0) < beta;
+        /* masks are -1 for true lanes */
+        tc = tc0 - ap - aq;
+    }
+    delta = Min16(Max16(delta, -tc), tc);
+    np0 = h264bsdClip255(p0 + delta);
+    nq0 = h264bsdClip255(q0 - delta);
+    np1 = p1;
+    nq1 = q1;
+    if (!chroma)
+    {
+        tmp = (p0 + q0 + 1) >> 1;
+        np1 = Select(ap, p1 + Min16(Max16((p2 + tmp - (p1 << 1)) >> 1, -tc0),
+            tc0), p1);
+        nq1 = Select(aq, q1 + Min16(Max16((q2 + tmp - (q1 << 1)) >> 1, -tc0),
+            tc0), q1);
+    }
+
+    /* bS == 4 */
+    if (strong)
+    {
+        sp = bS == 4;
+        np0 = Select(sp, (2 * p1 + p0 + q1 + 2) >> 2, np0);
+        nq0 = Select(sp, (2 * q1 + q0 + p1 + 2) >> 2, nq0);
+        np1 = Select(sp, p1, np1);
+        nq1 = Select(sp, q1, nq1);
+        if (!chroma)
+        {
+            tmp = sp & (Abs16(p0 - q0) < (i16)((alpha >> 2) + 2));
+            sp = tmp & ap;
+            sq = tmp & aq;
+
+            tmp = p1 + p0 + q0;
+            np0 = Select(sp, (p2 + 2 * tmp + q1 + 4) >> 3, np0);
+            np1 = Select(sp, (p2 + tmp + 2) >> 2, np1);
+            x[1] = Select(sp & filt, (2 * x[0] + 3 * p2 + tmp + 4) >> 3, p2);
+
+            tmp = p0 + q0 + q1;
+            nq0 = Select(sq, (p1 + 2 * tmp + q2 + 4) >> 3, nq0);
+            nq1 = Select(sq, (tmp + q2 + 2) >> 2, nq1);
+            x[6] = Select(sq & filt, (2 * x[7] + 3 * q2 + tmp + 4) >> 3, q2);
+        }
+    }
+
+    x[2] = Select(filt, np1, p1);
+    x[3] = Select(filt, np0, p0);
+    x[4] = Select(filt, nq0, q0);
+    x[5] = Select(filt, nq1, q1);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterEdge
+
+        Functional description:
+            Filter one 16-pixel edge. pix[0..7] hold samples p3..q3 of each
+            of the 16 lanes, lanes are split into four segments of equal
+            length that use bS values bS[0..3]. For chroma the two halves of
+            the vector (cb and cr) both use the same four bS values.
+
+        Returns:
+            HANTRO_FALSE if no sample of the edge is filtered, pix is
+            untouched in that case
+
+------------------------------------------------------------------------------*/
+
+static u32 FilterEdge(v16u8 *pix, const u32 *bS, edgeThreshold_t *thresholds,
+    u32 chroma)
+{
+
+/* Variables */
+
+    u32 i, strong;
+    u64 lo, hi;
+    i16 alpha, beta;
+    v16u8 bs, tc0;
+    v8i16 x[8], y[8];
+    v8i16 bsLo, bsHi, filtLo, filtHi;
+
+/* Code */
+
+    ASSERT(bS[0] <= 4 && bS[1] <= 4 && bS[2] <= 4 && bS[3] <= 4);
+
+    if (!(bS[0] | bS[1] | bS[2] | bS[3]) || !thresholds->alpha ||
+        !thresholds->beta)
+        return(HANTRO_FALSE);
+
+    strong = bS[0] == 4 || bS[1] == 4 || bS[2] == 4 || bS[3] == 4;
+
+    /* lane-wise bS, lane order is little-endian */
+    if (chroma)
+    {
+        lo = (u64)((bS[0] | (bS[1] << 16)) * 0x0101U) |
+             ((u64)((bS[2] | (bS[3] << 16)) * 0x0101U) << 32);
+        hi = lo;
+    }
+    else
+    {
+        lo = (u64)(bS[0] * 0x01010101U) | ((u64)(bS[1] * 0x01010101U) << 32);
+        hi = (u64)(bS[2] * 0x01010101U) | ((u64)(bS[3] * 0x01010101U) << 32);
+    }
+    bs = (v16u8)(v2u64){lo, hi};
+    tc0 = ((v16u8)(bs == 1) & thresholds->tc0[0]) |
+          ((v16u8)(bs == 2) & thresholds->tc0[1]) |
+          ((v16u8)(bs == 3) & thresholds->tc0[2]);
+
+    for (i = 0; i < 8; i++)
+    {
+        x[i] = h264bsdUnpackLo(pix[i]);
+        y[i] = h264bsdUnpackHi(pix[i]);
+    }
+
+    alpha = (i16)thresholds->alpha;
+    beta = (i16)thresholds->beta;
+    bsLo = h264bsdUnpackLo(bs);
+    bsHi = h264bsdUnpackHi(bs);
+    filtLo = EdgeMask(x, bsLo, alpha, beta);
+    filtHi = EdgeMask(y, bsHi, alpha, beta);
+    /* nothing to do if sample differences exceed the thresholds */
+    if (!(((v2u64)(filtLo | filtHi))[0] | ((v2u64)(filtLo | filtHi))[1]))
+        return(HANTRO_FALSE);
+
+    FilterLanes(x, filtLo, bsLo, h264bsdUnpackLo(tc0), alpha, beta, strong,
+        chroma);
+    FilterLanes(y, filtHi, bsHi, h264bsdUnpackHi(tc0), alpha, beta, strong,
+        chroma);
+
+    for (i = 1; i < 7; i++)
+        pix[i] = h264bsdPack16(x[i], y[i]);
+
+    return(HANTRO_TRUE);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterLuma
+
+        Functional description:
+            Function to filter all luma edges of a macroblock. All vertical
+            edges are filtered first, each over the full 16 rows, followed
+            by the horizontal edges, which gives the same result as the
+            block row order of the scalar version.
+
+------------------------------------------------------------------------------*/
+void FilterLuma(
+  u8 *data,
+  bS_t *bS,
+  edgeThreshold_t *thresholds,
+  u32 width)
+{
+
+/* Variables */
+
+    u32 i, j;
+    u32 edge[4];
+    v16u8 pix[8];
+    u8 *ptr;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(bS);
+    ASSERT(thresholds);
+
+    /* vertical edges, first one is the left edge of the macroblock */
+    for (i = 0; i < 4; i++)
+    {
+        for (j = 0; j < 4; j++)
+            edge[j] = bS[4*j + i].left;
+        if (!(edge[0] | edge[1] | edge[2] | edge[3]))
+            continue;
+
+        ptr = data + 4*i - 4;
+        LoadTransposed(ptr, ptr + 8*width, width, pix);
+        if (FilterEdge(pix, edge, thresholds + (i ? INNER : LEFT), 0))
+            StoreTransposed(ptr, ptr + 8*width, width, pix);
+    }
+
+    /* horizontal edges, first one is the top edge of the macroblock */
+    for (i = 0; i < 4; i++)
+    {
+        for (j = 0; j < 4; j++)
+            edge[j] = bS[4*i + j].top;
+        if (!(edge[0] | edge[1] | edge[2] | edge[3]))
+            continue;
+
+        ptr = data + 4*i*width - 4*width;
+        for (j = 0; j < 8; j++)
+            pix[j] = h264bsdLoad16(ptr + j*width);
+        if (FilterEdge(pix, edge, thresholds + (i ? INNER : TOP), 0))
+        {
+            for (j = 1; j < 7; j++)
+                h264bsdStore16(ptr + j*width, pix[j]);
+        }
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterChroma
+
+        Functional description:
+            Function to filter all chroma edges of a macroblock. Cb and cr
+            are filtered together, cb in the first and cr in the second half
+            of each vector.
+
+------------------------------------------------------------------------------*/
+void FilterChroma(
+  u8 *dataCb,
+  u8 *dataCr,
+  bS_t *bS,
+  edgeThreshold_t *thresholds,
+  u32 width)
+{
+
+/* Variables */
+
+    u32 i, j;
+    u32 edge[4];
+    u64 x, y;
+    v16u8 pix[8];
+    u8 *cb, *cr;
+
+/* Code */
+
+    ASSERT(dataCb);
+    ASSERT(dataCr);
+    ASSERT(bS);
+    ASSERT(thresholds);
+
+    /* vertical edges at columns 0 and 4, each bS is used for two rows */
+    for (i = 0; i < 2; i++)
+    {
+        for (j = 0; j < 4; j++)
+            edge[j] = bS[4*j + 2*i].left;
+        if (!(edge[0] | edge[1] | edge[2] | edge[3]))
+            continue;
+
+        cb = dataCb + 4*i - 4;
+        cr = dataCr + 4*i - 4;
+        LoadTransposed(cb, cr, width, pix);
+        if (FilterEdge(pix, edge, thresholds + (i ? INNER : LEFT), 1))
+            StoreTransposed(cb, cr, width, pix);
+    }
+
+    /* horizontal edges at rows 0 and 4, each bS is used for two columns */
+    for (i = 0; i < 2; i++)
+    {
+        for (j = 0; j < 4; j++)
+            edge[j] = bS[8*i + j].top;
+        if (!(edge[0] | edge[1] | edge[2] | edge[3]))
+            continue;
+
+        cb = dataCb + 4*i*width - 2*width;
+        cr = dataCr + 4*i*width - 2*width;
+        /* only p1..q1 are used, other rows are left zero */
+        for (j = 0; j < 8; j++)
+            pix[j] = (v16u8){0};
+        for (j = 2; j < 6; j++)
+        {
+            memcpy(&x, cb + (j-2)*width, 8);
+            memcpy(&y, cr + (j-2)*width, 8);
+            pix[j] = (v16u8)(v2u64){x, y};
+        }
+        if (FilterEdge(pix, edge, thresholds + (i ? INNER : TOP), 1))
+        {
+            for (j = 3; j < 5; j++)
+            {
+                x = ((v2u64)pix[j])[0];
+                y = ((v2u64)pix[j])[1];
+                memcpy(cb + (j-2)*width, &x, 8);
+                memcpy(cr + (j-2)*width, &y, 8);
+            }
+        }
+    }
+
+}
+
+#endif /* H264DEC_SIMD */
+
 #else /* H264DEC_OMXDL */
 
 /*------------------------------------------------------------------------------
 
-    Function: h264bsdFilterPicture
+    Function: h264bsdFilterMbRows
 
         Functional description:
-          Perform deblocking filtering for a picture. Filter does not copy
-          the original picture anywhere but filtering is performed directly
-          on the original image. Parameters controlling the filtering process
+          Perform deblocking filtering for macroblock rows firstRow ..
+          firstRow+numRows-1 of a picture. Filter does not copy the original
+          picture anywhere but filtering is performed directly on the
+          original image. Parameters controlling the filtering process
           are computed based on information in macroblock structures of the
           filtered macroblock, macroblock above and macroblock on the left of
           the filtered one.
 
+          Filtering a row modifies up to three pixel rows at the bottom of
+          the macroblock row above it and reads the unfiltered pixels of the
+          row itself, so rows have to be filtered in increasing order and a
+          row may be filtered only after all of its macroblocks have been
+          reconstructed and the intra prediction of the row below (which
+          uses its unfiltered bottom pixels) is done.
+
         Inputs:
           image         pointer to image to be filtered
           mb            pointer to macroblock data structure of the top-left
                         macroblock of the picture
+          firstRow      first macroblock row to be filtered
+          numRows       number of macroblock rows to be filtered
 
         Outputs:
           image         filtered image stored here
@@ -1763,15 +2439,17 @@ void FilterChroma(
 ------------------------------------------------------------------------------*/
 
 /*lint --e{550} Symbol not accessed */
-void h264bsdFilterPicture(
+void h264bsdFilterMbRows(
   image_t *image,
-  mbStorage_t *mb)
+  mbStorage_t *mb,
+  u32 firstRow,
+  u32 numRows)
 {
 
 /* Variables */
 
     u32 flags;
-    u32 picSizeInMbs, mbRow, mbCol;
+    u32 picSizeInMbs, mbRow, mbCol, lastRow;
     u32 picWidthInMbs;
     u8 *data;
     mbStorage_t *pMb;
@@ -1789,18 +2467,22 @@ void h264bsdFilterPicture(
     ASSERT(image->data);
     ASSERT(image->width);
     ASSERT(image->height);
+    ASSERT(firstRow + numRows <= image->height);
 
     picWidthInMbs = image->width;
     data = image->data;
     picSizeInMbs = picWidthInMbs * image->height;
+    lastRow = firstRow + numRows;
 
-    pMb = mb;
+    pMb = mb + firstRow * picWidthInMbs;
 
-    for (mbRow = 0, mbCol = 0; mbRow < image->height; pMb++)
+    for (mbRow = firstRow, mbCol = 0; mbRow < lastRow; pMb++)
     {
         flags = GetMbFilteringFlags(pMb);
 
-        if (flags)
+        /* macroblocks with all bS values zero are skipped without computing
+         * the boundary strengths or touching the pixel data */
+        if (flags && !IsZeroBsMb(pMb, flags))
         {
             /* GetBoundaryStrengths function returns non-zero value if any of
              * the bS values for the macroblock being processed was non-zero */
@@ -25,6 +25,8 @@
      5. Functions
           h264bsdInit
           h264bsdDecode
+          h264bsdFinishSliceJobs
+          FinishPicture
           h264bsdShutdown
           h264bsdCurrentImage
           h264bsdNextOutputPicture
@@ -54,6 +56,7 @@
 #include "h264bsd_dpb.h"
 #include "h264bsd_deblocking.h"
 #include "h264bsd_conceal.h"
+#include "h264bsd_threads.h"
 
 /*------------------------------------------------------------------------------
     2. External compiler flags
@@ -67,6 +70,8 @@
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
 
+static u32 FinishPicture(storage_t *pStorage);
+
 /*------------------------------------------------------------------------------
 
     Function name: h264bsdInit
@@ -105,6 +110,11 @@ u32 h264bsdInit(storage_t *pStorage, u32 noOutputReordering)
     if (!pStorage->mbLayer)
         return HANTRO_NOK;
 
+#ifdef H264DEC_THREADS
+    if (h264bsdInitThreads(pStorage) != HANTRO_OK)
+        return HANTRO_NOK;
+#endif
+
     if (noOutputReordering)
         pStorage->noReordering = HANTRO_TRUE;
 
@@ -155,13 +165,18 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
 /* Variables */
 
     u32 tmp, ppsId, spsId;
-    i32 picOrderCnt;
     nalUnit_t nalUnit;
     seqParamSet_t seqParamSet;
     picParamSet_t picParamSet;
     strmData_t strm;
     u32 accessUnitBoundaryFlag = HANTRO_FALSE;
     u32 picReady = HANTRO_FALSE;
+#ifdef H264DEC_STATS
+    u64 statsTime;
+#endif
+#ifdef H264DEC_THREADS
+    u32 queueSlice;
+#endif
 
 /* Code */
 
@@ -181,12 +196,16 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
     }
     else
     {
+        STATS_START(statsTime);
         tmp = h264bsdExtractNalUnit(byteStrm, len, &strm, readBytes);
+        STATS_STOP(pStorage, nalExtractTime, statsTime);
         if (tmp != HANTRO_OK)
         {
             EPRINT("BYTE_STREAM");
             return(H264BSD_ERROR);
         }
+        STATS_ADD(pStorage, numNalUnits, 1);
+        STATS_ADD(pStorage, numBytes, *readBytes);
         /* store stream */
         pStorage->strm[0] = strm;
         pStorage->prevBytesConsumed = *readBytes;
@@ -225,6 +244,17 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
     if ( accessUnitBoundaryFlag )
     {
         DEBUG(("Access unit boundary\n"));
+#ifdef H264DEC_THREADS
+        /* slices decoded in parallel may complete the picture -> nothing to
+         * conceal, current NAL unit decoded on next activation */
+        if (h264bsdSyncSlices(pStorage) && h264bsdIsEndOfPicture(pStorage))
+        {
+            picReady = HANTRO_TRUE;
+            *readBytes = 0;
+            pStorage->prevBufNotFinished = HANTRO_TRUE;
+        }
+        else
+#endif
         /* conceal if picture started and param sets activated */
         if (pStorage->picStarted && pStorage->activeSps != NULL)
         {
@@ -238,6 +268,11 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
                 return (H264BSD_ERROR);
             }
 
+#ifdef H264DEC_THREADS
+            /* reference pictures are read by concealment */
+            h264bsdSyncPicture(pStorage, NULL);
+#endif
+            STATS_START(statsTime);
             if (!pStorage->validSliceInAccessUnit)
             {
                 pStorage->currImage->data =
@@ -248,6 +283,7 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
             else
                 tmp = h264bsdConceal(pStorage, pStorage->currImage,
                     pStorage->sliceHeader->sliceType);
+            STATS_STOP(pStorage, concealTime, statsTime);
 
             picReady = HANTRO_TRUE;
 
@@ -278,6 +314,10 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
                     FREE(seqParamSet.vuiParameters);
                     return(H264BSD_ERROR);
                 }
+#ifdef H264DEC_THREADS
+                /* parameter sets are in use by a picture being finished */
+                h264bsdSyncPicture(pStorage, NULL);
+#endif
                 tmp = h264bsdStoreSeqParamSet(pStorage, &seqParamSet);
                 break;
 
@@ -293,6 +333,9 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
                     FREE(picParamSet.sliceGroupId);
                     return(H264BSD_ERROR);
                 }
+#ifdef H264DEC_THREADS
+                h264bsdSyncPicture(pStorage, NULL);
+#endif
                 tmp = h264bsdStorePicParamSet(pStorage, &picParamSet);
                 break;
 
@@ -319,6 +362,11 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
                     /* store old activeSpsId and return headers ready
                      * indication if activeSps changes */
                     spsId = pStorage->activeSpsId;
+#ifdef H264DEC_THREADS
+                    /* macroblock storage and DPB are reallocated */
+                    if (pStorage->pendingActivation)
+                        h264bsdSyncPicture(pStorage, NULL);
+#endif
                     tmp = h264bsdActivateParamSets(pStorage, ppsId,
                             IS_IDR_NAL_UNIT(&nalUnit) ?
                             HANTRO_TRUE : HANTRO_FALSE);
@@ -395,13 +443,30 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
                     EPRINT("Pending activation not completed");
                     return (H264BSD_ERROR);
                 }
+                STATS_START(statsTime);
                 tmp = h264bsdDecodeSliceHeader(&strm, pStorage->sliceHeader + 1,
                     pStorage->activeSps, pStorage->activePps, &nalUnit);
+                STATS_STOP(pStorage, sliceHeaderTime, statsTime);
                 if (tmp != HANTRO_OK)
                 {
                     EPRINT("SLICE_HEADER");
                     return(H264BSD_ERROR);
                 }
+#ifdef H264DEC_THREADS
+                /* slice cannot be decoded in parallel with the queued ones
+                 * -> finish them first. If they complete the picture the
+                 * slice is redundant and skipped on next activation */
+                queueSlice = h264bsdCanQueueSlice(pStorage,
+                    pStorage->sliceHeader + 1);
+                if ( (!queueSlice || h264bsdSliceQueueFull(pStorage)) &&
+                     h264bsdFinishSliceJobs(pStorage) == H264BSD_PIC_RDY )
+                {
+                    *readBytes = 0;
+                    pStorage->prevBufNotFinished = HANTRO_TRUE;
+                    return(H264BSD_PIC_RDY);
+                }
+#endif
+                STATS_ADD(pStorage, numSlices, 1);
                 if (h264bsdIsStartOfPicture(pStorage))
                 {
                     if (!IS_IDR_NAL_UNIT(&nalUnit))
@@ -420,6 +485,11 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
                     }
                     pStorage->currImage->data =
                         h264bsdAllocateDpbImage(pStorage->dpb);
+#ifdef H264DEC_THREADS
+                    /* buffer may still be in use by a picture being
+                     * finished */
+                    h264bsdSyncPicture(pStorage, pStorage->currImage->data);
+#endif
                 }
 
                 /* store slice header to storage if successfully decoded */
@@ -427,6 +497,11 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
                 pStorage->validSliceInAccessUnit = HANTRO_TRUE;
                 pStorage->prevNalUnit[0] = nalUnit;
 
+#ifdef H264DEC_THREADS
+                /* map of a single slice group does not change within the
+                 * picture and is in use by the queued slices */
+                if (!queueSlice || !pStorage->slice->sliceId)
+#endif
                 h264bsdComputeSliceGroupMap(pStorage,
                     pStorage->sliceHeader->sliceGroupChangeCycle);
 
@@ -443,6 +518,13 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
 
                 DEBUG(("SLICE DATA, FIRST %d\n",
                         pStorage->sliceHeader->firstMbInSlice));
+#ifdef H264DEC_THREADS
+                if (queueSlice)
+                {
+                    h264bsdQueueSlice(pStorage, &strm);
+                    break;
+                }
+#endif
                 tmp = h264bsdDecodeSliceData(&strm, pStorage,
                     pStorage->currImage, pStorage->sliceHeader);
                 if (tmp != HANTRO_OK)
@@ -470,46 +552,124 @@ u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
     }
 
     if (picReady)
-    {
-        h264bsdFilterPicture(pStorage->currImage, pStorage->mb);
+        return(FinishPicture(pStorage));
+    else
+        return(H264BSD_RDY);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdFinishSliceJobs
+
+        Functional description:
+            Finish slices queued for parallel decoding (H264DEC_THREADS) and
+            the picture if they completed it. Called before any other slice
+            of the picture is decoded and before H264SwDecDecode returns as
+            the queued slices refer to the stream buffer of the call.
+
+        Inputs:
+            pStorage    pointer to storage data structure
+
+        Returns:
+            H264BSD_PIC_RDY     picture finished
+            H264BSD_RDY         otherwise
+
+------------------------------------------------------------------------------*/
+
+#ifdef H264DEC_THREADS
+u32 h264bsdFinishSliceJobs(storage_t *pStorage)
+{
+
+/* Code */
 
-        h264bsdResetStorage(pStorage);
+    ASSERT(pStorage);
+
+    if (!h264bsdSyncSlices(pStorage) || !h264bsdIsEndOfPicture(pStorage))
+        return(H264BSD_RDY);
 
-        picOrderCnt = h264bsdDecodePicOrderCnt(pStorage->poc,
-            pStorage->activeSps, pStorage->sliceHeader, pStorage->prevNalUnit);
+    pStorage->skipRedundantSlices = HANTRO_TRUE;
 
-        if (pStorage->validSliceInAccessUnit)
+    return(FinishPicture(pStorage));
+
+}
+#endif
+
+/*------------------------------------------------------------------------------
+
+    Function: FinishPicture
+
+        Functional description:
+            Finish decoding of the current picture: deblock the rows not
+            filtered during slice decoding, compute picture order count and
+            store the picture to the DPB.
+
+        Inputs:
+            pStorage    pointer to storage data structure
+
+        Returns:
+            H264BSD_PIC_RDY
+
+------------------------------------------------------------------------------*/
+
+u32 FinishPicture(storage_t *pStorage)
+{
+
+/* Variables */
+
+    i32 picOrderCnt;
+#ifdef H264DEC_STATS
+    u64 statsTime;
+#endif
+
+/* Code */
+
+    STATS_START(statsTime);
+    /* deblock the rows not already filtered during slice decoding */
+    h264bsdFilterMbRows(pStorage->currImage, pStorage->mb,
+        pStorage->slice->numFilteredRows,
+        pStorage->currImage->height - pStorage->slice->numFilteredRows);
+    STATS_STOP(pStorage, deblockTime, statsTime);
+
+    STATS_ADD(pStorage, numPictures, 1);
+    STATS_ADD(pStorage, numConcealedMbs, pStorage->numConcealedMbs);
+
+    STATS_START(statsTime);
+    h264bsdResetStorage(pStorage);
+
+    picOrderCnt = h264bsdDecodePicOrderCnt(pStorage->poc,
+        pStorage->activeSps, pStorage->sliceHeader, pStorage->prevNalUnit);
+
+    if (pStorage->validSliceInAccessUnit)
+    {
+        if (pStorage->prevNalUnit->nalRefIdc)
         {
-            if (pStorage->prevNalUnit->nalRefIdc)
-            {
-                tmp = h264bsdMarkDecRefPic(pStorage->dpb,
-                    &pStorage->sliceHeader->decRefPicMarking,
-                    pStorage->currImage, pStorage->sliceHeader->frameNum,
-                    picOrderCnt,
-                    IS_IDR_NAL_UNIT(pStorage->prevNalUnit) ?
-                    HANTRO_TRUE : HANTRO_FALSE,
-                    pStorage->currentPicId, pStorage->numConcealedMbs);
-            }
-            /* non-reference picture, just store for possible display
-             * reordering */
-            else
-            {
-                tmp = h264bsdMarkDecRefPic(pStorage->dpb, NULL,
-                    pStorage->currImage, pStorage->sliceHeader->frameNum,
-                    picOrderCnt,
-                    IS_IDR_NAL_UNIT(pStorage->prevNalUnit) ?
-                    HANTRO_TRUE : HANTRO_FALSE,
-                    pStorage->currentPicId, pStorage->numConcealedMbs);
-            }
+            (void)h264bsdMarkDecRefPic(pStorage->dpb,
+                &pStorage->sliceHeader->decRefPicMarking,
+                pStorage->currImage, pStorage->sliceHeader->frameNum,
+                picOrderCnt,
+                IS_IDR_NAL_UNIT(pStorage->prevNalUnit) ?
+                HANTRO_TRUE : HANTRO_FALSE,
+                pStorage->currentPicId, pStorage->numConcealedMbs);
         }
+        /* non-reference picture, just store for possible display
+         * reordering */
+        else
+        {
+            (void)h264bsdMarkDecRefPic(pStorage->dpb, NULL,
+                pStorage->currImage, pStorage->sliceHeader->frameNum,
+                picOrderCnt,
+                IS_IDR_NAL_UNIT(pStorage->prevNalUnit) ?
+                HANTRO_TRUE : HANTRO_FALSE,
+                pStorage->currentPicId, pStorage->numConcealedMbs);
+        }
+    }
 
-        pStorage->picStarted = HANTRO_FALSE;
-        pStorage->validSliceInAccessUnit = HANTRO_FALSE;
+    pStorage->picStarted = HANTRO_FALSE;
+    pStorage->validSliceInAccessUnit = HANTRO_FALSE;
+    STATS_STOP(pStorage, dpbTime, statsTime);
 
-        return(H264BSD_PIC_RDY);
-    }
-    else
-        return(H264BSD_RDY);
+    return(H264BSD_PIC_RDY);
 
 }
 
@@ -541,6 +701,10 @@ void h264bsdShutdown(storage_t *pStorage)
 
     ASSERT(pStorage);
 
+#ifdef H264DEC_THREADS
+    h264bsdShutdownThreads(pStorage);
+#endif
+
     for (i = 0; i < MAX_NUM_SEQ_PARAM_SETS; i++)
     {
         if (pStorage->sps[i])
@@ -586,6 +750,8 @@ void h264bsdShutdown(storage_t *pStorage)
             isIdrPic    IDR flag of the picture will be stored here
             numErrMbs   number of concealed macroblocks in the picture
                         will be stored here
+            picOrderCnt picture order count of the picture will be stored
+                        here
 
         Returns:
             pointer to the picture data
@@ -594,24 +760,35 @@ void h264bsdShutdown(storage_t *pStorage)
 ------------------------------------------------------------------------------*/
 
 u8* h264bsdNextOutputPicture(storage_t *pStorage, u32 *picId, u32 *isIdrPic,
-    u32 *numErrMbs)
+    u32 *numErrMbs, i32 *picOrderCnt)
 {
 
 /* Variables */
 
     dpbOutPicture_t *pOut;
+#ifdef H264DEC_STATS
+    u64 statsTime;
+#endif
 
 /* Code */
 
     ASSERT(pStorage);
 
+    STATS_START(statsTime);
     pOut = h264bsdDpbOutputPicture(pStorage->dpb);
+    STATS_STOP(pStorage, outputTime, statsTime);
 
     if (pOut != NULL)
     {
+#ifdef H264DEC_THREADS
+        /* picture may still be finished by the worker threads, waiting
+         * goes to syncTime instead of outputTime */
+        h264bsdSyncPicture(pStorage, pOut->data);
+#endif
         *picId = pOut->picId;
         *isIdrPic = pOut->isIdr;
         *numErrMbs = pOut->numErrMbs;
+        *picOrderCnt = pOut->picOrderCnt;
         return (pOut->data);
     }
     else
@@ -61,9 +61,12 @@ u32 h264bsdInit(storage_t *pStorage, u32 noOutputReordering);
 u32 h264bsdDecode(storage_t *pStorage, u8 *byteStrm, u32 len, u32 picId,
     u32 *readBytes);
 void h264bsdShutdown(storage_t *pStorage);
+#ifdef H264DEC_THREADS
+u32 h264bsdFinishSliceJobs(storage_t *pStorage);
+#endif
 
 u8* h264bsdNextOutputPicture(storage_t *pStorage, u32 *picId, u32 *isIdrPic,
-    u32 *numErrMbs);
+    u32 *numErrMbs, i32 *picOrderCnt);
 
 u32 h264bsdPicWidth(storage_t *pStorage);
 u32 h264bsdPicHeight(storage_t *pStorage);
@@ -80,8 +80,6 @@
 /* macro to set a picture unused for reference */
 #define SET_UNUSED(a) (a).status = UNUSED;
 
-#define MAX_NUM_REF_IDX_L0_ACTIVE 16
-
 /*------------------------------------------------------------------------------
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
@@ -810,6 +808,7 @@ u32 h264bsdMarkDecRefPic(
         dpb->outBuf[dpb->numOut].isIdr = dpb->currentOut->isIdr;
         dpb->outBuf[dpb->numOut].picId = dpb->currentOut->picId;
         dpb->outBuf[dpb->numOut].numErrMbs = dpb->currentOut->numErrMbs;
+        dpb->outBuf[dpb->numOut].picOrderCnt = dpb->currentOut->picOrderCnt;
         dpb->numOut++;
     }
     else
@@ -1449,6 +1448,7 @@ u32 OutputPicture(dpbStorage_t *dpb)
     dpb->outBuf[dpb->numOut].isIdr = tmp->isIdr;
     dpb->outBuf[dpb->numOut].picId = tmp->picId;
     dpb->outBuf[dpb->numOut].numErrMbs = tmp->numErrMbs;
+    dpb->outBuf[dpb->numOut].picOrderCnt = tmp->picOrderCnt;
     dpb->numOut++;
 
     tmp->toBeDisplayed = HANTRO_FALSE;
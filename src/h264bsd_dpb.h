@@ -40,6 +40,9 @@
     2. Module defines
 ------------------------------------------------------------------------------*/
 
+/* size of the reference picture list is MAX_NUM_REF_IDX_L0_ACTIVE + 1 */
+#define MAX_NUM_REF_IDX_L0_ACTIVE 16
+
 /*------------------------------------------------------------------------------
     3. Data types
 ------------------------------------------------------------------------------*/
@@ -72,6 +75,7 @@ typedef struct {
     u32 picId;
     u32 numErrMbs;
     u32 isIdr;
+    i32 picOrderCnt;
 } dpbOutPicture_t;
 
 /* structure to represent DPB */
@@ -92,6 +96,11 @@ typedef struct {
     u32 lastContainsMmco5;
     u32 noReordering;
     u32 flushed;
+#ifdef H264DEC_THREADS
+    /* worker threads, a picture stored to the DPB may still be finished by
+     * them, see h264bsd_threads.h */
+    struct sliceThreads *threads;
+#endif
 } dpbStorage_t;
 
 /*------------------------------------------------------------------------------
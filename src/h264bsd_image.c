@@ -35,6 +35,7 @@
 #include "h264bsd_image.h"
 #include "h264bsd_util.h"
 #include "h264bsd_neighbour.h"
+#include "h264bsd_simd.h"
 
 /*------------------------------------------------------------------------------
     2. External compiler flags
@@ -174,7 +175,6 @@ void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
 
 /* Variables */
 
-    u32 i;
     u32 picWidth, picSize;
     u8 *lum, *cb, *cr;
     u8 *imageBlock;
@@ -183,8 +183,12 @@ void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
     u32 block;
     u32 x, y;
     i32 *pRes;
-    i32 tmp1, tmp2, tmp3, tmp4;
+    i32 tmp1, tmp2;
+#ifndef H264DEC_SIMD
+    u32 i;
+    i32 tmp3, tmp4;
     const u8 *clp = h264bsdClip + 512;
+#endif
 
 /* Code */
 
@@ -242,6 +246,10 @@ void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
 
             RANGE_CHECK_ARRAY(pRes, -512, 511, 16);
 
+#ifdef H264DEC_SIMD
+            /* Calculate image = prediction + residual */
+            h264bsdAddResidual4x4(tmp, 16, imageBlock, picWidth, pRes);
+#else
             /* Calculate image = prediction + residual
              * Process four pixels in a loop */
             for (i = 4; i; i--)
@@ -265,6 +273,7 @@ void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
                 imageBlock[3] = (u8)tmp3;
                 imageBlock += picWidth;
             }
+#endif /* H264DEC_SIMD */
         }
 
     }
@@ -316,6 +325,9 @@ void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
 
             RANGE_CHECK_ARRAY(pRes, -512, 511, 16);
 
+#ifdef H264DEC_SIMD
+            h264bsdAddResidual4x4(tmp, 8, imageBlock, picWidth, pRes);
+#else
             for (i = 4; i; i--)
             {
                 tmp1 = tmp[0];
@@ -337,9 +349,84 @@ void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
                 imageBlock[3] = (u8)tmp3;
                 imageBlock += picWidth;
             }
+#endif /* H264DEC_SIMD */
         }
     }
 
 }
+
+#ifdef H264DEC_SIMD
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdAddMbResidual
+
+        Functional description:
+            Add residual of one macroblock to the prediction that has already
+            been written into the image (see h264bsdPredictMacroblock).
+
+        Inputs:
+            image       luma, cb and cr point to the macroblock
+            residual    pointer to residual data, 16 16-element arrays for luma
+                        followed by 4 16-element arrays for both chroma
+                        components
+
+        Outputs:
+            image       macroblock is updated in place
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdAddMbResidual(image_t *image, i32 residual[][16])
+{
+
+/* Variables */
+
+    u32 picWidth;
+    u32 block;
+    u8 *imageBlock;
+    i32 *pRes;
+
+/* Code */
+
+    ASSERT(image);
+    ASSERT(residual);
+
+    picWidth = 16 * image->width;
+
+    for (block = 0; block < 16; block++)
+    {
+        pRes = residual[block];
+        if (IS_RESIDUAL_EMPTY(pRes))
+            continue;
+
+        RANGE_CHECK_ARRAY(pRes, -512, 511, 16);
+
+        imageBlock = image->luma + h264bsdBlockY[block]*picWidth +
+            h264bsdBlockX[block];
+        h264bsdAddResidual4x4(imageBlock, picWidth, imageBlock, picWidth,
+            pRes);
+    }
+
+    picWidth /= 2;
+
+    for (block = 16; block <= 23; block++)
+    {
+        pRes = residual[block];
+        if (IS_RESIDUAL_EMPTY(pRes))
+            continue;
+
+        RANGE_CHECK_ARRAY(pRes, -512, 511, 16);
+
+        imageBlock = (block >= 20) ? image->cr : image->cb;
+        imageBlock += h264bsdBlockY[block & 0x3]*picWidth +
+            h264bsdBlockX[block & 0x3];
+        h264bsdAddResidual4x4(imageBlock, picWidth, imageBlock, picWidth,
+            pRes);
+    }
+
+}
+#endif /* H264DEC_SIMD */
 #endif /* H264DEC_OMXDL */
 
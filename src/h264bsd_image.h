@@ -62,6 +62,9 @@ void h264bsdWriteMacroblock(image_t *image, u8 *data);
 #ifndef H264DEC_OMXDL
 void h264bsdWriteOutputBlocks(image_t *image, u32 mbNum, u8 *data,
     i32 residual[][16]);
+#ifdef H264DEC_SIMD
+void h264bsdAddMbResidual(image_t *image, i32 residual[][16]);
+#endif
 #endif
 
 #endif /* #ifdef H264SWDEC_IMAGE_H */
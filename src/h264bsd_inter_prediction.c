@@ -32,6 +32,7 @@
           MedianFilter
           GetInterNeighbour
           GetPredictionMv
+          WaitRefRows
 
 ------------------------------------------------------------------------------*/
 
@@ -44,6 +45,9 @@
 #include "h264bsd_util.h"
 #include "h264bsd_reconstruct.h"
 #include "h264bsd_dpb.h"
+#ifdef H264DEC_THREADS
+#include "h264bsd_threads.h"
+#endif
 
 /*------------------------------------------------------------------------------
     2. External compiler flags
@@ -60,6 +64,16 @@ typedef struct
     mv_t mv;
 } interNeighbour_t;
 
+/* wait until the reference picture rows read by the macroblock are ready,
+ * needed when the reference picture is still being finished by the worker
+ * threads */
+#ifdef H264DEC_THREADS
+#define WAIT_REF_ROWS(pMb, dpb, mbNum, currImage) \
+    WaitRefRows(pMb, dpb, (mbNum) / (currImage)->width, (currImage)->height)
+#else
+#define WAIT_REF_ROWS(pMb, dpb, mbNum, currImage)
+#endif
+
 /*------------------------------------------------------------------------------
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
@@ -80,6 +94,11 @@ static void GetInterNeighbour(u32 sliceId, mbStorage_t *nMb,
     interNeighbour_t *n, u32 index);
 static void GetPredictionMv(mv_t *mv, interNeighbour_t *a, u32 refIndex);
 
+#ifdef H264DEC_THREADS
+static void WaitRefRows(mbStorage_t *pMb, dpbStorage_t *dpb, u32 mbRow,
+    u32 picHeight);
+#endif
+
 static const neighbour_t N_A_SUB_PART[4][4][4] = {
     { { {MB_A,5}, {MB_NA,0}, {MB_NA,0}, {MB_NA,0} },
       { {MB_A,5}, {MB_A,7}, {MB_NA,0}, {MB_NA,0} },
@@ -232,6 +251,7 @@ u32 h264bsdInterPrediction(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
         case P_L0_16x16:
             if (MvPrediction16x16(pMb, &pMbLayer->mbPred, dpb) != HANTRO_OK)
                 return(HANTRO_NOK);
+            WAIT_REF_ROWS(pMb, dpb, mbNum, currImage);
             refImage.data = pMb->refAddr[0];
             tmp = (0<<24) + (0<<16) + (16<<8) + 16;
             h264bsdPredictSamples(data, pMb->mv, &refImage,
@@ -241,6 +261,7 @@ u32 h264bsdInterPrediction(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
         case P_L0_L0_16x8:
             if ( MvPrediction16x8(pMb, &pMbLayer->mbPred, dpb) != HANTRO_OK)
                 return(HANTRO_NOK);
+            WAIT_REF_ROWS(pMb, dpb, mbNum, currImage);
             refImage.data = pMb->refAddr[0];
             tmp = (0<<24) + (0<<16) + (16<<8) + 8;
             h264bsdPredictSamples(data, pMb->mv, &refImage,
@@ -255,6 +276,7 @@ u32 h264bsdInterPrediction(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
         case P_L0_L0_8x16:
             if ( MvPrediction8x16(pMb, &pMbLayer->mbPred, dpb) != HANTRO_OK)
                 return(HANTRO_NOK);
+            WAIT_REF_ROWS(pMb, dpb, mbNum, currImage);
             refImage.data = pMb->refAddr[0];
             tmp = (0<<24) + (0<<16) + (8<<8) + 16;
             h264bsdPredictSamples(data, pMb->mv, &refImage,
@@ -268,6 +290,7 @@ u32 h264bsdInterPrediction(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
         default: /* P_8x8 and P_8x8ref0 */
             if ( MvPrediction8x8(pMb, &pMbLayer->subMbPred, dpb) != HANTRO_OK)
                 return(HANTRO_NOK);
+            WAIT_REF_ROWS(pMb, dpb, mbNum, currImage);
             for (i = 0; i < 4; i++)
             {
                 refImage.data = pMb->refAddr[i];
@@ -389,14 +412,37 @@ u32 h264bsdInterPrediction(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
         case P_L0_16x16:
             if (MvPrediction16x16(pMb, &pMbLayer->mbPred, dpb) != HANTRO_OK)
                 return(HANTRO_NOK);
+            WAIT_REF_ROWS(pMb, dpb, mbNum, currImage);
             refImage.data = pMb->refAddr[0];
+            /* no residual and integer motion vector also for chroma ->
+             * reference is copied straight into the output image */
+            if ((pMb->mbType == P_Skip || !pMbLayer->codedBlockPattern) &&
+                !((pMb->mv[0].hor | pMb->mv[0].ver) & 0x7))
+            {
+                if (pMb->decoded == 1)
+                    h264bsdCopyMacroblock(currImage, pMb->mv, &refImage,
+                        col, row);
+                return(HANTRO_OK);
+            }
+#ifdef H264DEC_SIMD
+            /* whole macroblock is predicted straight into the output image
+             * and residual added in place */
+            if (pMb->decoded > 1)
+                return(HANTRO_OK);
+            h264bsdPredictMacroblock(currImage, pMb->mv, &refImage, col, row);
+            if (pMb->mbType != P_Skip)
+                h264bsdAddMbResidual(currImage, pMbLayer->residual.level);
+            return(HANTRO_OK);
+#else
             h264bsdPredictSamples(data, pMb->mv, &refImage, col, row, 0, 0,
                 16, 16);
             break;
+#endif /* H264DEC_SIMD */
 
         case P_L0_L0_16x8:
             if ( MvPrediction16x8(pMb, &pMbLayer->mbPred, dpb) != HANTRO_OK)
                 return(HANTRO_NOK);
+            WAIT_REF_ROWS(pMb, dpb, mbNum, currImage);
             refImage.data = pMb->refAddr[0];
             h264bsdPredictSamples(data, pMb->mv, &refImage, col, row, 0, 0,
                 16, 8);
@@ -408,6 +454,7 @@ u32 h264bsdInterPrediction(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
         case P_L0_L0_8x16:
             if ( MvPrediction8x16(pMb, &pMbLayer->mbPred, dpb) != HANTRO_OK)
                 return(HANTRO_NOK);
+            WAIT_REF_ROWS(pMb, dpb, mbNum, currImage);
             refImage.data = pMb->refAddr[0];
             h264bsdPredictSamples(data, pMb->mv, &refImage, col, row, 0, 0,
                 8, 16);
@@ -419,6 +466,7 @@ u32 h264bsdInterPrediction(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
         default: /* P_8x8 and P_8x8ref0 */
             if ( MvPrediction8x8(pMb, &pMbLayer->subMbPred, dpb) != HANTRO_OK)
                 return(HANTRO_NOK);
+            WAIT_REF_ROWS(pMb, dpb, mbNum, currImage);
             for (i = 0; i < 4; i++)
             {
                 refImage.data = pMb->refAddr[i];
@@ -967,7 +1015,7 @@ void GetInterNeighbour(u32 sliceId, mbStorage_t *nMb,
     n->refIndex = 0xFFFFFFFF;
     n->mv.hor = n->mv.ver = 0;
 
-    if (nMb && (sliceId == nMb->sliceId))
+    if (nMb && (sliceId == GET_SLICE_ID(nMb)))
     {
         u32 tmp;
         mv_t tmpMv;
@@ -1024,4 +1072,48 @@ void GetPredictionMv(mv_t *mv, interNeighbour_t *a, u32 refIndex)
 
 }
 
+/*------------------------------------------------------------------------------
+
+    Function: WaitRefRows
+
+        Functional description:
+            Wait until the rows of the reference pictures needed for inter
+            prediction of the macroblock can be used. Each 8x8 block needs
+            the rows down to its last row displaced by the largest vertical
+            motion vector of the block plus three rows for the
+            interpolation filter. Chroma needs less.
+
+        Inputs:
+            pMb         pointer to macroblock, motion vectors and reference
+                        pictures determined
+            dpb         pointer to decoded picture buffer
+            mbRow       macroblock row of the macroblock
+            picHeight   picture height in macroblocks
+
+------------------------------------------------------------------------------*/
+
+#ifdef H264DEC_THREADS
+void WaitRefRows(mbStorage_t *pMb, dpbStorage_t *dpb, u32 mbRow,
+    u32 picHeight)
+{
+
+/* Variables */
+
+    u32 i, j;
+    i32 ver, lastRow;
+
+/* Code */
 
+    for (i = 0; i < 4; i++)
+    {
+        ver = pMb->mv[4*i].ver;
+        for (j = 1; j < 4; j++)
+            ver = MAX(ver, pMb->mv[4*i+j].ver);
+
+        lastRow = (i32)(16*mbRow) + (i < 2 ? 7 : 15) + (ver >> 2) + 3;
+        h264bsdWaitRefRows(dpb, pMb->refAddr[i], lastRow < 0 ? 1 :
+            MIN((u32)lastRow / 16 + 1, picHeight));
+    }
+
+}
+#endif
@@ -48,6 +48,7 @@
           Intra4x4HorizontalDownPrediction
           Intra4x4VerticalLeftPrediction
           Intra4x4HorizontalUpPrediction
+          Intra4x4PredictionSimd
           DetermineIntra4x4PredMode
 
 ------------------------------------------------------------------------------*/
@@ -61,6 +62,7 @@
 #include "h264bsd_macroblock_layer.h"
 #include "h264bsd_neighbour.h"
 #include "h264bsd_image.h"
+#include "h264bsd_simd.h"
 
 #ifdef H264DEC_OMXDL
 #include "omxtypes.h"
@@ -159,19 +161,22 @@ const u8 h264bsdClip[1280] =
 /*------------------------------------------------------------------------------
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
-static void Get4x4NeighbourPels(u8 *a, u8 *l, u8 *data, u8 *above, u8 *left,
-    u32 blockNum);
-static void Intra16x16VerticalPrediction(u8 *data, u8 *above);
-static void Intra16x16HorizontalPrediction(u8 *data, u8 *left);
-static void Intra16x16DcPrediction(u8 *data, u8 *above, u8 *left,
+static void Get4x4NeighbourPels(u8 *a, u8 *l, u8 *data, u32 width,
+    u8 *above, u8 *left, u32 blockNum);
+static void Intra16x16VerticalPrediction(u8 *data, u32 width, u8 *above);
+static void Intra16x16HorizontalPrediction(u8 *data, u32 width, u8 *left);
+static void Intra16x16DcPrediction(u8 *data, u32 width, u8 *above, u8 *left,
     u32 A, u32 B);
-static void Intra16x16PlanePrediction(u8 *data, u8 *above, u8 *left);
-static void IntraChromaDcPrediction(u8 *data, u8 *above, u8 *left,
+static void Intra16x16PlanePrediction(u8 *data, u32 width, u8 *above,
+    u8 *left);
+static void IntraChromaDcPrediction(u8 *data, u32 width, u8 *above, u8 *left,
     u32 A, u32 B);
-static void IntraChromaHorizontalPrediction(u8 *data, u8 *left);
-static void IntraChromaVerticalPrediction(u8 *data, u8 *above);
-static void IntraChromaPlanePrediction(u8 *data, u8 *above, u8 *left);
+static void IntraChromaHorizontalPrediction(u8 *data, u32 width, u8 *left);
+static void IntraChromaVerticalPrediction(u8 *data, u32 width, u8 *above);
+static void IntraChromaPlanePrediction(u8 *data, u32 width, u8 *above,
+    u8 *left);
 
+#ifndef H264DEC_SIMD
 static void Intra4x4VerticalPrediction(u8 *data, u8 *above);
 static void Intra4x4HorizontalPrediction(u8 *data, u8 *left);
 static void Intra4x4DcPrediction(u8 *data, u8 *above, u8 *left, u32 A, u32 B);
@@ -181,9 +186,15 @@ static void Intra4x4VerticalRightPrediction(u8 *data, u8 *above, u8 *left);
 static void Intra4x4HorizontalDownPrediction(u8 *data, u8 *above, u8 *left);
 static void Intra4x4VerticalLeftPrediction(u8 *data, u8 *above);
 static void Intra4x4HorizontalUpPrediction(u8 *data, u8 *left);
-void h264bsdAddResidual(u8 *data, i32 *residual, u32 blockNum);
-
-static void Write4x4To16x16(u8 *data, u8 *data4x4, u32 blockNum);
+#else
+static void Intra4x4PredictionSimd(u8 *data, u32 width, u8 *a, u8 *l,
+    u32 mode, u32 A, u32 B);
+#endif /* H264DEC_SIMD */
+void h264bsdAddResidual(u8 *data, u32 width, i32 *residual, u32 blockNum);
+
+#ifndef H264DEC_SIMD
+static void Write4x4To16x16(u8 *data, u32 width, u8 *data4x4, u32 blockNum);
+#endif
 #endif /* H264DEC_OMXDL */
 
 static u32 DetermineIntra4x4PredMode(macroblockLayer_t *pMbLayer,
@@ -448,22 +459,23 @@ u32 h264bsdIntraChromaPrediction(mbStorage_t *pMb, u8 *data, image_t *image,
 
         Functional description:
           Processes one intra macroblock. Performs intra prediction using
-          specified prediction mode. Writes the final macroblock
-          (prediction + residual) into the output image (image)
+          specified prediction mode. The prediction is written straight
+          into the output image (image) and the residual added there.
 
         Inputs:
           pMb           pointer to macroblock specific information
           mbLayer       pointer to current macroblock data from stream
-          image         pointer to output image
+          image         pointer to output image, luma, cb and cr pointers
+                        of the macroblock set by h264bsdSetCurrImageMbPointers
           mbNum         current macroblock number
           constrainedIntraPred  flag specifying if neighbouring inter
                                 macroblocks are used in intra prediction
-          data          pointer where output macroblock will be stored
+          data          macroblock array used instead of the image when
+                        the macroblock has already been written
 
         Outputs:
           pMb           structure is updated with current macroblock
           image         current macroblock is written into image
-          data          current macroblock is stored here
 
         Returns:
           HANTRO_OK     success
@@ -485,6 +497,8 @@ u32 h264bsdIntraPrediction(mbStorage_t *pMb, macroblockLayer_t *mbLayer,
     /* lumA + cbA + crA */
     u8 pelLeft[16 + 8 + 8];
     u32 tmp;
+    u32 width;
+    u8 *lum, *cb, *cr;
 
 /* Code */
 
@@ -493,36 +507,46 @@ u32 h264bsdIntraPrediction(mbStorage_t *pMb, macroblockLayer_t *mbLayer,
     ASSERT(mbNum < image->width * image->height);
     ASSERT(h264bsdMbPartPredMode(pMb->mbType) != PRED_MODE_INTER);
 
-    h264bsdGetNeighbourPels(image, pelAbove, pelLeft, mbNum);
+    h264bsdGetNeighbourPels(pMb, image, pelAbove, pelLeft, mbNum);
+
+    /* if decoded flag > 1 -> mb has already been successfully decoded and
+     * written to output -> do not write again, predict into data instead */
+    if (pMb->decoded > 1)
+    {
+        width = 16;
+        lum = data;
+        cb = data + 256;
+        cr = data + 320;
+    }
+    else
+    {
+        width = 16 * image->width;
+        lum = image->luma;
+        cb = image->cb;
+        cr = image->cr;
+    }
 
     if (h264bsdMbPartPredMode(pMb->mbType) == PRED_MODE_INTRA16x16)
     {
-        tmp = h264bsdIntra16x16Prediction(pMb, data, mbLayer->residual.level,
-            pelAbove, pelLeft, constrainedIntraPred);
+        tmp = h264bsdIntra16x16Prediction(pMb, lum, width,
+            mbLayer->residual.level, pelAbove, pelLeft, constrainedIntraPred);
         if (tmp != HANTRO_OK)
             return(tmp);
     }
     else
     {
-        tmp = h264bsdIntra4x4Prediction(pMb, data, mbLayer,
+        tmp = h264bsdIntra4x4Prediction(pMb, lum, width, mbLayer,
             pelAbove, pelLeft, constrainedIntraPred);
         if (tmp != HANTRO_OK)
             return(tmp);
     }
 
-    tmp = h264bsdIntraChromaPrediction(pMb, data + 256,
+    tmp = h264bsdIntraChromaPrediction(pMb, cb, cr, width >> 1,
             mbLayer->residual.level+16, pelAbove + 21, pelLeft + 16,
             mbLayer->mbPred.intraChromaPredMode, constrainedIntraPred);
     if (tmp != HANTRO_OK)
         return(tmp);
 
-    /* if decoded flag > 1 -> mb has already been successfully decoded and
-     * written to output -> do not write again */
-    if (pMb->decoded > 1)
-        return HANTRO_OK;
-
-    h264bsdWriteMacroblock(image, data);
-
     return(HANTRO_OK);
 
 }
@@ -533,11 +557,14 @@ u32 h264bsdIntraPrediction(mbStorage_t *pMb, macroblockLayer_t *mbLayer,
 
         Functional description:
           Get pixel values from neighbouring macroblocks into 'above'
-          and 'left' arrays.
+          and 'left' arrays. Only samples of available neighbours are read,
+          macroblocks of other slices may be under reconstruction by another
+          thread (H264DEC_THREADS).
 
 ------------------------------------------------------------------------------*/
 
-void h264bsdGetNeighbourPels(image_t *image, u8 *above, u8 *left, u32 mbNum)
+void h264bsdGetNeighbourPels(mbStorage_t *pMb, image_t *image, u8 *above,
+    u8 *left, u32 mbNum)
 {
 
 /* Variables */
@@ -546,9 +573,11 @@ void h264bsdGetNeighbourPels(image_t *image, u8 *above, u8 *left, u32 mbNum)
     u32 width, picSize;
     u8 *ptr, *tmp;
     u32 row, col;
+    u32 availableA, availableB, availableC, availableD;
 
 /* Code */
 
+    ASSERT(pMb);
     ASSERT(image);
     ASSERT(above);
     ASSERT(left);
@@ -557,6 +586,11 @@ void h264bsdGetNeighbourPels(image_t *image, u8 *above, u8 *left, u32 mbNum)
     if (!mbNum)
         return;
 
+    availableA = h264bsdIsNeighbourAvailable(pMb, pMb->mbA);
+    availableB = h264bsdIsNeighbourAvailable(pMb, pMb->mbB);
+    availableC = h264bsdIsNeighbourAvailable(pMb, pMb->mbC);
+    availableD = h264bsdIsNeighbourAvailable(pMb, pMb->mbD);
+
     width = image->width;
     picSize = width * image->height;
     row = mbNum / width;
@@ -565,39 +599,46 @@ void h264bsdGetNeighbourPels(image_t *image, u8 *above, u8 *left, u32 mbNum)
     width *= 16;
     ptr = image->data + row * 16 * width  + col * 16;
 
-    /* note that luma samples above-right to current macroblock do not make
-     * sense when current mb is the right-most mb in a row. Same applies to
-     * sample above-left if col is zero. However, usage of pels in prediction
-     * is controlled by neighbour availability information in actual prediction
-     * process */
-    if (row)
-    {
-        tmp = ptr - (width + 1);
-        for (i = 21; i--;)
-            *above++ = *tmp++;
-    }
+    /* usage of pels in prediction is controlled by neighbour availability
+     * information in actual prediction process, entries of unavailable
+     * neighbours are left as they are */
+    tmp = ptr - (width + 1);
+    if (availableD)
+        above[0] = tmp[0];
+    if (availableB)
+        for (i = 1; i < 17; i++)
+            above[i] = tmp[i];
+    if (availableC)
+        for (i = 17; i < 21; i++)
+            above[i] = tmp[i];
+    above += 21;
 
-    if (col)
+    if (availableA)
     {
-        ptr--;
-        for (i = 16; i--; ptr+=width)
-            *left++ = *ptr;
+        tmp = ptr - 1;
+        for (i = 16; i--; tmp+=width)
+            *left++ = *tmp;
     }
+    else
+        left += 16;
 
     width >>= 1;
     ptr = image->data + picSize * 256 + row * 8 * width  + col * 8;
 
-    if (row)
+    tmp = ptr - (width + 1);
+    if (availableD)
     {
-        tmp = ptr - (width + 1);
-        for (i = 9; i--;)
-            *above++ = *tmp++;
-        tmp += (picSize * 64) - 9;
-        for (i = 9; i--;)
-            *above++ = *tmp++;
+        above[0] = tmp[0];
+        above[9] = tmp[picSize * 64];
     }
+    if (availableB)
+        for (i = 1; i < 9; i++)
+        {
+            above[i] = tmp[i];
+            above[9 + i] = tmp[picSize * 64 + i];
+        }
 
-    if (col)
+    if (availableA)
     {
         ptr--;
         for (i = 8; i--; ptr+=width)
@@ -615,12 +656,12 @@ void h264bsdGetNeighbourPels(image_t *image, u8 *above, u8 *left, u32 mbNum)
         Functional description:
           Perform intra 16x16 prediction mode for luma pixels and add
           residual into prediction. The resulting luma pixels are
-          stored in macroblock array 'data'.
+          stored in 'data', line length 'width'.
 
 ------------------------------------------------------------------------------*/
 
-u32 h264bsdIntra16x16Prediction(mbStorage_t *pMb, u8 *data, i32 residual[][16],
-                                u8 *above, u8 *left, u32 constrainedIntraPred)
+u32 h264bsdIntra16x16Prediction(mbStorage_t *pMb, u8 *data, u32 width,
+    i32 residual[][16], u8 *above, u8 *left, u32 constrainedIntraPred)
 {
 
 /* Variables */
@@ -654,28 +695,29 @@ u32 h264bsdIntra16x16Prediction(mbStorage_t *pMb, u8 *data, i32 residual[][16],
         case 0: /* Intra_16x16_Vertical */
             if (!availableB)
                 return(HANTRO_NOK);
-            Intra16x16VerticalPrediction(data, above+1);
+            Intra16x16VerticalPrediction(data, width, above+1);
             break;
 
         case 1: /* Intra_16x16_Horizontal */
             if (!availableA)
                 return(HANTRO_NOK);
-            Intra16x16HorizontalPrediction(data, left);
+            Intra16x16HorizontalPrediction(data, width, left);
             break;
 
         case 2: /* Intra_16x16_DC */
-            Intra16x16DcPrediction(data, above+1, left, availableA, availableB);
+            Intra16x16DcPrediction(data, width, above+1, left, availableA,
+                availableB);
             break;
 
         default: /* case 3: Intra_16x16_Plane */
             if (!availableA || !availableB || !availableD)
                 return(HANTRO_NOK);
-            Intra16x16PlanePrediction(data, above+1, left);
+            Intra16x16PlanePrediction(data, width, above+1, left);
             break;
     }
     /* add residual */
     for (i = 0; i < 16; i++)
-        h264bsdAddResidual(data, residual[i], i);
+        h264bsdAddResidual(data, width, residual[i], i);
 
     return(HANTRO_OK);
 
@@ -687,13 +729,13 @@ u32 h264bsdIntra16x16Prediction(mbStorage_t *pMb, u8 *data, i32 residual[][16],
 
         Functional description:
           Perform intra 4x4 prediction for luma pixels and add residual
-          into prediction. The resulting luma pixels are stored in
-          macroblock array 'data'. The intra 4x4 prediction mode for each
+          into prediction. The resulting luma pixels are stored in 'data',
+          line length 'width'. The intra 4x4 prediction mode for each
           block is stored in 'pMb' structure.
 
 ------------------------------------------------------------------------------*/
 
-u32 h264bsdIntra4x4Prediction(mbStorage_t *pMb, u8 *data,
+u32 h264bsdIntra4x4Prediction(mbStorage_t *pMb, u8 *data, u32 width,
                               macroblockLayer_t *mbLayer, u8 *above,
                               u8 *left, u32 constrainedIntraPred)
 {
@@ -705,7 +747,9 @@ u32 h264bsdIntra4x4Prediction(mbStorage_t *pMb, u8 *data,
     neighbour_t neighbour, neighbourB;
     mbStorage_t *nMb, *nMb2;
     u8 a[1 + 4 + 4], l[1 + 4];
+#ifndef H264DEC_SIMD
     u32 data4x4[4];
+#endif
     u32 availableA, availableB, availableC, availableD;
 
 /* Code */
@@ -761,8 +805,41 @@ u32 h264bsdIntra4x4Prediction(mbStorage_t *pMb, u8 *data,
             availableD = HANTRO_FALSE;
         }
 
-        Get4x4NeighbourPels(a, l, data, above, left, block);
+        Get4x4NeighbourPels(a, l, data, width, above, left, block);
+
+#ifdef H264DEC_SIMD
+        switch(mode)
+        {
+            case 0: /* Intra_4x4_Vertical */
+            case 3: /* Intra_4x4_Diagonal_Down_Left */
+            case 7: /* Intra_4x4_Vertical_Left */
+                if (!availableB)
+                    return(HANTRO_NOK);
+                break;
+            case 1: /* Intra_4x4_Horizontal */
+            case 8: /* Intra_4x4_Horizontal_Up */
+                if (!availableA)
+                    return(HANTRO_NOK);
+                break;
+            case 4: /* Intra_4x4_Diagonal_Down_Right */
+            case 5: /* Intra_4x4_Vertical_Right */
+            case 6: /* Intra_4x4_Horizontal_Down */
+                if (!availableA || !availableB || !availableD)
+                    return(HANTRO_NOK);
+                break;
+            default: /* case 2: Intra_4x4_DC */
+                break;
+        }
+        /* above-right samples are used only by modes 3 and 7 */
+        if (!availableC)
+        {
+            a[5] = a[6] = a[7] = a[8] = a[4];
+        }
 
+        /* prediction is written directly into the macroblock */
+        Intra4x4PredictionSimd(data + h264bsdBlockY[block]*width +
+            h264bsdBlockX[block], width, a, l, mode, availableA, availableB);
+#else
         switch(mode)
         {
             case 0: /* Intra_4x4_Vertical */
@@ -819,8 +896,10 @@ u32 h264bsdIntra4x4Prediction(mbStorage_t *pMb, u8 *data,
                 break;
         }
 
-        Write4x4To16x16(data, (u8*)data4x4, block);
-        h264bsdAddResidual(data, mbLayer->residual.level[block], block);
+        Write4x4To16x16(data, width, (u8*)data4x4, block);
+#endif /* H264DEC_SIMD */
+        h264bsdAddResidual(data, width, mbLayer->residual.level[block],
+            block);
     }
 
     return(HANTRO_OK);
@@ -833,22 +912,26 @@ u32 h264bsdIntra4x4Prediction(mbStorage_t *pMb, u8 *data,
 
         Functional description:
           Perform intra prediction for chroma pixels and add residual
-          into prediction. The resulting chroma pixels are stored in 'data'.
+          into prediction. The resulting chroma pixels are stored in 'cb'
+          and 'cr', line length 'width'.
 
 ------------------------------------------------------------------------------*/
 
-u32 h264bsdIntraChromaPrediction(mbStorage_t *pMb, u8 *data, i32 residual[][16],
-                    u8 *above, u8 *left, u32 predMode, u32 constrainedIntraPred)
+u32 h264bsdIntraChromaPrediction(mbStorage_t *pMb, u8 *cb, u8 *cr, u32 width,
+    i32 residual[][16], u8 *above, u8 *left, u32 predMode,
+    u32 constrainedIntraPred)
 {
 
 /* Variables */
 
     u32 i, comp, block;
     u32 availableA, availableB, availableD;
+    u8 *data;
 
 /* Code */
 
-    ASSERT(data);
+    ASSERT(cb);
+    ASSERT(cr);
     ASSERT(residual);
     ASSERT(above);
     ASSERT(left);
@@ -869,37 +952,37 @@ u32 h264bsdIntraChromaPrediction(mbStorage_t *pMb, u8 *data, i32 residual[][16],
 
     for (comp = 0, block = 16; comp < 2; comp++)
     {
+        data = comp ? cr : cb;
         switch(predMode)
         {
             case 0: /* Intra_Chroma_DC */
-                IntraChromaDcPrediction(data, above+1, left, availableA,
-                    availableB);
+                IntraChromaDcPrediction(data, width, above+1, left,
+                    availableA, availableB);
                 break;
 
             case 1: /* Intra_Chroma_Horizontal */
                 if (!availableA)
                     return(HANTRO_NOK);
-                IntraChromaHorizontalPrediction(data, left);
+                IntraChromaHorizontalPrediction(data, width, left);
                 break;
 
             case 2: /* Intra_Chroma_Vertical */
                 if (!availableB)
                     return(HANTRO_NOK);
-                IntraChromaVerticalPrediction(data, above+1);
+                IntraChromaVerticalPrediction(data, width, above+1);
 
                 break;
 
             default: /* case 3: Intra_Chroma_Plane */
                 if (!availableA || !availableB || !availableD)
                     return(HANTRO_NOK);
-                IntraChromaPlanePrediction(data, above+1, left);
+                IntraChromaPlanePrediction(data, width, above+1, left);
                 break;
         }
         for (i = 0; i < 4; i++, block++)
-            h264bsdAddResidual(data, residual[i], block);
+            h264bsdAddResidual(data, width, residual[i], block);
 
         /* advance pointers */
-        data += 64;
         above += 9;
         left += 8;
         residual += 4;
@@ -914,22 +997,25 @@ u32 h264bsdIntraChromaPrediction(mbStorage_t *pMb, u8 *data, i32 residual[][16],
     Function: h264bsdAddResidual
 
         Functional description:
-          Add residual of a block into prediction in macroblock array 'data'.
-          The result (residual + prediction) is stored in 'data'.
+          Add residual of a block into prediction in 'data', line length
+          'width'. Luma blocks are 0 to 15, chroma blocks 16 to 23 and
+          'data' points to the chroma component of the block. The result
+          (residual + prediction) is stored in 'data'.
 
 ------------------------------------------------------------------------------*/
 #ifndef H264DEC_OMXDL
-void h264bsdAddResidual(u8 *data, i32 *residual, u32 blockNum)
+void h264bsdAddResidual(u8 *data, u32 width, i32 *residual, u32 blockNum)
 {
 
 /* Variables */
 
-    u32 i;
     u32 x, y;
-    u32 width;
-    i32 tmp1, tmp2, tmp3, tmp4;
     u8 *tmp;
+#ifndef H264DEC_SIMD
+    u32 i;
+    i32 tmp1, tmp2, tmp3, tmp4;
     const u8 *clp = h264bsdClip + 512;
+#endif
 
 /* Code */
 
@@ -944,18 +1030,19 @@ void h264bsdAddResidual(u8 *data, i32 *residual, u32 blockNum)
 
     if (blockNum < 16)
     {
-        width = 16;
         x = h264bsdBlockX[blockNum];
         y = h264bsdBlockY[blockNum];
     }
     else
     {
-        width = 8;
         x = h264bsdBlockX[blockNum & 0x3];
         y = h264bsdBlockY[blockNum & 0x3];
     }
 
     tmp = data + y*width + x;
+#ifdef H264DEC_SIMD
+    h264bsdAddResidual4x4(tmp, width, tmp, width, residual);
+#else
     for (i = 4; i; i--)
     {
         tmp1 = *residual++;
@@ -980,9 +1067,12 @@ void h264bsdAddResidual(u8 *data, i32 *residual, u32 blockNum)
 
         tmp += width;
     }
+#endif /* H264DEC_SIMD */
 
 }
 #endif
+#ifndef H264DEC_SIMD
+
 /*------------------------------------------------------------------------------
 
     Function: Intra16x16VerticalPrediction
@@ -992,7 +1082,7 @@ void h264bsdAddResidual(u8 *data, i32 *residual, u32 blockNum)
 
 ------------------------------------------------------------------------------*/
 
-void Intra16x16VerticalPrediction(u8 *data, u8 *above)
+void Intra16x16VerticalPrediction(u8 *data, u32 width, u8 *above)
 {
 
 /* Variables */
@@ -1004,11 +1094,11 @@ void Intra16x16VerticalPrediction(u8 *data, u8 *above)
     ASSERT(data);
     ASSERT(above);
 
-    for (i = 0; i < 16; i++)
+    for (i = 0; i < 16; i++, data += width)
     {
         for (j = 0; j < 16; j++)
         {
-            *data++ = above[j];
+            data[j] = above[j];
         }
     }
 
@@ -1023,7 +1113,7 @@ void Intra16x16VerticalPrediction(u8 *data, u8 *above)
 
 ------------------------------------------------------------------------------*/
 
-void Intra16x16HorizontalPrediction(u8 *data, u8 *left)
+void Intra16x16HorizontalPrediction(u8 *data, u32 width, u8 *left)
 {
 
 /* Variables */
@@ -1035,11 +1125,11 @@ void Intra16x16HorizontalPrediction(u8 *data, u8 *left)
     ASSERT(data);
     ASSERT(left);
 
-    for (i = 0; i < 16; i++)
+    for (i = 0; i < 16; i++, data += width)
     {
         for (j = 0; j < 16; j++)
         {
-            *data++ = left[i];
+            data[j] = left[i];
         }
     }
 
@@ -1054,13 +1144,13 @@ void Intra16x16HorizontalPrediction(u8 *data, u8 *left)
 
 ------------------------------------------------------------------------------*/
 
-void Intra16x16DcPrediction(u8 *data, u8 *above, u8 *left, u32 availableA,
-    u32 availableB)
+void Intra16x16DcPrediction(u8 *data, u32 width, u8 *above, u8 *left,
+    u32 availableA, u32 availableB)
 {
 
 /* Variables */
 
-    u32 i, tmp;
+    u32 i, j, tmp;
 
 /* Code */
 
@@ -1091,8 +1181,9 @@ void Intra16x16DcPrediction(u8 *data, u8 *above, u8 *left, u32 availableA,
     {
         tmp = 128;
     }
-    for (i = 0; i < 256; i++)
-        data[i] = (u8)tmp;
+    for (i = 0; i < 16; i++, data += width)
+        for (j = 0; j < 16; j++)
+            data[j] = (u8)tmp;
 
 }
 
@@ -1105,7 +1196,7 @@ void Intra16x16DcPrediction(u8 *data, u8 *above, u8 *left, u32 availableA,
 
 ------------------------------------------------------------------------------*/
 
-void Intra16x16PlanePrediction(u8 *data, u8 *above, u8 *left)
+void Intra16x16PlanePrediction(u8 *data, u32 width, u8 *above, u8 *left)
 {
 
 /* Variables */
@@ -1137,7 +1228,7 @@ void Intra16x16PlanePrediction(u8 *data, u8 *above, u8 *left)
         for (j = 0; j < 16; j++)
         {
             tmp = (a + b * (j - 7) + c * (i - 7) + 16) >> 5;
-            data[i*16+j] = (u8)CLIP1(tmp);
+            data[(u32)i*width+(u32)j] = (u8)CLIP1(tmp);
         }
     }
 
@@ -1152,8 +1243,8 @@ void Intra16x16PlanePrediction(u8 *data, u8 *above, u8 *left)
 
 ------------------------------------------------------------------------------*/
 
-void IntraChromaDcPrediction(u8 *data, u8 *above, u8 *left, u32 availableA,
-    u32 availableB)
+void IntraChromaDcPrediction(u8 *data, u32 width, u8 *above, u8 *left,
+    u32 availableA, u32 availableB)
 {
 
 /* Variables */
@@ -1192,16 +1283,16 @@ void IntraChromaDcPrediction(u8 *data, u8 *above, u8 *left, u32 availableA,
     }
 
     ASSERT(tmp1 < 256 && tmp2 < 256);
-    for (i = 4; i--;)
+    for (i = 4; i--; data += width)
     {
-        *data++ = (u8)tmp1;
-        *data++ = (u8)tmp1;
-        *data++ = (u8)tmp1;
-        *data++ = (u8)tmp1;
-        *data++ = (u8)tmp2;
-        *data++ = (u8)tmp2;
-        *data++ = (u8)tmp2;
-        *data++ = (u8)tmp2;
+        data[0] = (u8)tmp1;
+        data[1] = (u8)tmp1;
+        data[2] = (u8)tmp1;
+        data[3] = (u8)tmp1;
+        data[4] = (u8)tmp2;
+        data[5] = (u8)tmp2;
+        data[6] = (u8)tmp2;
+        data[7] = (u8)tmp2;
     }
 
     /* y = 4...7 */
@@ -1228,16 +1319,16 @@ void IntraChromaDcPrediction(u8 *data, u8 *above, u8 *left, u32 availableA,
     }
 
     ASSERT(tmp1 < 256 && tmp2 < 256);
-    for (i = 4; i--;)
+    for (i = 4; i--; data += width)
     {
-        *data++ = (u8)tmp1;
-        *data++ = (u8)tmp1;
-        *data++ = (u8)tmp1;
-        *data++ = (u8)tmp1;
-        *data++ = (u8)tmp2;
-        *data++ = (u8)tmp2;
-        *data++ = (u8)tmp2;
-        *data++ = (u8)tmp2;
+        data[0] = (u8)tmp1;
+        data[1] = (u8)tmp1;
+        data[2] = (u8)tmp1;
+        data[3] = (u8)tmp1;
+        data[4] = (u8)tmp2;
+        data[5] = (u8)tmp2;
+        data[6] = (u8)tmp2;
+        data[7] = (u8)tmp2;
     }
 }
 
@@ -1250,7 +1341,7 @@ void IntraChromaDcPrediction(u8 *data, u8 *above, u8 *left, u32 availableA,
 
 ------------------------------------------------------------------------------*/
 
-void IntraChromaHorizontalPrediction(u8 *data, u8 *left)
+void IntraChromaHorizontalPrediction(u8 *data, u32 width, u8 *left)
 {
 
 /* Variables */
@@ -1262,16 +1353,16 @@ void IntraChromaHorizontalPrediction(u8 *data, u8 *left)
     ASSERT(data);
     ASSERT(left);
 
-    for (i = 8; i--;)
+    for (i = 8; i--; data += width)
     {
-        *data++ = *left;
-        *data++ = *left;
-        *data++ = *left;
-        *data++ = *left;
-        *data++ = *left;
-        *data++ = *left;
-        *data++ = *left;
-        *data++ = *left++;
+        data[0] = *left;
+        data[1] = *left;
+        data[2] = *left;
+        data[3] = *left;
+        data[4] = *left;
+        data[5] = *left;
+        data[6] = *left;
+        data[7] = *left++;
     }
 
 }
@@ -1285,28 +1376,22 @@ void IntraChromaHorizontalPrediction(u8 *data, u8 *left)
 
 ------------------------------------------------------------------------------*/
 
-void IntraChromaVerticalPrediction(u8 *data, u8 *above)
+void IntraChromaVerticalPrediction(u8 *data, u32 width, u8 *above)
 {
 
 /* Variables */
 
-    u32 i;
+    u32 i, j;
 
 /* Code */
 
     ASSERT(data);
     ASSERT(above);
 
-    for (i = 8; i--;data++/*above-=8*/)
+    for (i = 8; i--; data += width)
     {
-        data[0] = *above;
-        data[8] = *above;
-        data[16] = *above;
-        data[24] = *above;
-        data[32] = *above;
-        data[40] = *above;
-        data[48] = *above;
-        data[56] = *above++;
+        for (j = 0; j < 8; j++)
+            data[j] = above[j];
     }
 
 }
@@ -1320,7 +1405,7 @@ void IntraChromaVerticalPrediction(u8 *data, u8 *above)
 
 ------------------------------------------------------------------------------*/
 
-void IntraChromaPlanePrediction(u8 *data, u8 *above, u8 *left)
+void IntraChromaPlanePrediction(u8 *data, u32 width, u8 *above, u8 *left)
 {
 
 /* Variables */
@@ -1349,39 +1434,42 @@ void IntraChromaPlanePrediction(u8 *data, u8 *above, u8 *left)
 
     /*a += 16;*/
     a = a - 3 * c + 16;
-    for (i = 8; i--; a += c)
+    for (i = 8; i--; a += c, data += width)
     {
         tmp = (a - 3 * b);
-        *data++ = clp[tmp>>5];
+        data[0] = clp[tmp>>5];
         tmp += b;
-        *data++ = clp[tmp>>5];
+        data[1] = clp[tmp>>5];
         tmp += b;
-        *data++ = clp[tmp>>5];
+        data[2] = clp[tmp>>5];
         tmp += b;
-        *data++ = clp[tmp>>5];
+        data[3] = clp[tmp>>5];
         tmp += b;
-        *data++ = clp[tmp>>5];
+        data[4] = clp[tmp>>5];
         tmp += b;
-        *data++ = clp[tmp>>5];
+        data[5] = clp[tmp>>5];
         tmp += b;
-        *data++ = clp[tmp>>5];
+        data[6] = clp[tmp>>5];
         tmp += b;
-        *data++ = clp[tmp>>5];
+        data[7] = clp[tmp>>5];
     }
 
 }
 
+#endif /* !H264DEC_SIMD */
+
 /*------------------------------------------------------------------------------
 
     Function: Get4x4NeighbourPels
 
         Functional description:
-          Get neighbouring pixels of a 4x4 block into 'a' and 'l'.
+          Get neighbouring pixels of a 4x4 block into 'a' and 'l'. Pixels
+          inside the macroblock are read from 'data', line length 'width'.
 
 ------------------------------------------------------------------------------*/
 
-void Get4x4NeighbourPels(u8 *a, u8 *l, u8 *data, u8 *above, u8 *left,
-    u32 blockNum)
+void Get4x4NeighbourPels(u8 *a, u8 *l, u8 *data, u32 width, u8 *above,
+    u8 *left, u32 blockNum)
 {
 
 /* Variables */
@@ -1415,12 +1503,12 @@ void Get4x4NeighbourPels(u8 *a, u8 *l, u8 *data, u8 *above, u8 *left,
     }
     else
     {
-        t1 = data[y * 16 + x - 1     ];
-        t2 = data[y * 16 + x - 1 + 16];
+        t1 = data[y * width + x - 1          ];
+        t2 = data[y * width + x - 1 +   width];
         l[1] = t1;
         l[2] = t2;
-        t1 = data[y * 16 + x - 1 + 32];
-        t2 = data[y * 16 + x - 1 + 48];
+        t1 = data[y * width + x - 1 + 2*width];
+        t2 = data[y * width + x - 1 + 3*width];
         l[3] = t1;
         l[4] = t2;
     }
@@ -1451,31 +1539,40 @@ void Get4x4NeighbourPels(u8 *a, u8 *l, u8 *data, u8 *above, u8 *left,
     }
     else
     {
-        t1 = data[(y - 1) * 16 + x    ];
-        t2 = data[(y - 1) * 16 + x + 1];
+        t1 = data[(y - 1) * width + x    ];
+        t2 = data[(y - 1) * width + x + 1];
         a[1] = t1;
         a[2] = t2;
-        t1 = data[(y - 1) * 16 + x + 2];
-        t2 = data[(y - 1) * 16 + x + 3];
+        t1 = data[(y - 1) * width + x + 2];
+        t2 = data[(y - 1) * width + x + 3];
         a[3] = t1;
         a[4] = t2;
-        t1 = data[(y - 1) * 16 + x + 4];
-        t2 = data[(y - 1) * 16 + x + 5];
-        a[5] = t1;
-        a[6] = t2;
-        t1 = data[(y - 1) * 16 + x + 6];
-        t2 = data[(y - 1) * 16 + x + 7];
-        a[7] = t1;
-        a[8] = t2;
+        /* above-right of the rightmost blocks is in the next macroblock,
+         * which is never available and may be written by another thread */
+        if (x < 12)
+        {
+            t1 = data[(y - 1) * width + x + 4];
+            t2 = data[(y - 1) * width + x + 5];
+            a[5] = t1;
+            a[6] = t2;
+            t1 = data[(y - 1) * width + x + 6];
+            t2 = data[(y - 1) * width + x + 7];
+            a[7] = t1;
+            a[8] = t2;
+        }
+        else
+            a[5] = a[6] = a[7] = a[8] = a[4];
 
         if (x == 0)
             l[0] = a[0] = left[y-1];
         else
-            l[0] = a[0] = data[(y - 1) * 16 + x - 1];
+            l[0] = a[0] = data[(y - 1) * width + x - 1];
     }
 }
 
 
+#ifndef H264DEC_SIMD
+
 /*------------------------------------------------------------------------------
 
     Function: Intra4x4VerticalPrediction
@@ -1824,19 +1921,575 @@ void Intra4x4HorizontalUpPrediction(u8 *data, u8 *left)
 
 }
 
+#else /* H264DEC_SIMD */
+
+/*------------------------------------------------------------------------------
+
+    Function: SplatRow16
+
+        Functional description:
+          Vector with all 16 bytes set to a sample value.
+
+------------------------------------------------------------------------------*/
+
+static inline v16u8 SplatRow16(u8 value)
+{
+    return((v16u8){0} + value);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: SumBytes16
+
+        Functional description:
+          Sum of 16 samples.
+
+------------------------------------------------------------------------------*/
+
+static inline u32 SumBytes16(const u8 *p)
+{
+    v16u8 v;
+    v8i16 s;
+
+    v = h264bsdLoad16(p);
+    s = h264bsdUnpackLo(v) + h264bsdUnpackLo(VEC_SHIFT_BYTES(v, 8));
+    s += __builtin_shufflevector(s, s, 4, 5, 6, 7, 0, 1, 2, 3);
+    s += __builtin_shufflevector(s, s, 2, 3, 0, 1, 6, 7, 4, 5);
+    s += __builtin_shufflevector(s, s, 1, 0, 3, 2, 5, 4, 7, 6);
+
+    return((u32)s[0]);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: Intra16x16VerticalPrediction
+
+        Functional description:
+          Perform intra 16x16 vertical prediction mode.
+
+------------------------------------------------------------------------------*/
+
+void Intra16x16VerticalPrediction(u8 *data, u32 width, u8 *above)
+{
+
+/* Variables */
+
+    u32 i;
+    v16u8 v;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(above);
+
+    v = h264bsdLoad16(above);
+    for (i = 16; i--; data += width)
+        h264bsdStore16(data, v);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: Intra16x16HorizontalPrediction
+
+        Functional description:
+          Perform intra 16x16 horizontal prediction mode.
+
+------------------------------------------------------------------------------*/
+
+void Intra16x16HorizontalPrediction(u8 *data, u32 width, u8 *left)
+{
+
+/* Variables */
+
+    u32 i;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(left);
+
+    for (i = 16; i--; data += width)
+        h264bsdStore16(data, SplatRow16(*left++));
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: Intra16x16DcPrediction
+
+        Functional description:
+          Perform intra 16x16 DC prediction mode.
+
+------------------------------------------------------------------------------*/
+
+void Intra16x16DcPrediction(u8 *data, u32 width, u8 *above, u8 *left,
+    u32 availableA, u32 availableB)
+{
+
+/* Variables */
+
+    u32 i, tmp;
+    v16u8 v;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(above);
+    ASSERT(left);
+
+    if (availableA && availableB)
+        tmp = (SumBytes16(above) + SumBytes16(left) + 16) >> 5;
+    else if (availableA)
+        tmp = (SumBytes16(left) + 8) >> 4;
+    else if (availableB)
+        tmp = (SumBytes16(above) + 8) >> 4;
+    /* neither A nor B available */
+    else
+        tmp = 128;
+
+    v = SplatRow16((u8)tmp);
+    for (i = 16; i--; data += width)
+        h264bsdStore16(data, v);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: Intra16x16PlanePrediction
+
+        Functional description:
+          Perform intra 16x16 plane prediction mode. Gradients are computed
+          as in the scalar version, each row is then evaluated in 16-bit
+          lanes. With 8-bit samples |b| and |c| are at most 717, so
+          a + b*(x-7) + c*(y-7) + 16 stays within 16 bits.
+
+------------------------------------------------------------------------------*/
+
+void Intra16x16PlanePrediction(u8 *data, u32 width, u8 *above, u8 *left)
+{
+
+/* Variables */
+
+    i32 i;
+    i32 a, b, c;
+    v8i16 x0, x1;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(above);
+    ASSERT(left);
+
+    a = 16 * (above[15] + left[15]);
+
+    for (i = 0, b = 0; i < 8; i++)
+        b += (i + 1) * (above[8+i] - above[6-i]);
+    b = (5 * b + 32) >> 6;
+
+    for (i = 0, c = 0; i < 7; i++)
+        c += (i + 1) * (left[8+i] - left[6-i]);
+    /* p[-1,-1] has to be accessed through above pointer */
+    c += (i + 1) * (left[8+i] - above[-1]);
+    c = (5 * c + 32) >> 6;
+
+    /* values of the first row, x = 0..7 and x = 8..15 */
+    x0 = (v8i16){-7, -6, -5, -4, -3, -2, -1, 0} * (i16)b +
+         (i16)(a - 7 * c + 16);
+    x1 = x0 + (i16)(8 * b);
+
+    for (i = 16; i--; data += width)
+    {
+        h264bsdStoreNarrow8(data, h264bsdClip255(x0 >> 5));
+        h264bsdStoreNarrow8(data + 8, h264bsdClip255(x1 >> 5));
+        x0 += (i16)c;
+        x1 += (i16)c;
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: IntraChromaDcPrediction
+
+        Functional description:
+          Perform intra chroma DC prediction mode.
+
+------------------------------------------------------------------------------*/
+
+void IntraChromaDcPrediction(u8 *data, u32 width, u8 *above, u8 *left,
+    u32 availableA, u32 availableB)
+{
+
+/* Variables */
+
+    u32 i;
+    u32 tmp1, tmp2;
+    v8u8 row;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(above);
+    ASSERT(left);
+
+    /* y = 0..3 */
+    if (availableA && availableB)
+    {
+        tmp1 = above[0] + above[1] + above[2] + above[3] +
+              left[0] + left[1] + left[2] + left[3];
+        tmp1 = (tmp1 + 4) >> 3;
+        tmp2 = (above[4] + above[5] + above[6] + above[7] + 2) >> 2;
+    }
+    else if (availableB)
+    {
+        tmp1 = (above[0] + above[1] + above[2] + above[3] + 2) >> 2;
+        tmp2 = (above[4] + above[5] + above[6] + above[7] + 2) >> 2;
+    }
+    else if (availableA)
+    {
+        tmp1 = (left[0] + left[1] + left[2] + left[3] + 2) >> 2;
+        tmp2 = tmp1;
+    }
+    /* neither A nor B available */
+    else
+    {
+        tmp1 = tmp2 = 128;
+    }
+
+    ASSERT(tmp1 < 256 && tmp2 < 256);
+    row = (v8u8){(u8)tmp1, (u8)tmp1, (u8)tmp1, (u8)tmp1,
+                 (u8)tmp2, (u8)tmp2, (u8)tmp2, (u8)tmp2};
+    for (i = 4; i--; data += width)
+        memcpy(data, &row, 8);
+
+    /* y = 4...7 */
+    if (availableA)
+    {
+        tmp1 = (left[4] + left[5] + left[6] + left[7] + 2) >> 2;
+        if (availableB)
+        {
+            tmp2 = above[4] + above[5] + above[6] + above[7] +
+                   left[4] + left[5] + left[6] + left[7];
+            tmp2 = (tmp2 + 4) >> 3;
+        }
+        else
+            tmp2 = tmp1;
+    }
+    else if (availableB)
+    {
+        tmp1 = (above[0] + above[1] + above[2] + above[3] + 2) >> 2;
+        tmp2 = (above[4] + above[5] + above[6] + above[7] + 2) >> 2;
+    }
+    else
+    {
+        tmp1 = tmp2 = 128;
+    }
+
+    ASSERT(tmp1 < 256 && tmp2 < 256);
+    row = (v8u8){(u8)tmp1, (u8)tmp1, (u8)tmp1, (u8)tmp1,
+                 (u8)tmp2, (u8)tmp2, (u8)tmp2, (u8)tmp2};
+    for (i = 4; i--; data += width)
+        memcpy(data, &row, 8);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: IntraChromaHorizontalPrediction
+
+        Functional description:
+          Perform intra chroma horizontal prediction mode.
+
+------------------------------------------------------------------------------*/
+
+void IntraChromaHorizontalPrediction(u8 *data, u32 width, u8 *left)
+{
+
+/* Variables */
+
+    u32 i;
+    v8u8 row;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(left);
+
+    for (i = 8; i--; data += width)
+    {
+        row = (v8u8){0} + *left++;
+        memcpy(data, &row, 8);
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: IntraChromaVerticalPrediction
+
+        Functional description:
+          Perform intra chroma vertical prediction mode.
+
+------------------------------------------------------------------------------*/
+
+void IntraChromaVerticalPrediction(u8 *data, u32 width, u8 *above)
+{
+
+/* Variables */
+
+    u32 i;
+    v8u8 row;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(above);
+
+    memcpy(&row, above, 8);
+    for (i = 8; i--; data += width)
+        memcpy(data, &row, 8);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: IntraChromaPlanePrediction
+
+        Functional description:
+          Perform intra chroma plane prediction mode, rows are evaluated in
+          16-bit lanes as in Intra16x16PlanePrediction.
+
+------------------------------------------------------------------------------*/
+
+void IntraChromaPlanePrediction(u8 *data, u32 width, u8 *above, u8 *left)
+{
+
+/* Variables */
+
+    u32 i;
+    i32 a, b, c;
+    v8i16 x;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(above);
+    ASSERT(left);
+
+    a = 16 * (above[7] + left[7]);
+
+    b = (above[4] - above[2]) + 2 * (above[5] - above[1])
+        + 3 * (above[6] - above[0]) + 4 * (above[7] - above[-1]);
+    b = (17 * b + 16) >> 5;
+
+    /* p[-1,-1] has to be accessed through above pointer */
+    c = (left[4] - left[2]) + 2 * (left[5] - left[1])
+        + 3 * (left[6] - left[0]) + 4 * (left[7] - above[-1]);
+    c = (17 * c + 16) >> 5;
+
+    x = (v8i16){-3, -2, -1, 0, 1, 2, 3, 4} * (i16)b + (i16)(a - 3 * c + 16);
+    for (i = 8; i--; data += width)
+    {
+        h264bsdStoreNarrow8(data, h264bsdClip255(x >> 5));
+        x += (i16)c;
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: AvgRound, AvgFloor
+
+        Functional description:
+          Byte averages (x + y + 1) >> 1 and (x + y) >> 1 without widening.
+
+------------------------------------------------------------------------------*/
+
+static inline v16u8 AvgRound(v16u8 x, v16u8 y)
+{
+    return((x | y) - ((x ^ y) >> 1));
+}
+
+static inline v16u8 AvgFloor(v16u8 x, v16u8 y)
+{
+    return((x & y) + ((x ^ y) >> 1));
+}
+
+/* four bytes starting at byte n of a vector */
+#define VEC_WORD(v, n) (((v4u32)VEC_SHIFT_BYTES((v), (n)))[0])
+
+/*------------------------------------------------------------------------------
+
+    Function: Store4x4
+
+        Functional description:
+          Store four rows of a 4x4 block, line length 'width'.
+
+------------------------------------------------------------------------------*/
+
+static inline void Store4x4(u8 *data, u32 width, u32 row0, u32 row1,
+    u32 row2, u32 row3)
+{
+    memcpy(data, &row0, 4);
+    memcpy(data + width, &row1, 4);
+    memcpy(data + 2*width, &row2, 4);
+    memcpy(data + 3*width, &row3, 4);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: Intra4x4PredictionSimd
+
+        Functional description:
+          Perform intra 4x4 prediction and write the block directly into
+          its place in the picture or macroblock, line length 'width'. The
+          directional modes filter all neighbour samples at once. The
+          samples are arranged as
+
+            e = l3 l3 l2 l1 l0 q a0 a1 a2 a3 a4 a5 a6 a7 a7 a7
+
+          (q is the above-left sample), after which every predicted sample
+          is either a two-tap average h[i] = (e[i] + e[i+1] + 1) >> 1 or a
+          three-tap filter f[i] = (e[i] + 2*e[i+1] + e[i+2] + 2) >> 2. The
+          latter is computed as the rounded average of e[i+1] and
+          (e[i] + e[i+2]) >> 1, which gives the same result. Rows of each
+          mode are 4-byte windows of h, f or of the two interleaved.
+
+        Inputs:
+          a             samples above, a[0] above-left, a[5..8] above-right
+          l             samples left, l[0] above-left
+          mode          intra 4x4 prediction mode
+          availableA    left neighbour available, used by DC
+          availableB    above neighbour available, used by DC
+
+        Outputs:
+          data          predicted block, line length 'width'
+
+------------------------------------------------------------------------------*/
+
+void Intra4x4PredictionSimd(u8 *data, u32 width, u8 *a, u8 *l, u32 mode,
+    u32 availableA, u32 availableB)
+{
+
+/* Variables */
+
+    u32 tmp;
+    u64 above, lo, hi;
+    v16u8 x, y, h, f, z;
+
+/* Code */
+
+    ASSERT(data);
+    ASSERT(a);
+    ASSERT(l);
+    ASSERT(mode < 9);
+
+    if (mode == 0) /* Intra_4x4_Vertical */
+    {
+        memcpy(&tmp, a + 1, 4);
+        Store4x4(data, width, tmp, tmp, tmp, tmp);
+        return;
+    }
+    else if (mode == 1) /* Intra_4x4_Horizontal */
+    {
+        Store4x4(data, width, l[1] * 0x01010101U, l[2] * 0x01010101U,
+            l[3] * 0x01010101U, l[4] * 0x01010101U);
+        return;
+    }
+    else if (mode == 2) /* Intra_4x4_DC */
+    {
+        if (availableA && availableB)
+            tmp = (a[1] + a[2] + a[3] + a[4] + l[1] + l[2] + l[3] + l[4] +
+                4) >> 3;
+        else if (availableA)
+            tmp = (l[1] + l[2] + l[3] + l[4] + 2) >> 2;
+        else if (availableB)
+            tmp = (a[1] + a[2] + a[3] + a[4] + 2) >> 2;
+        else
+            tmp = 128;
+        tmp *= 0x01010101U;
+        Store4x4(data, width, tmp, tmp, tmp, tmp);
+        return;
+    }
+
+    /* build the edge in two 64-bit halves, lane order is little-endian */
+    memcpy(&tmp, l + 1, 4);
+    if (mode == 8) /* Intra_4x4_Horizontal_Up, only left samples */
+    {
+        /* e = l0 l1 l2 l3 l3 ..., rows are windows of interleaved h and f */
+        lo = tmp | (l[4] * 0x0101010100000000ULL);
+        hi = l[4] * 0x0101010101010101ULL;
+    }
+    else
+    {
+        memcpy(&above, a, 8);
+        lo = l[4] | ((u64)__builtin_bswap32(tmp) << 8) | (above << 40);
+        hi = (above >> 24) | (a[8] * 0x0101010000000000ULL);
+    }
+
+    x = (v16u8)(v2u64){lo, hi};
+    y = VEC_SHIFT_BYTES(x, 1);
+    h = AvgRound(x, y);
+    f = AvgRound(y, AvgFloor(x, VEC_SHIFT_BYTES(x, 2)));
+
+    switch (mode)
+    {
+        case 3: /* Intra_4x4_Diagonal_Down_Left */
+            Store4x4(data, width, VEC_WORD(f, 6), VEC_WORD(f, 7),
+                VEC_WORD(f, 8), VEC_WORD(f, 9));
+            break;
+
+        case 4: /* Intra_4x4_Diagonal_Down_Right */
+            Store4x4(data, width, VEC_WORD(f, 4), VEC_WORD(f, 3),
+                VEC_WORD(f, 2), VEC_WORD(f, 1));
+            break;
+
+        case 5: /* Intra_4x4_Vertical_Right */
+            Store4x4(data, width, VEC_WORD(h, 5), VEC_WORD(f, 4),
+                (VEC_WORD(h, 4) & ~0xFFU) | (VEC_WORD(f, 3) & 0xFF),
+                (VEC_WORD(f, 3) & ~0xFFU) | (VEC_WORD(f, 2) & 0xFF));
+            break;
+
+        case 6: /* Intra_4x4_Horizontal_Down */
+            /* z = h0 f0 h1 f1 h2 f2 ... */
+            z = __builtin_shufflevector(h, f,
+                0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+            Store4x4(data, width,
+                (VEC_WORD(f, 3) & ~0xFFU) | (VEC_WORD(h, 4) & 0xFF),
+                VEC_WORD(z, 6), VEC_WORD(z, 4), VEC_WORD(z, 2));
+            break;
+
+        case 7: /* Intra_4x4_Vertical_Left */
+            Store4x4(data, width, VEC_WORD(h, 6), VEC_WORD(f, 6),
+                VEC_WORD(h, 7), VEC_WORD(f, 7));
+            break;
+
+        default: /* case 8: Intra_4x4_Horizontal_Up */
+            z = __builtin_shufflevector(h, f,
+                0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+            Store4x4(data, width, VEC_WORD(z, 0), VEC_WORD(z, 2),
+                VEC_WORD(z, 4), VEC_WORD(z, 6));
+            break;
+    }
+
+}
+
+#endif /* H264DEC_SIMD */
+
 #endif /* H264DEC_OMXDL */
 
+#ifndef H264DEC_SIMD
 /*------------------------------------------------------------------------------
 
     Function: Write4x4To16x16
 
         Functional description:
           Write a 4x4 block (data4x4) into correct position
-          in 16x16 macroblock (data).
+          in 16x16 macroblock (data), line length 'width'.
 
 ------------------------------------------------------------------------------*/
 
-void Write4x4To16x16(u8 *data, u8 *data4x4, u32 blockNum)
+void Write4x4To16x16(u8 *data, u32 width, u8 *data4x4, u32 blockNum)
 {
 
 /* Variables */
@@ -1853,7 +2506,7 @@ void Write4x4To16x16(u8 *data, u8 *data4x4, u32 blockNum)
     x = h264bsdBlockX[blockNum];
     y = h264bsdBlockY[blockNum];
 
-    data += y*16+x;
+    data += y*width+x;
 
     ASSERT(((u32)data&0x3) == 0);
 
@@ -1862,11 +2515,13 @@ void Write4x4To16x16(u8 *data, u8 *data4x4, u32 blockNum)
     /*lint --e(826) */
     in32 = (u32 *)data4x4;
 
+    width >>= 2;
     out32[0] = *in32++;
-    out32[4] = *in32++;
-    out32[8] = *in32++;
-    out32[12] = *in32++;
+    out32[width] = *in32++;
+    out32[2*width] = *in32++;
+    out32[3*width] = *in32++;
 }
+#endif /* H264DEC_SIMD */
 
 /*------------------------------------------------------------------------------
 
@@ -51,16 +51,18 @@
 u32 h264bsdIntraPrediction(mbStorage_t *pMb, macroblockLayer_t *mbLayer,
     image_t *image, u32 mbNum, u32 constrainedIntraPred, u8 *data);
 
-u32 h264bsdIntra4x4Prediction(mbStorage_t *pMb, u8 *data,
+u32 h264bsdIntra4x4Prediction(mbStorage_t *pMb, u8 *data, u32 width,
                               macroblockLayer_t *mbLayer,
                               u8 *above, u8 *left, u32 constrainedIntraPred);
-u32 h264bsdIntra16x16Prediction(mbStorage_t *pMb, u8 *data, i32 residual[][16],
-    u8 *above, u8 *left, u32 constrainedIntraPred);
+u32 h264bsdIntra16x16Prediction(mbStorage_t *pMb, u8 *data, u32 width,
+    i32 residual[][16], u8 *above, u8 *left, u32 constrainedIntraPred);
 
-u32 h264bsdIntraChromaPrediction(mbStorage_t *pMb, u8 *data, i32 residual[][16],
-    u8 *above, u8 *left, u32 predMode, u32 constrainedIntraPred);
+u32 h264bsdIntraChromaPrediction(mbStorage_t *pMb, u8 *cb, u8 *cr, u32 width,
+    i32 residual[][16], u8 *above, u8 *left, u32 predMode,
+    u32 constrainedIntraPred);
 
-void h264bsdGetNeighbourPels(image_t *image, u8 *above, u8 *left, u32 mbNum);
+void h264bsdGetNeighbourPels(mbStorage_t *pMb, image_t *image, u8 *above,
+    u8 *left, u32 mbNum);
 
 #else
 
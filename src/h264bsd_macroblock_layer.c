@@ -33,6 +33,7 @@
           DetermineNc
           CbpIntra16x16
           h264bsdPredModeIntra16x16
+          h264bsdStoreMacroblockParams
           h264bsdDecodeMacroblock
           ProcessResidual
           h264bsdSubMbPartMode
@@ -934,25 +935,105 @@ u32 h264bsdPredModeIntra16x16(mbType_e mbType)
 
 }
 
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdStoreMacroblockParams
+
+        Functional description:
+          Store parameters of a parsed macroblock that are needed already
+          when parsing the following macroblocks, i.e. macroblock type,
+          number of coefficients of each block (used to select the coeff
+          token tables of neighbouring blocks) and quantization parameter.
+          Called for each macroblock before h264bsdDecodeMacroblock.
+
+        Inputs:
+          pMb           pointer to macroblock specific information
+          mbLayer       pointer to current macroblock data from stream
+          qpY           pointer to slice QP
+
+        Outputs:
+          pMb           structure is updated with current macroblock
+          qpY           updated with QP of the macroblock
+
+        Returns:
+          none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdStoreMacroblockParams(mbStorage_t *pMb,
+    macroblockLayer_t *pMbLayer, i32 *qpY)
+{
+
+/* Variables */
+
+    u32 i;
+    mbType_e mbType;
+#ifdef H264DEC_OMXDL
+    u8 *tot;
+#else
+    i16 *tot;
+#endif
+
+/* Code */
+
+    ASSERT(pMb);
+    ASSERT(pMbLayer);
+    ASSERT(qpY && *qpY < 52);
+
+    mbType = pMbLayer->mbType;
+    pMb->mbType = mbType;
+
+    pMb->decoded++;
+
+    if (mbType == I_PCM)
+    {
+        pMb->qpY = 0;
+        tot = pMb->totalCoeff;
+        for (i = 24; i--;)
+            *tot++ = 16;
+    }
+    else if (mbType != P_Skip)
+    {
+        H264SwDecMemcpy(pMb->totalCoeff,
+                        pMbLayer->residual.totalCoeff,
+                        27*sizeof(*pMb->totalCoeff));
+
+        /* update qpY */
+        if (pMbLayer->mbQpDelta)
+        {
+            *qpY = *qpY + pMbLayer->mbQpDelta;
+            if (*qpY < 0) *qpY += 52;
+            else if (*qpY >= 52) *qpY -= 52;
+        }
+        pMb->qpY = (u32)*qpY;
+    }
+    else
+    {
+        H264SwDecMemset(pMb->totalCoeff, 0, 27*sizeof(*pMb->totalCoeff));
+        pMb->qpY = (u32)*qpY;
+    }
+
+}
+
 /*------------------------------------------------------------------------------
 
     Function: h264bsdDecodeMacroblock
 
         Functional description:
-          Decode one macroblock and write into output image.
+          Decode one macroblock and write into output image. Parameters of
+          the macroblock have to be stored with h264bsdStoreMacroblockParams
+          first.
 
         Inputs:
           pMb           pointer to macroblock specific information
           mbLayer       pointer to current macroblock data from stream
           currImage     pointer to output image
           dpb           pointer to decoded picture buffer
-          qpY           pointer to slice QP
           mbNum         current macroblock number
           constrainedIntraPred  flag specifying if neighbouring inter
                                 macroblocks are used in intra prediction
 
         Outputs:
-          pMb           structure is updated with current macroblock
           currImage     decoded macroblock is written into output image
 
         Returns:
@@ -962,13 +1043,14 @@ u32 h264bsdPredModeIntra16x16(mbType_e mbType)
 ------------------------------------------------------------------------------*/
 
 u32 h264bsdDecodeMacroblock(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
-    image_t *currImage, dpbStorage_t *dpb, i32 *qpY, u32 mbNum,
+    image_t *currImage, dpbStorage_t *dpb, u32 mbNum,
     u32 constrainedIntraPredFlag, u8* data)
 {
 
 /* Variables */
 
-    u32 i, tmp;
+    u32 i;
+    u32 tmp;
     mbType_e mbType;
 #ifdef H264DEC_OMXDL
     const u8 *pSrc;
@@ -978,43 +1060,24 @@ u32 h264bsdDecodeMacroblock(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
     ASSERT(pMb);
     ASSERT(pMbLayer);
     ASSERT(currImage);
-    ASSERT(qpY && *qpY < 52);
     ASSERT(mbNum < currImage->width*currImage->height);
 
     mbType = pMbLayer->mbType;
-    pMb->mbType = mbType;
-
-    pMb->decoded++;
 
     h264bsdSetCurrImageMbPointers(currImage, mbNum);
 
     if (mbType == I_PCM)
     {
         u8 *pData = (u8*)data;
-#ifdef H264DEC_OMXDL
-        u8 *tot = pMb->totalCoeff;
-#else
-        i16 *tot = pMb->totalCoeff;
-#endif
         i32 *lev = pMbLayer->residual.level[0];
 
-        pMb->qpY = 0;
-
         /* if decoded flag > 1 -> mb has already been successfully decoded and
          * written to output -> do not write again */
         if (pMb->decoded > 1)
-        {
-            for (i = 24; i--;)
-                *tot++ = 16;
             return HANTRO_OK;
-        }
 
-        for (i = 24; i--;)
-        {
-            *tot++ = 16;
-            for (tmp = 16; tmp--;)
-                *pData++ = (u8)(*lev++);
-        }
+        for (i = 384; i--;)
+            *pData++ = (u8)(*lev++);
         h264bsdWriteMacroblock(currImage, (u8*)data);
 
         return(HANTRO_OK);
@@ -1031,19 +1094,6 @@ u32 h264bsdDecodeMacroblock(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
 #endif
         if (mbType != P_Skip)
         {
-            H264SwDecMemcpy(pMb->totalCoeff,
-                            pMbLayer->residual.totalCoeff,
-                            27*sizeof(*pMb->totalCoeff));
-
-            /* update qpY */
-            if (pMbLayer->mbQpDelta)
-            {
-                *qpY = *qpY + pMbLayer->mbQpDelta;
-                if (*qpY < 0) *qpY += 52;
-                else if (*qpY >= 52) *qpY -= 52;
-            }
-            pMb->qpY = (u32)*qpY;
-
 #ifdef H264DEC_OMXDL
             pSrc = pMbLayer->residual.posCoefBuf;
 
@@ -1059,7 +1109,8 @@ u32 h264bsdDecodeMacroblock(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
                     if (*totalCoeff)
                     {
                         res = omxVCM4P10_DequantTransformResidualFromPairAndAdd(
-                                &pSrc, p, 0, p, 16, 16, *qpY, *totalCoeff);
+                                &pSrc, p, 0, p, 16, 16, (i32)pMb->qpY,
+                                *totalCoeff);
                         if (res != OMX_Sts_NoErr)
                             return (HANTRO_NOK);
                     }
@@ -1098,11 +1149,6 @@ u32 h264bsdDecodeMacroblock(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
             if (tmp != HANTRO_OK)
                 return (tmp);
         }
-        else
-        {
-            H264SwDecMemset(pMb->totalCoeff, 0, 27*sizeof(*pMb->totalCoeff));
-            pMb->qpY = (u32)*qpY;
-        }
 #ifdef H264DEC_OMXDL
         /* if decoded flag > 1 -> mb has already been successfully decoded and
          * written to output -> do not write again */
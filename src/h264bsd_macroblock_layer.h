@@ -47,6 +47,18 @@
 /* Macro to determine if a mb is an I_PCM mb */
 #define IS_I_PCM_MB(a) ((a).mbType == 31)
 
+/* Macros to access slice id of a mb. When slices are decoded in parallel
+ * (H264DEC_THREADS) the slice id of a neighbouring mb may be written by
+ * another thread while it is compared */
+#ifdef H264DEC_THREADS
+#define GET_SLICE_ID(pMb) __atomic_load_n(&(pMb)->sliceId, __ATOMIC_RELAXED)
+#define SET_SLICE_ID(pMb, id) \
+    __atomic_store_n(&(pMb)->sliceId, (id), __ATOMIC_RELAXED)
+#else
+#define GET_SLICE_ID(pMb) ((pMb)->sliceId)
+#define SET_SLICE_ID(pMb, id) ((pMb)->sliceId = (id))
+#endif
+
 typedef enum {
     P_Skip          = 0,
     P_L0_16x16      = 1,
@@ -196,8 +208,10 @@ u32 h264bsdNumSubMbPart(subMbType_e subMbType);
 
 subMbPartMode_e h264bsdSubMbPartMode(subMbType_e subMbType);
 
+void h264bsdStoreMacroblockParams(mbStorage_t *pMb,
+    macroblockLayer_t *pMbLayer, i32 *qpY);
 u32 h264bsdDecodeMacroblock(mbStorage_t *pMb, macroblockLayer_t *pMbLayer,
-    image_t *currImage, dpbStorage_t *dpb, i32 *qpY, u32 mbNum,
+    image_t *currImage, dpbStorage_t *dpb, u32 mbNum,
     u32 constrainedIntraPredFlag, u8* data);
 
 u32 h264bsdPredModeIntra16x16(mbType_e mbType);
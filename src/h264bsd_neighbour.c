@@ -373,7 +373,7 @@ u32 h264bsdIsNeighbourAvailable(mbStorage_t *pMb, mbStorage_t *pNeighbour)
 
 /* Code */
 
-    if ( (pNeighbour == NULL) || (pMb->sliceId != pNeighbour->sliceId) )
+    if ( (pNeighbour == NULL) || (pMb->sliceId != GET_SLICE_ID(pNeighbour)) )
         return(HANTRO_FALSE);
     else
         return(HANTRO_TRUE);
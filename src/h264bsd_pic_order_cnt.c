@@ -251,6 +251,12 @@ i32 h264bsdDecodePicOrderCnt(pocStorage_t *poc, seqParamSet_t *sps,
                 frameNumInPicOrderCntCycle =
                     (absFrameNum - 1)%sps->numRefFramesInPicOrderCntCycle;
             }
+            else
+            {
+                /* not used, set to keep the compiler from warning */
+                picOrderCntCycleCnt = 0;
+                frameNumInPicOrderCntCycle = 0;
+            }
 
             /* step 4 */
             expectedDeltaPicOrderCntCycle = 0;
@@ -35,6 +35,9 @@
 #include "h264bsd_macroblock_layer.h"
 #include "h264bsd_image.h"
 #include "h264bsd_util.h"
+#include "h264bsd_simd.h"
+
+#include <string.h>
 
 #ifdef H264DEC_OMXDL
 #include "omxtypes.h"
@@ -69,11 +72,11 @@
  *  G, H, M and N are integer sample positions
  *  a-s are fractional samples that need to be interpolated.
  */
-#ifndef H264DEC_OMXDL
+#if !defined(H264DEC_OMXDL) && !defined(H264DEC_SIMD)
 static const u32 lumaFracPos[4][4] = {
   /* G  d  h  n    a  e  i  p    b  f  j   q     c   g   k   r */
     {0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9, 10, 11}, {12, 13, 14, 15}};
-#endif /* H264DEC_OMXDL */
+#endif /* !H264DEC_OMXDL && !H264DEC_SIMD */
 
 /* clipping table, defined in h264bsd_intra_prediction.c */
 extern const u8 h264bsdClip[];
@@ -403,6 +406,328 @@ void h264bsdInterpolateChromaHorVer(
 
 }
 
+/*------------------------------------------------------------------------------
+
+    Function: ChromaCopyRows
+
+        Functional description:
+          Copy rows of n reference pixels of one chroma component into
+          chrominance output with line length outWidth.
+
+------------------------------------------------------------------------------*/
+
+static inline void ChromaCopyRows(const u8 *ptr, u8 *cbr, u32 outWidth,
+    u32 width, u32 chromaPartHeight, u32 n)
+{
+    u32 y;
+
+    for (y = chromaPartHeight; y; y--)
+    {
+        memcpy(cbr, ptr, n);
+        ptr += width;
+        cbr += outWidth;
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: ChromaCopy
+
+        Functional description:
+          Prediction for integer chroma motion vectors. Blocks inside the
+          reference picture are copied row by row, others are overfilled.
+        Inputs:
+          ref               pointer to reference frame Cb top-left corner
+          x0, y0            integer position of the predicted part
+          width             width of the reference frame chrominance in pixels
+          height            height of the reference frame chrominance in pixels
+          chromaPartWidth   width of the predicted part, 2, 4 or 8
+          chromaPartHeight  height of the predicted part in pixels
+          outWidth          line length of the output
+        Outputs:
+          cb, cr            pointers where predicted parts are written
+
+------------------------------------------------------------------------------*/
+
+static void ChromaCopy(
+  u8 *ref,
+  u8 *cb,
+  u8 *cr,
+  u32 outWidth,
+  i32 x0,
+  i32 y0,
+  u32 width,
+  u32 height,
+  u32 chromaPartWidth,
+  u32 chromaPartHeight)
+{
+
+/* Variables */
+
+    u32 comp;
+    u8 *ptr, *out;
+
+/* Code */
+
+    ASSERT(ref);
+    ASSERT(cb);
+    ASSERT(cr);
+
+    if ((x0 < 0) || ((u32)x0+chromaPartWidth > width) ||
+        (y0 < 0) || ((u32)y0+chromaPartHeight > height))
+    {
+        h264bsdFillBlock(ref, cb, x0, y0, width, height,
+            chromaPartWidth, chromaPartHeight, outWidth);
+        ref += width * height;
+        h264bsdFillBlock(ref, cr, x0, y0, width, height,
+            chromaPartWidth, chromaPartHeight, outWidth);
+        return;
+    }
+
+    for (comp = 0; comp <= 1; comp++)
+    {
+        ptr = ref + (comp * height + (u32)y0) * width + (u32)x0;
+        out = comp ? cr : cb;
+
+        /* constant row lengths let the copies compile to plain moves */
+        if (chromaPartWidth == 8)
+            ChromaCopyRows(ptr, out, outWidth, width, chromaPartHeight, 8);
+        else if (chromaPartWidth == 4)
+            ChromaCopyRows(ptr, out, outWidth, width, chromaPartHeight, 4);
+        else
+            ChromaCopyRows(ptr, out, outWidth, width, chromaPartHeight, 2);
+    }
+
+}
+
+#ifdef H264DEC_SIMD
+
+/*------------------------------------------------------------------------------
+
+    Function: ChromaLoad
+
+        Functional description:
+          Load a row of n reference pixels into 16-bit lanes. Rows of 8
+          pixels fill a vector, narrower rows are loaded from both Cb
+          (at p) and Cr (at p + planeSize) so that one vector holds both
+          components: Cb in lanes 0..n-1 and Cr in lanes n..2n-1.
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 ChromaLoad(const u8 *p, u32 planeSize, u32 n)
+{
+    u32 a32, b32;
+    u16 a16, b16;
+
+    if (n == 8)
+        return(h264bsdLoadWide8(p));
+    else if (n == 4)
+    {
+        memcpy(&a32, p, 4);
+        memcpy(&b32, p + planeSize, 4);
+        return(h264bsdUnpackLo((v16u8)(v4u32){a32, b32, 0, 0}));
+    }
+    else
+    {
+        memcpy(&a16, p, 2);
+        memcpy(&b16, p + planeSize, 2);
+        return(h264bsdUnpackLo((v16u8)(v8u16){a16, b16, 0, 0, 0, 0, 0, 0}));
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: ChromaStore
+
+        Functional description:
+          Store a row of predicted pixels loaded with ChromaLoad, Cr part of
+          macroblock chrominance starts 8*8 bytes after Cb.
+
+------------------------------------------------------------------------------*/
+
+static inline void ChromaStore(u8 *cbr, v8i16 v, u32 n)
+{
+    v8u8 t;
+
+    if (n == 8)
+        h264bsdStoreNarrow8(cbr, v);
+    else
+    {
+        t = __builtin_convertvector(v, v8u8);
+        memcpy(cbr, &t, n);
+        memcpy(cbr + 8*8, (u8*)&t + n, n);
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: ChromaRow
+
+        Functional description:
+          Horizontal pass of the bilinear filter for one row, scaled by 8.
+          The right neighbours are read only when xFrac is non-zero.
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 ChromaRow(const u8 *p, u32 planeSize, u32 xFrac, u32 n)
+{
+    v8i16 a;
+
+    a = ChromaLoad(p, planeSize, n);
+    if (xFrac)
+        return(a * (i16)(8 - xFrac) +
+            ChromaLoad(p + 1, planeSize, n) * (i16)xFrac);
+    else
+        return(a << 3);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: ChromaStrip
+
+        Functional description:
+          Bilinear interpolation of a part n pixels wide. The weighted sum
+          of four samples is at most 64*255 + 32, so all of it is computed
+          in 16-bit lanes. The next row is read only when yFrac is non-zero.
+          Narrower parts hold both components and are written into
+          macroblock chrominance only.
+
+------------------------------------------------------------------------------*/
+
+static inline void ChromaStrip(const u8 *ptr, u8 *cbr, u32 outWidth,
+    u32 width, u32 planeSize, u32 chromaPartHeight, u32 xFrac, u32 yFrac,
+    u32 n)
+{
+    u32 y;
+    v8i16 r0, r1;
+
+    ASSERT(n == 8 || outWidth == 8);
+
+    if (yFrac)
+    {
+        r0 = ChromaRow(ptr, planeSize, xFrac, n);
+        for (y = chromaPartHeight; y; y--)
+        {
+            ptr += width;
+            r1 = ChromaRow(ptr, planeSize, xFrac, n);
+            ChromaStore(cbr,
+                (r0 * (i16)(8 - yFrac) + r1 * (i16)yFrac + 32) >> 6, n);
+            r0 = r1;
+            cbr += outWidth;
+        }
+    }
+    else
+    {
+        /* (8 * r + 32) >> 6 */
+        for (y = chromaPartHeight; y; y--)
+        {
+            r0 = ChromaRow(ptr, planeSize, xFrac, n);
+            ChromaStore(cbr, (r0 + 4) >> 3, n);
+            ptr += width;
+            cbr += outWidth;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: PredictChromaSimd
+
+        Functional description:
+          Vector version of chroma interpolation, bit-exact with
+          h264bsdInterpolateChromaHor, h264bsdInterpolateChromaVer and
+          h264bsdInterpolateChromaHorVer. Overfilling is done only if
+          needed.
+        Inputs:
+          ref               pointer to reference frame Cb top-left corner
+          x0, y0            integer position of the predicted part
+          width             width of the reference frame chrominance in pixels
+          height            height of the reference frame chrominance in pixels
+          xFrac, yFrac      fractional position in 1/8 pixels, not both zero
+          chromaPartWidth   width of the predicted part, 2, 4 or 8
+          chromaPartHeight  height of the predicted part in pixels
+          outWidth          line length of the output, parts narrower than
+                            8 pixels are written into macroblock chrominance
+                            (line length 8, Cr 8*8 bytes after Cb)
+        Outputs:
+          cb, cr            pointers where predicted parts are written
+
+------------------------------------------------------------------------------*/
+
+static void PredictChromaSimd(
+  u8 *ref,
+  u8 *cb,
+  u8 *cr,
+  u32 outWidth,
+  i32 x0,
+  i32 y0,
+  u32 width,
+  u32 height,
+  u32 xFrac,
+  u32 yFrac,
+  u32 chromaPartWidth,
+  u32 chromaPartHeight)
+{
+
+/* Variables */
+
+    u8 block[9*9*2];
+    u32 right, bottom, planeSize;
+    u8 *ptr;
+
+/* Code */
+
+    ASSERT(ref);
+    ASSERT(cb);
+    ASSERT(cr);
+    ASSERT(chromaPartWidth == 8 || (outWidth == 8 && cr == cb + 8*8));
+    ASSERT(xFrac || yFrac);
+    ASSERT(xFrac < 8);
+    ASSERT(yFrac < 8);
+
+    right = xFrac ? 1 : 0;
+    bottom = yFrac ? 1 : 0;
+
+    if ((x0 < 0) || ((u32)x0+chromaPartWidth+right > width) ||
+        (y0 < 0) || ((u32)y0+chromaPartHeight+bottom > height))
+    {
+        h264bsdFillBlock(ref, block, x0, y0, width, height,
+            chromaPartWidth + right, chromaPartHeight + bottom,
+            chromaPartWidth + right);
+        ref += width * height;
+        h264bsdFillBlock(ref, block + (chromaPartWidth+right)*
+            (chromaPartHeight+bottom), x0, y0, width, height,
+            chromaPartWidth + right, chromaPartHeight + bottom,
+            chromaPartWidth + right);
+
+        width = chromaPartWidth + right;
+        planeSize = width * (chromaPartHeight + bottom);
+        ptr = block;
+    }
+    else
+    {
+        planeSize = width * height;
+        ptr = ref + (u32)y0 * width + (u32)x0;
+    }
+
+    if (chromaPartWidth == 8)
+    {
+        ChromaStrip(ptr, cb, outWidth, width, planeSize, chromaPartHeight,
+            xFrac, yFrac, 8);
+        ChromaStrip(ptr + planeSize, cr, outWidth, width, planeSize,
+            chromaPartHeight, xFrac, yFrac, 8);
+    }
+    else if (chromaPartWidth == 4)
+        ChromaStrip(ptr, cb, 8, width, planeSize, chromaPartHeight,
+            xFrac, yFrac, 4);
+    else
+        ChromaStrip(ptr, cb, 8, width, planeSize, chromaPartHeight,
+            xFrac, yFrac, 2);
+
+}
+
+#endif /* H264DEC_SIMD */
+
 /*------------------------------------------------------------------------------
 
     Function: PredictChroma
@@ -449,6 +774,15 @@ static void PredictChroma(
     chromaPartHeight = partHeight >> 1;
     ref = refPic->data + 256 * refPic->width * refPic->height;
 
+#ifdef H264DEC_SIMD
+    if (xFrac | yFrac)
+        PredictChromaSimd(ref, mbPartChroma, mbPartChroma + 8*8, 8, xInt,
+                yInt, width, height, xFrac, yFrac, chromaPartWidth,
+                chromaPartHeight);
+    else
+        ChromaCopy(ref, mbPartChroma, mbPartChroma + 8*8, 8, xInt, yInt,
+                width, height, chromaPartWidth, chromaPartHeight);
+#else
     if (xFrac && yFrac)
     {
         h264bsdInterpolateChromaHorVer(ref, mbPartChroma, xInt, yInt, width,
@@ -466,12 +800,10 @@ static void PredictChroma(
     }
     else
     {
-        h264bsdFillBlock(ref, mbPartChroma, xInt, yInt, width, height,
-            chromaPartWidth, chromaPartHeight, 8);
-        ref += width * height;
-        h264bsdFillBlock(ref, mbPartChroma + 8*8, xInt, yInt, width, height,
-            chromaPartWidth, chromaPartHeight, 8);
+        ChromaCopy(ref, mbPartChroma, mbPartChroma + 8*8, 8, xInt, yInt,
+                width, height, chromaPartWidth, chromaPartHeight);
     }
+#endif /* H264DEC_SIMD */
 
 }
 
@@ -1791,6 +2123,421 @@ void h264bsdInterpolateMidHorQuarter(
 }
 
 
+#ifdef H264DEC_SIMD
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaLoad
+
+        Functional description:
+          Load 8 or 4 reference pixels into 16-bit lanes.
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 LumaLoad(const u8 *p, u32 n)
+{
+    if (n == 8)
+        return(h264bsdLoadWide8(p));
+    else
+        return(h264bsdLoadWide4(p));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaStore
+
+        Functional description:
+          Store 8 or 4 predicted pixels from 16-bit lanes.
+
+------------------------------------------------------------------------------*/
+
+static inline void LumaStore(u8 *p, v8i16 v, u32 n)
+{
+    if (n == 8)
+        h264bsdStoreNarrow8(p, v);
+    else
+        h264bsdStoreNarrow4(p, v);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaTap
+
+        Functional description:
+          6-tap filter (1, -5, 20, 20, -5, 1) without rounding. Results of
+          filtering 8-bit samples fit in 16 bits.
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 LumaTap(v8i16 t0, v8i16 t1, v8i16 t2, v8i16 t3,
+    v8i16 t4, v8i16 t5)
+{
+    return((t0 + t5) - (t1 + t4) * 5 + (t2 + t3) * 20);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaHorTap
+
+        Functional description:
+          Horizontal 6-tap filter for one row, p points to integer sample G.
+          For strips of 8 pixels all samples are taken from a single 16 byte
+          load. It reads 3 bytes past the samples needed, which is safe as
+          luma of a reference picture is followed by its chroma and the
+          local fill buffer has room for it.
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 LumaHorTap(const u8 *p, u32 n)
+{
+    v16u8 v;
+
+    if (n == 8)
+    {
+        v = h264bsdLoad16(p-2);
+        return(LumaTap(h264bsdUnpackLo(v),
+            h264bsdUnpackLo(VEC_SHIFT_BYTES(v, 1)),
+            h264bsdUnpackLo(VEC_SHIFT_BYTES(v, 2)),
+            h264bsdUnpackLo(VEC_SHIFT_BYTES(v, 3)),
+            h264bsdUnpackLo(VEC_SHIFT_BYTES(v, 4)),
+            h264bsdUnpackLo(VEC_SHIFT_BYTES(v, 5))));
+    }
+    else
+        return(LumaTap(LumaLoad(p-2, n), LumaLoad(p-1, n), LumaLoad(p, n),
+            LumaLoad(p+1, n), LumaLoad(p+2, n), LumaLoad(p+3, n)));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaRound
+
+        Functional description:
+          Round and clip result of one filtering pass, (x + 16) >> 5.
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 LumaRound(v8i16 v)
+{
+    return(h264bsdClip255((v + 16) >> 5));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaMidRound
+
+        Functional description:
+          Vertical 6-tap filter of horizontally filtered rows, rounded and
+          clipped, (x + 512) >> 10. The sum would need 20 bits, so it is
+          computed in 16-bit lanes in steps that each round down:
+
+            (V + 512) >> 10 = ((((a-b) >> 2) - b + c) >> 2) + c + 32) >> 6
+
+          with a = t0+t5, b = t1+t4 and c = t2+t3. The only step that could
+          overflow 16 bits is the sum of ((a-b) >> 2) and (c-b), which is
+          halved with the overflow-free average (x & y) + ((x ^ y) >> 1).
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 LumaMidRound(v8i16 t0, v8i16 t1, v8i16 t2, v8i16 t3,
+    v8i16 t4, v8i16 t5)
+{
+    v8i16 a, b, c, x, y;
+
+    a = t0 + t5;
+    b = t1 + t4;
+    c = t2 + t3;
+
+    x = (a - b) >> 2;
+    y = c - b;
+    x = ((x & y) + ((x ^ y) >> 1)) >> 1;
+
+    return(h264bsdClip255((x + c + 32) >> 6));
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaAverage
+
+        Functional description:
+          Rounded average of two predictions, used for quarter positions.
+
+------------------------------------------------------------------------------*/
+
+static inline v8i16 LumaAverage(v8i16 a, v8i16 b)
+{
+    return((a + b + 1) >> 1);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaHor
+
+        Functional description:
+          Positions 'a', 'b' and 'c' for a column strip of n pixels.
+
+------------------------------------------------------------------------------*/
+
+static inline void LumaHor(const u8 *ptr, u8 *out, u32 outWidth, u32 width,
+    u32 partHeight, u32 xFrac, u32 n)
+{
+    u32 y;
+    v8i16 b;
+
+    for (y = partHeight; y; y--)
+    {
+        b = LumaRound(LumaHorTap(ptr, n));
+        if (xFrac != 2)
+            b = LumaAverage(b, LumaLoad(ptr + (xFrac >> 1), n));
+        LumaStore(out, b, n);
+        ptr += width;
+        out += outWidth;
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaVer
+
+        Functional description:
+          Positions 'd', 'h' and 'n' for a column strip of n pixels.
+
+------------------------------------------------------------------------------*/
+
+static inline void LumaVer(const u8 *ptr, u8 *out, u32 outWidth, u32 width,
+    u32 partHeight, u32 yFrac, u32 n)
+{
+    u32 y;
+    v8i16 r0, r1, r2, r3, r4, r5, h;
+
+    r0 = LumaLoad(ptr - 2*width, n);
+    r1 = LumaLoad(ptr - width, n);
+    r2 = LumaLoad(ptr, n);
+    r3 = LumaLoad(ptr + width, n);
+    r4 = LumaLoad(ptr + 2*width, n);
+    ptr += 3*width;
+
+    for (y = partHeight; y; y--)
+    {
+        r5 = LumaLoad(ptr, n);
+        h = LumaRound(LumaTap(r0, r1, r2, r3, r4, r5));
+        if (yFrac == 1)
+            h = LumaAverage(h, r2);
+        else if (yFrac == 3)
+            h = LumaAverage(h, r3);
+        LumaStore(out, h, n);
+        r0 = r1; r1 = r2; r2 = r3; r3 = r4; r4 = r5;
+        ptr += width;
+        out += outWidth;
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaHorVer
+
+        Functional description:
+          Positions 'e', 'g', 'p' and 'r' for a column strip of n pixels,
+          average of horizontal half sample 'b' or 's' and vertical half
+          sample 'h' or 'm'.
+
+------------------------------------------------------------------------------*/
+
+static inline void LumaHorVer(const u8 *ptr, u8 *out, u32 outWidth,
+    u32 width, u32 partHeight, u32 xFrac, u32 yFrac, u32 n)
+{
+    u32 y;
+    const u8 *ptrB, *ptrH;
+    v8i16 r0, r1, r2, r3, r4, r5, b, h;
+
+    ptrB = ptr + (yFrac >> 1) * width;
+    ptrH = ptr + (xFrac >> 1);
+
+    r0 = LumaLoad(ptrH - 2*width, n);
+    r1 = LumaLoad(ptrH - width, n);
+    r2 = LumaLoad(ptrH, n);
+    r3 = LumaLoad(ptrH + width, n);
+    r4 = LumaLoad(ptrH + 2*width, n);
+    ptrH += 3*width;
+
+    for (y = partHeight; y; y--)
+    {
+        r5 = LumaLoad(ptrH, n);
+        h = LumaRound(LumaTap(r0, r1, r2, r3, r4, r5));
+        b = LumaRound(LumaHorTap(ptrB, n));
+        LumaStore(out, LumaAverage(b, h), n);
+        r0 = r1; r1 = r2; r2 = r3; r3 = r4; r4 = r5;
+        ptrB += width;
+        ptrH += width;
+        out += outWidth;
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaMid
+
+        Functional description:
+          Positions 'f', 'i', 'j', 'k' and 'q' for a column strip of n pixels.
+          Center sample 'j' is computed from horizontally filtered rows and
+          averaged with 'b', 's', 'h' or 'm' for the quarter positions.
+
+------------------------------------------------------------------------------*/
+
+static inline void LumaMid(const u8 *ptr, u8 *out, u32 outWidth, u32 width,
+    u32 partHeight, u32 xFrac, u32 yFrac, u32 n)
+{
+    u32 y;
+    const u8 *ptrH;
+    v8i16 t0, t1, t2, t3, t4, t5, j;
+    v8i16 r0, r1, r2, r3, r4, r5;
+
+    t0 = LumaHorTap(ptr - 2*width, n);
+    t1 = LumaHorTap(ptr - width, n);
+    t2 = LumaHorTap(ptr, n);
+    t3 = LumaHorTap(ptr + width, n);
+    t4 = LumaHorTap(ptr + 2*width, n);
+
+    /* integer column for 'i' and 'k' */
+    ptrH = ptr + (xFrac >> 1);
+    r0 = r1 = r2 = r3 = r4 = t0;
+    if (xFrac != 2)
+    {
+        r0 = LumaLoad(ptrH - 2*width, n);
+        r1 = LumaLoad(ptrH - width, n);
+        r2 = LumaLoad(ptrH, n);
+        r3 = LumaLoad(ptrH + width, n);
+        r4 = LumaLoad(ptrH + 2*width, n);
+    }
+    ptr += 3*width;
+    ptrH += 3*width;
+
+    for (y = partHeight; y; y--)
+    {
+        t5 = LumaHorTap(ptr, n);
+        j = LumaMidRound(t0, t1, t2, t3, t4, t5);
+        if (xFrac != 2)
+        {
+            r5 = LumaLoad(ptrH, n);
+            j = LumaAverage(j, LumaRound(LumaTap(r0, r1, r2, r3, r4, r5)));
+            r0 = r1; r1 = r2; r2 = r3; r3 = r4; r4 = r5;
+        }
+        else if (yFrac == 1)
+            j = LumaAverage(j, LumaRound(t2));
+        else if (yFrac == 3)
+            j = LumaAverage(j, LumaRound(t3));
+        LumaStore(out, j, n);
+        t0 = t1; t1 = t2; t2 = t3; t3 = t4; t4 = t5;
+        ptr += width;
+        ptrH += width;
+        out += outWidth;
+    }
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LumaStrip
+
+        Functional description:
+          Interpolate a column strip of n (8 or 4) pixels of a luma
+          partition. ptr points to the integer sample of the top-left
+          predicted pixel, surrounding samples needed by the filters are
+          available.
+
+------------------------------------------------------------------------------*/
+
+static inline void LumaStrip(const u8 *ptr, u8 *out, u32 outWidth,
+    u32 width, u32 partHeight, u32 xFrac, u32 yFrac, u32 n)
+{
+    if (!yFrac)
+        LumaHor(ptr, out, outWidth, width, partHeight, xFrac, n);
+    else if (!xFrac)
+        LumaVer(ptr, out, outWidth, width, partHeight, yFrac, n);
+    else if (xFrac == 2 || yFrac == 2)
+        LumaMid(ptr, out, outWidth, width, partHeight, xFrac, yFrac, n);
+    else
+        LumaHorVer(ptr, out, outWidth, width, partHeight, xFrac, yFrac, n);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: PredictLumaSimd
+
+        Functional description:
+          Vector implementation of luma interpolation for all fractional
+          sample positions, bit-exact with the h264bsdInterpolate* functions.
+          Partition is processed in column strips of 8 pixels (4 for
+          partitions of width 4). Overfilling is done only if needed.
+        Inputs:
+          ref           pointer to reference frame luma
+          x0, y0        integer position of the predicted partition
+          width         width of the reference frame luma in pixels
+          height        height of the reference frame luma in pixels
+          partWidth     width of the partition, 4, 8 or 16
+          partHeight    height of the partition, 4, 8 or 16
+          xFrac, yFrac  fractional position in quarter pixels, not both zero
+          outWidth      line length of the output
+        Outputs:
+          out           predicted partition
+
+------------------------------------------------------------------------------*/
+
+static void PredictLumaSimd(
+  u8 *ref,
+  u8 *out,
+  u32 outWidth,
+  i32 x0,
+  i32 y0,
+  u32 width,
+  u32 height,
+  u32 partWidth,
+  u32 partHeight,
+  u32 xFrac,
+  u32 yFrac)
+{
+
+/* Variables */
+
+    u32 p1[21*21/4+1];
+    u32 x;
+    i32 left, right, top, bottom;
+    u8 *ptr;
+
+/* Code */
+
+    ASSERT(ref);
+    ASSERT(out);
+    ASSERT(xFrac || yFrac);
+
+    /* samples needed by the 6-tap filters around the partition */
+    left = xFrac ? 2 : 0;
+    right = xFrac ? 3 : 0;
+    top = yFrac ? 2 : 0;
+    bottom = yFrac ? 3 : 0;
+
+    if ((x0 < left) || ((u32)(x0+right)+partWidth > width) ||
+        (y0 < top) || ((u32)(y0+bottom)+partHeight > height))
+    {
+        h264bsdFillBlock(ref, (u8*)p1, x0-left, y0-top, width, height,
+                partWidth+(u32)(left+right), partHeight+(u32)(top+bottom),
+                partWidth+(u32)(left+right));
+
+        width = partWidth+(u32)(left+right);
+        ptr = (u8*)p1 + (u32)top * width + (u32)left;
+    }
+    else
+        ptr = ref + (u32)y0 * width + (u32)x0;
+
+    if (partWidth == 4)
+        LumaStrip(ptr, out, outWidth, width, partHeight, xFrac, yFrac, 4);
+    else
+        for (x = 0; x < partWidth; x += 8)
+            LumaStrip(ptr + x, out + x, outWidth, width, partHeight, xFrac,
+                yFrac, 8);
+
+}
+
+#endif /* H264DEC_SIMD */
+
 /*------------------------------------------------------------------------------
 
     Function: h264bsdPredictSamples
@@ -1858,6 +2605,14 @@ void h264bsdPredictSamples(
     xInt = (i32)xA + (i32)partX + (mv->hor >> 2);
     yInt = (i32)yA + (i32)partY + (mv->ver >> 2);
 
+#ifdef H264DEC_SIMD
+    if (xFrac | yFrac)
+        PredictLumaSimd(refPic->data, lumaPartData, 16, xInt, yInt, width,
+                height, partWidth, partHeight, xFrac, yFrac);
+    else
+        h264bsdFillBlock(refPic->data, lumaPartData,
+                xInt,yInt,width,height,partWidth,partHeight,16);
+#else
     ASSERT(lumaFracPos[xFrac][yFrac] < 16);
 
     switch (lumaFracPos[xFrac][yFrac])
@@ -1927,6 +2682,7 @@ void h264bsdPredictSamples(
                     xInt-2, yInt-2, width, height, partWidth, partHeight, 3);
             break;
     }
+#endif /* H264DEC_SIMD */
 
     /* chroma */
     PredictChroma(
@@ -1940,6 +2696,193 @@ void h264bsdPredictSamples(
 
 }
 
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdCopyMacroblock
+
+        Functional description:
+          This function writes the prediction of a whole macroblock with an
+          integer motion vector for both luminance and chrominance (i.e. the
+          motion vector components are multiples of 8) straight from the
+          reference picture into the current image. Used for macroblocks
+          without residual, e.g. P_Skip, which would otherwise be predicted
+          into the macroblock array and then copied into the image.
+        Inputs:
+          image         pointer to current image, luma, cb and cr pointers
+                        of the macroblock set by h264bsdSetCurrImageMbPointers
+          mv            pointer to motion vector used for prediction
+          refPic        pointer to reference picture structure
+          xA            x-coordinate for current macroblock
+          yA            y-coordinate for current macroblock
+        Outputs:
+          image         macroblock is written into the image
+
+------------------------------------------------------------------------------*/
+
+void h264bsdCopyMacroblock(
+  image_t *image,
+  mv_t *mv,
+  image_t *refPic,
+  u32 xA,
+  u32 yA)
+{
+
+/* Variables */
+
+    u32 y, width, height;
+    i32 xInt, yInt;
+    u8 *ref, *lum, *cb, *cr;
+
+/* Code */
+
+    ASSERT(image);
+    ASSERT(mv);
+    ASSERT(!((mv->hor | mv->ver) & 0x7));
+    ASSERT(refPic);
+    ASSERT(refPic->data);
+    ASSERT(refPic->width == image->width);
+    ASSERT(refPic->height == image->height);
+
+    /* luma */
+    width = 16 * refPic->width;
+    height = 16 * refPic->height;
+
+    xInt = (i32)xA + (mv->hor >> 2);
+    yInt = (i32)yA + (mv->ver >> 2);
+
+    lum = image->luma;
+    if ((xInt < 0) || ((u32)xInt+16 > width) ||
+        (yInt < 0) || ((u32)yInt+16 > height))
+    {
+        h264bsdFillBlock(refPic->data, lum, xInt, yInt, width, height,
+            16, 16, width);
+    }
+    else
+    {
+        ref = refPic->data + (u32)yInt * width + (u32)xInt;
+        for (y = 16; y; y--)
+        {
+            memcpy(lum, ref, 16);
+            ref += width;
+            lum += width;
+        }
+    }
+
+    /* chroma */
+    ref = refPic->data + width * height;
+    width >>= 1;
+    height >>= 1;
+
+    xInt = (i32)(xA >> 1) + (mv->hor >> 3);
+    yInt = (i32)(yA >> 1) + (mv->ver >> 3);
+
+    cb = image->cb;
+    cr = image->cr;
+    if ((xInt < 0) || ((u32)xInt+8 > width) ||
+        (yInt < 0) || ((u32)yInt+8 > height))
+    {
+        h264bsdFillBlock(ref, cb, xInt, yInt, width, height, 8, 8, width);
+        h264bsdFillBlock(ref + width * height, cr, xInt, yInt, width, height,
+            8, 8, width);
+    }
+    else
+    {
+        ref += (u32)yInt * width + (u32)xInt;
+        for (y = 8; y; y--)
+        {
+            memcpy(cb, ref, 8);
+            memcpy(cr, ref + width * height, 8);
+            ref += width;
+            cb += width;
+            cr += width;
+        }
+    }
+
+}
+
+#ifdef H264DEC_SIMD
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdPredictMacroblock
+
+        Functional description:
+          This function writes the prediction of a whole macroblock with any
+          motion vector straight into the current image, without going
+          through the macroblock array. Residual, if any, is added in place
+          afterwards with h264bsdAddMbResidual.
+        Inputs:
+          image         pointer to current image, luma, cb and cr pointers
+                        of the macroblock set by h264bsdSetCurrImageMbPointers
+          mv            pointer to motion vector used for prediction
+          refPic        pointer to reference picture structure
+          xA            x-coordinate for current macroblock
+          yA            y-coordinate for current macroblock
+        Outputs:
+          image         prediction is written into the image
+
+------------------------------------------------------------------------------*/
+
+void h264bsdPredictMacroblock(
+  image_t *image,
+  mv_t *mv,
+  image_t *refPic,
+  u32 xA,
+  u32 yA)
+{
+
+/* Variables */
+
+    u32 xFrac, yFrac, width, height;
+    i32 xInt, yInt;
+    u8 *ref;
+
+/* Code */
+
+    ASSERT(image);
+    ASSERT(mv);
+    ASSERT(refPic);
+    ASSERT(refPic->data);
+    ASSERT(refPic->width == image->width);
+    ASSERT(refPic->height == image->height);
+
+    /* luma */
+    width = 16 * refPic->width;
+    height = 16 * refPic->height;
+
+    xInt = (i32)xA + (mv->hor >> 2);
+    yInt = (i32)yA + (mv->ver >> 2);
+    xFrac = mv->hor & 0x3;
+    yFrac = mv->ver & 0x3;
+
+    if (xFrac | yFrac)
+        PredictLumaSimd(refPic->data, image->luma, width, xInt, yInt, width,
+                height, 16, 16, xFrac, yFrac);
+    else
+        h264bsdFillBlock(refPic->data, image->luma, xInt, yInt, width, height,
+                16, 16, width);
+
+    /* chroma */
+    ref = refPic->data + width * height;
+    width >>= 1;
+    height >>= 1;
+
+    xInt = (i32)(xA >> 1) + (mv->hor >> 3);
+    yInt = (i32)(yA >> 1) + (mv->ver >> 3);
+    xFrac = mv->hor & 0x7;
+    yFrac = mv->ver & 0x7;
+
+    if (xFrac | yFrac)
+        PredictChromaSimd(ref, image->cb, image->cr, width, xInt, yInt, width,
+                height, xFrac, yFrac, 8, 8);
+    else
+        ChromaCopy(ref, image->cb, image->cr, width, xInt, yInt, width, height,
+                8, 8);
+
+}
+
+#endif /* H264DEC_SIMD */
+
 #else /* H264DEC_OMXDL */
 /*------------------------------------------------------------------------------
 
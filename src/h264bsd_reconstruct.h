@@ -58,6 +58,22 @@ void h264bsdPredictSamples(
   u32 partY,
   u32 partWidth,
   u32 partHeight);
+
+void h264bsdCopyMacroblock(
+  image_t *image,
+  mv_t *mv,
+  image_t *refPic,
+  u32 xA,
+  u32 yA);
+
+#ifdef H264DEC_SIMD
+void h264bsdPredictMacroblock(
+  image_t *image,
+  mv_t *mv,
+  image_t *refPic,
+  u32 xA,
+  u32 yA);
+#endif
 #else
 void h264bsdPredictSamples(
   u8 *data,
@@ -0,0 +1,198 @@
+/*------------------------------------------------------------------------------
+
+    Table of contents
+
+    1. Include headers
+    2. Module defines
+    3. Data types
+    4. Function prototypes
+
+------------------------------------------------------------------------------*/
+
+#ifndef H264SWDEC_SIMD_H
+#define H264SWDEC_SIMD_H
+
+/*------------------------------------------------------------------------------
+    1. Include headers
+------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "basetype.h"
+
+/*------------------------------------------------------------------------------
+    2. Module defines
+--------------------------------------------------------------------------------
+
+H264DEC_SIMD        Defined when 128-bit vector code paths are compiled in.
+                    The kernels are written with the GCC/Clang generic vector
+                    extensions, which lower to wasm-simd128 when building
+                    with -msimd128 and to SSE2/NEON in native builds, so a
+                    single implementation serves all targets.
+H264DEC_NO_SIMD     Define to force the portable scalar code paths.
+
+------------------------------------------------------------------------------*/
+
+#if !defined(H264DEC_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__wasm_simd128__) || defined(__SSE2__) || defined(__ARM_NEON))
+#define H264DEC_SIMD
+#endif
+
+#ifdef H264DEC_SIMD
+
+/* shift bytes of a v16u8 towards lane 0 by a constant n, filling with zeros */
+#define VEC_SHIFT_BYTES(v, n) __builtin_shufflevector((v), (v16u8){0}, \
+    (n)+0, (n)+1, (n)+2, (n)+3, (n)+4, (n)+5, (n)+6, (n)+7, \
+    (n)+8, (n)+9, (n)+10, (n)+11, (n)+12, (n)+13, (n)+14, (n)+15)
+
+/*------------------------------------------------------------------------------
+    3. Data types
+------------------------------------------------------------------------------*/
+
+typedef u8  v16u8 __attribute__((vector_size(16)));
+typedef i8  v16i8 __attribute__((vector_size(16)));
+typedef u16 v8u16 __attribute__((vector_size(16)));
+typedef i16 v8i16 __attribute__((vector_size(16)));
+typedef u32 v4u32 __attribute__((vector_size(16)));
+typedef i32 v4i32 __attribute__((vector_size(16)));
+typedef u64 v2u64 __attribute__((vector_size(16)));
+
+/* half-width vector, used when narrowing lanes */
+typedef u8  v8u8  __attribute__((vector_size(8)));
+
+/*------------------------------------------------------------------------------
+    4. Function prototypes
+------------------------------------------------------------------------------*/
+
+/* unaligned 16 byte load and store */
+static inline v16u8 h264bsdLoad16(const u8 *p)
+{
+    v16u8 v;
+    memcpy(&v, p, 16);
+    return v;
+}
+
+static inline void h264bsdStore16(u8 *p, v16u8 v)
+{
+    memcpy(p, &v, 16);
+}
+
+/* zero-extend the low 8 bytes to 16-bit lanes */
+static inline v8i16 h264bsdUnpackLo(v16u8 v)
+{
+    const v16u8 zero = {0};
+    return (v8i16)__builtin_shufflevector(v, zero,
+        0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+}
+
+/* zero-extend the high 8 bytes to 16-bit lanes */
+static inline v8i16 h264bsdUnpackHi(v16u8 v)
+{
+    const v16u8 zero = {0};
+    return (v8i16)__builtin_shufflevector(v, zero,
+        8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+}
+
+/* load 8 (or 4) pixels and widen them to 16-bit lanes, unused lanes are
+ * zero */
+static inline v8i16 h264bsdLoadWide8(const u8 *p)
+{
+    u64 x;
+    v2u64 v;
+
+    memcpy(&x, p, 8);
+    v = (v2u64){x, 0};
+    return h264bsdUnpackLo((v16u8)v);
+}
+
+static inline v8i16 h264bsdLoadWide4(const u8 *p)
+{
+    u32 x;
+    v4u32 v;
+
+    memcpy(&x, p, 4);
+    v = (v4u32){x, 0, 0, 0};
+    return h264bsdUnpackLo((v16u8)v);
+}
+
+/* narrow 16-bit lanes holding values 0..255 and store 8 (or 4) pixels */
+static inline void h264bsdStoreNarrow8(u8 *p, v8i16 v)
+{
+    v8u8 t = __builtin_convertvector(v, v8u8);
+    memcpy(p, &t, 8);
+}
+
+static inline void h264bsdStoreNarrow4(u8 *p, v8i16 v)
+{
+    v8u8 t = __builtin_convertvector(v, v8u8);
+    memcpy(p, &t, 4);
+}
+
+/* narrow two vectors of 16-bit lanes holding values 0..255 to bytes, keeps
+ * the low byte of each lane (lane order is little-endian) */
+static inline v16u8 h264bsdPack16(v8i16 lo, v8i16 hi)
+{
+    return __builtin_shufflevector((v16u8)lo, (v16u8)hi,
+        0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+}
+
+/* clip 16-bit lanes to range 0..255 */
+static inline v8i16 h264bsdClip255(v8i16 v)
+{
+    const v8i16 max = {255, 255, 255, 255, 255, 255, 255, 255};
+    v8i16 over;
+
+    v &= ~(v >> 15);
+    over = v > max;
+    return (v & ~over) | (max & over);
+}
+
+/* add two rows of 4 residual values in range [-512,511] to prediction and
+ * store the saturated result, pred and out may point to the same rows */
+static inline void h264bsdAddResidual4x2(const u8 *pred, u32 predWidth,
+    u8 *out, u32 outWidth, const i32 *residual)
+{
+    v8i16 p, r;
+    v4i32 r0, r1;
+    v8u8 t;
+
+    p = __builtin_shufflevector(h264bsdLoadWide4(pred),
+        h264bsdLoadWide4(pred + predWidth), 0, 1, 2, 3, 8, 9, 10, 11);
+
+    /* residual fits in 16 bits, keep the low half of each 32-bit lane */
+    memcpy(&r0, residual, 16);
+    memcpy(&r1, residual + 4, 16);
+    r = __builtin_shufflevector((v8i16)r0, (v8i16)r1,
+        0, 2, 4, 6, 8, 10, 12, 14);
+
+    t = __builtin_convertvector(h264bsdClip255(p + r), v8u8);
+    memcpy(out, &t, 4);
+    memcpy(out + outWidth, (u8*)&t + 4, 4);
+}
+
+/* same for a 4x4 block */
+static inline void h264bsdAddResidual4x4(const u8 *pred, u32 predWidth,
+    u8 *out, u32 outWidth, const i32 *residual)
+{
+    h264bsdAddResidual4x2(pred, predWidth, out, outWidth, residual);
+    h264bsdAddResidual4x2(pred + 2*predWidth, predWidth, out + 2*outWidth,
+        outWidth, residual + 8);
+}
+
+/* index of the first non-zero byte of a comparison mask, 16 if none. Lane
+ * order is little-endian on all supported targets. */
+static inline u32 h264bsdFirstSetByte(v16u8 mask)
+{
+    v2u64 m = (v2u64)mask;
+
+    if (m[0])
+        return (u32)__builtin_ctzll(m[0]) >> 3;
+    else if (m[1])
+        return 8 + ((u32)__builtin_ctzll(m[1]) >> 3);
+    else
+        return 16;
+}
+
+#endif /* H264DEC_SIMD */
+
+#endif /* #ifdef H264SWDEC_SIMD_H */
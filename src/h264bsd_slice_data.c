@@ -24,6 +24,7 @@
      4. Local function prototypes
      5. Functions
           h264bsdDecodeSliceData
+          DecodeMacroblocks
           SetMbParams
           h264bsdMarkSliceCorrupted
 
@@ -36,6 +37,8 @@
 #include "h264bsd_slice_data.h"
 #include "h264bsd_util.h"
 #include "h264bsd_vlc.h"
+#include "h264bsd_deblocking.h"
+#include "h264bsd_threads.h"
 
 /*------------------------------------------------------------------------------
     2. External compiler flags
@@ -49,6 +52,8 @@
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
 
+static u32 DecodeMacroblocks(strmData_t *pStrmData, storage_t *pStorage,
+    image_t *currImage, sliceHeader_t *pSliceHeader, u32 *mbCount);
 static void SetMbParams(mbStorage_t *pMb, sliceHeader_t *pSlice, u32 sliceId,
     i32 chromaQpIndexOffset);
 
@@ -64,6 +69,21 @@ static void SetMbParams(mbStorage_t *pMb, sliceHeader_t *pSlice, u32 sliceId,
             macroblock to process is determined (h264bsdNextMbAddress function)
             map
 
+            With H264DEC_ROW_DEBLOCK, as long as the slices of a picture are
+            decoded in raster scan order (single slice group, each slice
+            starting where the previous one ended, no redundant slices) a
+            macroblock row is deblocked as soon as the row below it has been
+            reconstructed, while its pixels are still in cache. Otherwise the
+            remaining rows are deblocked when the whole picture has been
+            decoded. Output of corrupted streams differs from the picture
+            pass: macroblocks concealed later are concealed from deblocked
+            neighbours and rows already deblocked are not filtered again.
+
+            With H264DEC_THREADS a slice marked for wavefront decoding
+            (slice->wavefront) is only parsed by the calling thread, the
+            macroblocks are reconstructed and deblocked by the worker threads,
+            see h264bsd_threads.c.
+
         Inputs:
             pStrmData       pointer to stream data structure
             pStorage        pointer to storage structure
@@ -86,6 +106,96 @@ u32 h264bsdDecodeSliceData(strmData_t *pStrmData, storage_t *pStorage,
     image_t *currImage, sliceHeader_t *pSliceHeader)
 {
 
+/* Variables */
+
+    u32 tmp;
+    u32 mbCount;
+
+/* Code */
+
+    ASSERT(pStrmData);
+    ASSERT(pSliceHeader);
+    ASSERT(pStorage);
+    ASSERT(pSliceHeader->firstMbInSlice < pStorage->picSizeInMbs);
+
+    /* increment slice index, will be one for decoding of the first slice of
+     * the picture */
+    pStorage->slice->sliceId++;
+
+    /* lastMbAddr stores address of the macroblock that was last successfully
+     * decoded, needed for error handling */
+    pStorage->slice->lastMbAddr = 0;
+
+    /* rows can be deblocked during decoding only if all macroblocks
+     * preceding the slice in raster scan order have been decoded */
+    if (pStorage->activePps->numSliceGroups != 1 ||
+        pSliceHeader->redundantPicCnt ||
+        pSliceHeader->firstMbInSlice != pStorage->slice->numDecodedMbs)
+        pStorage->slice->outOfOrder = HANTRO_TRUE;
+
+    mbCount = 0;
+#ifdef H264DEC_THREADS
+    if (pStorage->slice->wavefront &&
+        h264bsdStartWavefront(pStorage) != HANTRO_OK)
+        pStorage->slice->wavefront = HANTRO_FALSE;
+
+    if (pStorage->slice->wavefront)
+    {
+        tmp = DecodeMacroblocks(pStrmData, pStorage, currImage, pSliceHeader,
+            &mbCount);
+        tmp = h264bsdFinishWavefront(pStorage, tmp);
+    }
+    else
+#endif
+        tmp = DecodeMacroblocks(pStrmData, pStorage, currImage, pSliceHeader,
+            &mbCount);
+    if (tmp != HANTRO_OK)
+        return(tmp);
+
+    if ((pStorage->slice->numDecodedMbs + mbCount) > pStorage->picSizeInMbs)
+    {
+        EPRINT("Num decoded mbs");
+        return(HANTRO_NOK);
+    }
+
+    pStorage->slice->numDecodedMbs += mbCount;
+
+    return(HANTRO_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+   5.2  Function name: DecodeMacroblocks
+
+        Functional description:
+            Decode the macroblocks of a slice, see h264bsdDecodeSliceData.
+            In wavefront mode the macroblocks are parsed into the records
+            given by h264bsdWavefrontRecord and handed to the worker threads
+            for reconstruction.
+
+        Inputs:
+            pStrmData       pointer to stream data structure
+            pStorage        pointer to storage structure
+            currImage       pointer to current processed picture
+            pSliceHeader    pointer to slice header of the current slice
+
+        Outputs:
+            currImage       processed macroblocks are written to current image
+            pStorage        mbStorage structure of each processed macroblock
+                            is updated here
+            mbCount         number of macroblocks decoded for the first time
+
+        Returns:
+            HANTRO_OK       success
+            HANTRO_NOK      invalid stream data
+
+------------------------------------------------------------------------------*/
+
+u32 DecodeMacroblocks(strmData_t *pStrmData, storage_t *pStorage,
+    image_t *currImage, sliceHeader_t *pSliceHeader, u32 *mbCount)
+{
+
 /* Variables */
 
     u8 mbData[384 + 15 + 32];
@@ -95,35 +205,36 @@ u32 h264bsdDecodeSliceData(strmData_t *pStrmData, storage_t *pStorage,
     u32 prevSkipped;
     u32 currMbAddr;
     u32 moreMbs;
-    u32 mbCount;
+#ifdef H264DEC_ROW_DEBLOCK
+    u32 picWidthInMbs;
+#endif
     i32 qpY;
     macroblockLayer_t *mbLayer;
+#ifdef H264DEC_THREADS
+    u32 wavefront;
+#endif
+#ifdef H264DEC_STATS
+    u64 statsTime;
+#endif
 
 /* Code */
 
-    ASSERT(pStrmData);
-    ASSERT(pSliceHeader);
-    ASSERT(pStorage);
-    ASSERT(pSliceHeader->firstMbInSlice < pStorage->picSizeInMbs);
-
     /* ensure 16-byte alignment */
     data = (u8*)ALIGN(mbData, 16);
 
     mbLayer = pStorage->mbLayer;
+#ifdef H264DEC_THREADS
+    wavefront = pStorage->slice->wavefront;
+#endif
 
     currMbAddr = pSliceHeader->firstMbInSlice;
     skipRun = 0;
     prevSkipped = HANTRO_FALSE;
 
-    /* increment slice index, will be one for decoding of the first slice of
-     * the picture */
-    pStorage->slice->sliceId++;
-
-    /* lastMbAddr stores address of the macroblock that was last successfully
-     * decoded, needed for error handling */
-    pStorage->slice->lastMbAddr = 0;
+#ifdef H264DEC_ROW_DEBLOCK
+    picWidthInMbs = currImage->width;
+#endif
 
-    mbCount = 0;
     /* initial quantization parameter for the slice is obtained as the sum of
      * initial QP for the picture and sliceQpDelta for the current slice */
     qpY = (i32)pStorage->activePps->picInitQp + pSliceHeader->sliceQpDelta;
@@ -139,6 +250,17 @@ u32 h264bsdDecodeSliceData(strmData_t *pStrmData, storage_t *pStorage,
         SetMbParams(pStorage->mb + currMbAddr, pSliceHeader,
             pStorage->slice->sliceId, pStorage->activePps->chromaQpIndexOffset);
 
+#ifdef H264DEC_THREADS
+        /* each macroblock is parsed into a record of its own, waits until
+         * the record is free */
+        if (wavefront)
+        {
+            mbLayer = h264bsdWavefrontRecord(pStorage, currMbAddr);
+            if (mbLayer == NULL)
+                return(HANTRO_NOK);
+        }
+#endif
+
         if (!IS_I_SLICE(pSliceHeader->sliceType))
         {
             if (!prevSkipped)
@@ -167,13 +289,22 @@ u32 h264bsdDecodeSliceData(strmData_t *pStrmData, storage_t *pStorage,
         {
             DEBUG(("Skipping macroblock %d\n", currMbAddr));
             skipRun--;
+#ifdef H264DEC_THREADS
+            if (wavefront)
+            {
+                H264SwDecMemset(&mbLayer->mbPred, 0, sizeof(mbPred_t));
+                mbLayer->mbType = P_Skip;
+            }
+#endif
         }
         else
         {
             prevSkipped = HANTRO_FALSE;
+            STATS_START(statsTime);
             tmp = h264bsdDecodeMacroblockLayer(pStrmData, mbLayer,
                 pStorage->mb + currMbAddr, pSliceHeader->sliceType,
                 pSliceHeader->numRefIdxL0Active);
+            STATS_STOP(pStorage, mbLayerTime, statsTime);
             if (tmp != HANTRO_OK)
             {
                 EPRINT("macroblock_layer");
@@ -181,19 +312,64 @@ u32 h264bsdDecodeSliceData(strmData_t *pStrmData, storage_t *pStorage,
             }
         }
 
-        tmp = h264bsdDecodeMacroblock(pStorage->mb + currMbAddr, mbLayer,
-            currImage, pStorage->dpb, &qpY, currMbAddr,
-            pStorage->activePps->constrainedIntraPredFlag, data);
-        if (tmp != HANTRO_OK)
+        h264bsdStoreMacroblockParams(pStorage->mb + currMbAddr, mbLayer, &qpY);
+#ifdef H264DEC_STATS
+        if (IS_INTRA_MB(*mbLayer))
         {
-            EPRINT("MACRO_BLOCK");
-            return(tmp);
+            if (IS_I_PCM_MB(*mbLayer))
+                STATS_ADD(pStorage, numPcmMbs, 1);
+            else
+                STATS_ADD(pStorage, numIntraMbs, 1);
+        }
+        else
+        {
+            if (mbLayer->mbType == P_Skip)
+                STATS_ADD(pStorage, numSkippedMbs, 1);
+            else
+                STATS_ADD(pStorage, numInterMbs, 1);
+        }
+#endif
+
+#ifdef H264DEC_THREADS
+        if (wavefront)
+            h264bsdWavefrontParsed(pStorage, currMbAddr);
+        else
+#endif
+        {
+            STATS_START(statsTime);
+            tmp = h264bsdDecodeMacroblock(pStorage->mb + currMbAddr, mbLayer,
+                currImage, pStorage->dpb, currMbAddr,
+                pStorage->activePps->constrainedIntraPredFlag, data);
+#ifdef H264DEC_STATS
+            if (IS_INTRA_MB(*mbLayer))
+                STATS_STOP(pStorage, intraMbTime, statsTime);
+            else
+                STATS_STOP(pStorage, interMbTime, statsTime);
+#endif
+            if (tmp != HANTRO_OK)
+            {
+                EPRINT("MACRO_BLOCK");
+                return(tmp);
+            }
+
+#ifdef H264DEC_ROW_DEBLOCK
+            /* last macroblock of a row decoded -> deblock the row above it */
+            if (!pStorage->slice->outOfOrder && currMbAddr + 1 ==
+                (pStorage->slice->numFilteredRows + 2) * picWidthInMbs)
+            {
+                STATS_START(statsTime);
+                h264bsdFilterMbRows(currImage, pStorage->mb,
+                    pStorage->slice->numFilteredRows, 1);
+                STATS_STOP(pStorage, deblockTime, statsTime);
+                pStorage->slice->numFilteredRows++;
+            }
+#endif
         }
 
         /* increment macroblock count only for macroblocks that were decoded
          * for the first time (redundant slices) */
         if (pStorage->mb[currMbAddr].decoded == 1)
-            mbCount++;
+            (*mbCount)++;
 
         /* keep on processing as long as there is stream data left or
          * processing of macroblocks to be skipped based on the last skipRun is
@@ -215,24 +391,27 @@ u32 h264bsdDecodeSliceData(strmData_t *pStrmData, storage_t *pStorage,
             EPRINT("Next mb address");
             return(HANTRO_NOK);
         }
+#ifdef H264DEC_THREADS
+        /* next macroblock belongs to the next slice being decoded in
+         * parallel -> stop, h264bsdSyncSlices decodes the slices again one
+         * after another */
+        if (moreMbs && currMbAddr == pStorage->slice->endMbAddr)
+        {
+            EPRINT("Next mb address");
+            pStorage->slice->overrun = HANTRO_TRUE;
+            return(HANTRO_NOK);
+        }
+#endif
 
     } while (moreMbs);
 
-    if ((pStorage->slice->numDecodedMbs + mbCount) > pStorage->picSizeInMbs)
-    {
-        EPRINT("Num decoded mbs");
-        return(HANTRO_NOK);
-    }
-
-    pStorage->slice->numDecodedMbs += mbCount;
-
     return(HANTRO_OK);
 
 }
 
 /*------------------------------------------------------------------------------
 
-   5.2  Function: SetMbParams
+   5.3  Function: SetMbParams
 
         Functional description:
             Set macroblock parameters that remain constant for this slice
@@ -263,7 +442,7 @@ void SetMbParams(mbStorage_t *pMb, sliceHeader_t *pSlice, u32 sliceId,
     tmp1 = pSlice->disableDeblockingFilterIdc;
     tmp2 = pSlice->sliceAlphaC0Offset;
     tmp3 = pSlice->sliceBetaOffset;
-    pMb->sliceId = sliceId;
+    SET_SLICE_ID(pMb, sliceId);
     pMb->disableDeblockingFilterIdc = tmp1;
     pMb->filterOffsetA = tmp2;
     pMb->filterOffsetB = tmp3;
@@ -273,7 +452,7 @@ void SetMbParams(mbStorage_t *pMb, sliceHeader_t *pSlice, u32 sliceId,
 
 /*------------------------------------------------------------------------------
 
-   5.3  Function name: h264bsdMarkSliceCorrupted
+   5.4  Function name: h264bsdMarkSliceCorrupted
 
         Functional description:
             Mark macroblocks of the slice corrupted. If lastMbAddr in the slice
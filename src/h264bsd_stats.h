@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------
+
+    Table of contents
+
+    1. Include headers
+    2. Module defines
+    3. Data types
+    4. Function prototypes
+
+------------------------------------------------------------------------------*/
+
+#ifndef H264SWDEC_STATS_H
+#define H264SWDEC_STATS_H
+
+/*------------------------------------------------------------------------------
+    1. Include headers
+------------------------------------------------------------------------------*/
+
+#include "basetype.h"
+
+#ifdef H264DEC_STATS
+#include <time.h>
+#endif
+
+/*------------------------------------------------------------------------------
+    2. Module defines
+--------------------------------------------------------------------------------
+
+H264DEC_STATS       Collect per-stage decoding times and macroblock counters
+                    into storage_t, read with H264SwDecGetStats. Timing uses
+                    two clock reads per measured call, so this is meant for
+                    profiling builds only.
+
+------------------------------------------------------------------------------*/
+
+#ifdef H264DEC_STATS
+
+/* store start time of a measured stage into local u64 variable */
+#define STATS_START(time) (time) = h264bsdStatsTime()
+/* add time elapsed since STATS_START to a time field of the statistics */
+#define STATS_STOP(pStorage, field, time) \
+    (pStorage)->stats.field += h264bsdStatsTime() - (time)
+/* add to a counter field of the statistics */
+#define STATS_ADD(pStorage, field, value) (pStorage)->stats.field += (value)
+
+#else
+
+#define STATS_START(time)
+#define STATS_STOP(pStorage, field, time)
+#define STATS_ADD(pStorage, field, value)
+
+#endif
+
+/*------------------------------------------------------------------------------
+    3. Data types
+------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+    4. Function prototypes
+------------------------------------------------------------------------------*/
+
+#ifdef H264DEC_STATS
+/* monotonic time in nanoseconds */
+static inline u64 h264bsdStatsTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+#endif
+
+#endif /* #ifdef H264SWDEC_STATS_H */
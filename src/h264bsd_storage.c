@@ -468,6 +468,8 @@ void h264bsdResetStorage(storage_t *pStorage)
 
     pStorage->slice->numDecodedMbs = 0;
     pStorage->slice->sliceId = 0;
+    pStorage->slice->numFilteredRows = 0;
+    pStorage->slice->outOfOrder = HANTRO_FALSE;
 
     for (i = 0; i < pStorage->picSizeInMbs; i++)
     {
@@ -42,6 +42,8 @@
 #include "h264bsd_seq_param_set.h"
 #include "h264bsd_dpb.h"
 #include "h264bsd_pic_order_cnt.h"
+#include "h264bsd_stats.h"
+#include "H264SwDecApi.h"
 
 /*------------------------------------------------------------------------------
     2. Module defines
@@ -56,6 +58,22 @@ typedef struct
     u32 sliceId;
     u32 numDecodedMbs;
     u32 lastMbAddr;
+    /* number of macroblock rows deblocked during slice decoding */
+    u32 numFilteredRows;
+    /* set if a slice of the picture was not decoded in raster scan order,
+     * remaining rows are then deblocked after the whole picture is decoded */
+    u32 outOfOrder;
+#ifdef H264DEC_THREADS
+    /* address of the first macroblock of the next slice for slices decoded
+     * in parallel, 0 if not known */
+    u32 endMbAddr;
+    /* set if decoding stopped at endMbAddr with slice data left, i.e. the
+     * slice would have continued over the next one */
+    u32 overrun;
+    /* set if the slice is parsed by the decoding thread and reconstructed
+     * by the worker threads in wavefront order */
+    u32 wavefront;
+#endif
 } sliceStorage_t;
 
 /* structure to store parameters needed for access unit boundary checking */
@@ -146,6 +164,14 @@ typedef struct
                               HEADERS_RDY to the user */
     u32 intraConcealmentFlag; /* 0 gray picture for corrupted intra
                                  1 previous frame used if available */
+#ifdef H264DEC_STATS
+    /* decoding statistics, see h264bsd_stats.h */
+    H264SwDecStats stats;
+#endif
+#ifdef H264DEC_THREADS
+    /* worker threads decoding slices in parallel, see h264bsd_threads.h */
+    struct sliceThreads *threads;
+#endif
 } storage_t;
 
 /*------------------------------------------------------------------------------
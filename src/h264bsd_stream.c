@@ -23,9 +23,7 @@
      3. Module defines
      4. Local function prototypes
      5. Functions
-          h264bsdGetBits
-          h264bsdShowBits32
-          h264bsdFlushBits
+          h264bsdShowTailBits
           h264bsdIsByteAligned
 
 ------------------------------------------------------------------------------*/
@@ -51,162 +49,58 @@
 
 /*------------------------------------------------------------------------------
 
-    Function: h264bsdGetBits
+    Function: h264bsdShowTailBits
 
         Functional description:
-            Read and remove bits from the stream buffer.
+            Slow path of h264bsdShowBits64 for the last bytes of the stream
+            buffer. Read the remaining bits from the stream buffer without
+            removing them. First bit read from the stream is the MSB of the
+            return value, bits beyond the end of the stream are set to '0'.
 
         Input:
             pStrmData   pointer to stream data structure
-            numBits     number of bits to read
 
         Output:
             none
 
         Returns:
             bits read from stream
-            END_OF_STREAM if not enough bits left
 
 ------------------------------------------------------------------------------*/
 
-u32 h264bsdGetBits(strmData_t *pStrmData, u32 numBits)
-{
-
-    u32 out;
-
-    ASSERT(pStrmData);
-    ASSERT(numBits < 32);
-
-    out = h264bsdShowBits32(pStrmData) >> (32 - numBits);
-
-    if (h264bsdFlushBits(pStrmData, numBits) == HANTRO_OK)
-    {
-        return(out);
-    }
-    else
-    {
-        return(END_OF_STREAM);
-    }
-
-}
-
-/*------------------------------------------------------------------------------
-
-    Function: h264bsdShowBits32
-
-        Functional description:
-            Read 32 bits from the stream buffer. Buffer is left as it is, i.e.
-            no bits are removed. First bit read from the stream is the MSB of
-            the return value. If there is not enough bits in the buffer ->
-            bits beyong the end of the stream are set to '0' in the return
-            value.
-
-        Input:
-            pStrmData   pointer to stream data structure
-
-        Output:
-            none
-
-        Returns:
-            bits read from stream
-
-------------------------------------------------------------------------------*/
-
-u32 h264bsdShowBits32(strmData_t *pStrmData)
+u64 h264bsdShowTailBits(strmData_t *pStrmData)
 {
 
     i32 bits, shift;
-    u32 out;
+    u64 out;
     u8 *pStrm;
 
     ASSERT(pStrmData);
-    ASSERT(pStrmData->pStrmCurrPos);
     ASSERT(pStrmData->bitPosInWord < 8);
     ASSERT(pStrmData->bitPosInWord ==
            (pStrmData->strmBuffReadBits & 0x7));
 
-    pStrm = pStrmData->pStrmCurrPos;
-
     /* number of bits left in the buffer */
     bits = (i32)pStrmData->strmBuffSize*8 - (i32)pStrmData->strmBuffReadBits;
 
-    /* at least 32-bits in the buffer */
-    if (bits >= 32)
-    {
-        u32 bitPosInWord = pStrmData->bitPosInWord;
-        out = ((u32)pStrm[0] << 24) | ((u32)pStrm[1] << 16) |
-              ((u32)pStrm[2] <<  8) | ((u32)pStrm[3]);
-
-        if (bitPosInWord)
-        {
-            u32 byte = (u32)pStrm[4];
-            u32 tmp = (8-bitPosInWord);
-            out <<= bitPosInWord;
-            out |= byte>>tmp;
-        }
-        return (out);
-    }
-    /* at least one bit in the buffer */
-    else if (bits > 0)
-    {
-        shift = (i32)(24 + pStrmData->bitPosInWord);
-        out = (u32)(*pStrm++) << shift;
-        bits -= (i32)(8 - pStrmData->bitPosInWord);
-        while (bits > 0)
-        {
-            shift -= 8;
-            out |= (u32)(*pStrm++) << shift;
-            bits -= 8;
-        }
-        return (out);
-    }
-    else
+    if (bits <= 0)
         return (0);
 
-}
-
-/*------------------------------------------------------------------------------
-
-    Function: h264bsdFlushBits
-
-        Functional description:
-            Remove bits from the stream buffer
-
-        Input:
-            pStrmData       pointer to stream data structure
-            numBits         number of bits to remove
-
-        Output:
-            none
-
-        Returns:
-            HANTRO_OK       success
-            END_OF_STREAM   not enough bits left
-
-------------------------------------------------------------------------------*/
-#ifndef H264DEC_NEON
-u32 h264bsdFlushBits(strmData_t *pStrmData, u32 numBits)
-{
+    pStrm = pStrmData->pStrmBuffStart + (pStrmData->strmBuffReadBits >> 3);
 
-    ASSERT(pStrmData);
-    ASSERT(pStrmData->pStrmBuffStart);
-    ASSERT(pStrmData->pStrmCurrPos);
-    ASSERT(pStrmData->bitPosInWord < 8);
-    ASSERT(pStrmData->bitPosInWord == (pStrmData->strmBuffReadBits & 0x7));
-
-    pStrmData->strmBuffReadBits += numBits;
-    pStrmData->bitPosInWord = pStrmData->strmBuffReadBits & 0x7;
-    if ( (pStrmData->strmBuffReadBits ) <= (8*pStrmData->strmBuffSize) )
+    shift = (i32)(56 + pStrmData->bitPosInWord);
+    out = (u64)(*pStrm++) << shift;
+    bits -= (i32)(8 - pStrmData->bitPosInWord);
+    while (bits > 0)
     {
-        pStrmData->pStrmCurrPos = pStrmData->pStrmBuffStart +
-            (pStrmData->strmBuffReadBits >> 3);
-        return(HANTRO_OK);
+        shift -= 8;
+        out |= (u64)(*pStrm++) << shift;
+        bits -= 8;
     }
-    else
-        return(END_OF_STREAM);
+    return (out);
 
 }
-#endif
+
 /*------------------------------------------------------------------------------
 
     Function: h264bsdIsByteAligned
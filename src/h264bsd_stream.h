@@ -32,12 +32,21 @@
     1. Include headers
 ------------------------------------------------------------------------------*/
 
+#include <string.h>
+
 #include "basetype.h"
 
 /*------------------------------------------------------------------------------
     2. Module defines
 ------------------------------------------------------------------------------*/
 
+#ifndef HANTRO_OK
+#define HANTRO_OK   0
+#endif
+
+/* value to be returned by GetBits if stream buffer is empty */
+#define END_OF_STREAM 0xFFFFFFFFU
+
 /*------------------------------------------------------------------------------
     3. Data types
 ------------------------------------------------------------------------------*/
@@ -51,17 +60,153 @@ typedef struct
     u32  strmBuffReadBits;  /* number of bits read from stream buffer */
 } strmData_t;
 
+/* local bit cache for reading many syntax elements in a row without
+ * updating the stream structure after each one, see h264bsdBitCache*. Used
+ * by h264bsdDecodeResidualBlockCavlc, where each code length depends on
+ * the previous lookup and a shift of the cache is quicker than a new load
+ * (see h264bitbench, stream vlc and cache vlc) */
+typedef struct
+{
+    u64  value;             /* next stream bits, first one in the MSB */
+    u32  bits;              /* number of valid bits in value */
+    u32  used;              /* bits consumed since last stream update */
+} bitCache_t;
+
 /*------------------------------------------------------------------------------
     4. Function prototypes
 ------------------------------------------------------------------------------*/
 
-u32 h264bsdGetBits(strmData_t *pStrmData, u32 numBits);
-
-u32 h264bsdShowBits32(strmData_t *pStrmData);
+u64 h264bsdShowTailBits(strmData_t *pStrmData);
 
+#ifdef H264DEC_NEON
 u32 h264bsdFlushBits(strmData_t *pStrmData, u32 numBits);
+#endif
 
 u32 h264bsdIsByteAligned(strmData_t *);
 
+/*------------------------------------------------------------------------------
+    5. Inline functions
+------------------------------------------------------------------------------*/
+
+/* read 8 bytes as a big-endian value */
+static inline u64 h264bsdLoadBE64(const u8 *p)
+{
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    u64 value;
+    memcpy(&value, p, 8);
+    return __builtin_bswap64(value);
+#else
+    return ((u64)p[0] << 56) | ((u64)p[1] << 48) | ((u64)p[2] << 40) |
+           ((u64)p[3] << 32) | ((u64)p[4] << 24) | ((u64)p[5] << 16) |
+           ((u64)p[6] <<  8) | ((u64)p[7]);
+#endif
+}
+
+/* Read the next bits from the stream buffer without removing them. First bit
+ * read is the MSB of the return value, at least 57 bits are valid. Bits
+ * beyond the end of the stream are set to '0'. Only the last 7 bytes of the
+ * buffer take the slow path, everything else is a single 8 byte load. The
+ * stream buffer belongs to the caller and has no padding after the end, so
+ * every read still compares the position with the buffer size. */
+static inline u64 h264bsdShowBits64(strmData_t *pStrmData)
+{
+    u32 bytePos = pStrmData->strmBuffReadBits >> 3;
+
+    if (bytePos + 8 <= pStrmData->strmBuffSize)
+        return h264bsdLoadBE64(pStrmData->pStrmBuffStart + bytePos) <<
+               pStrmData->bitPosInWord;
+    else
+        return h264bsdShowTailBits(pStrmData);
+}
+
+/* Read 32 bits from the stream buffer, buffer is left as it is */
+static inline u32 h264bsdShowBits32(strmData_t *pStrmData)
+{
+    return (u32)(h264bsdShowBits64(pStrmData) >> 32);
+}
+
+/* Remove bits from the stream buffer, returns HANTRO_OK or END_OF_STREAM if
+ * not enough bits left */
+#ifndef H264DEC_NEON
+static inline u32 h264bsdFlushBits(strmData_t *pStrmData, u32 numBits)
+{
+    pStrmData->strmBuffReadBits += numBits;
+    pStrmData->bitPosInWord = pStrmData->strmBuffReadBits & 0x7;
+    if (pStrmData->strmBuffReadBits <= 8 * pStrmData->strmBuffSize)
+    {
+        pStrmData->pStrmCurrPos = pStrmData->pStrmBuffStart +
+            (pStrmData->strmBuffReadBits >> 3);
+        return(HANTRO_OK);
+    }
+    else
+        return(END_OF_STREAM);
+}
+#endif
+
+/* Read and remove numBits (1 to 31) bits from the stream buffer, returns
+ * END_OF_STREAM if not enough bits left */
+static inline u32 h264bsdGetBits(strmData_t *pStrmData, u32 numBits)
+{
+    u32 out = h264bsdShowBits32(pStrmData) >> (32 - numBits);
+
+    if (h264bsdFlushBits(pStrmData, numBits) == HANTRO_OK)
+        return(out);
+    else
+        return(END_OF_STREAM);
+}
+
+/* Initialize bit cache from the current stream position */
+static inline void h264bsdBitCacheInit(strmData_t *pStrmData, bitCache_t *pCache)
+{
+    pCache->value = h264bsdShowBits64(pStrmData);
+    pCache->bits = 64 - pStrmData->bitPosInWord;
+    pCache->used = 0;
+}
+
+/* Move the stream position past the bits consumed from the cache, returns
+ * HANTRO_OK or END_OF_STREAM if more bits were consumed than available */
+static inline u32 h264bsdBitCacheSync(strmData_t *pStrmData, bitCache_t *pCache)
+{
+    u32 used = pCache->used;
+
+    pCache->used = 0;
+    return h264bsdFlushBits(pStrmData, used);
+}
+
+/* Show next numBits (1 to 31) bits, refills the cache if needed. Returns
+ * END_OF_STREAM if the refill runs past the end of the stream */
+static inline u32 h264bsdBitCacheShow(strmData_t *pStrmData, bitCache_t *pCache,
+    u32 numBits)
+{
+    if (pCache->bits < numBits)
+    {
+        if (h264bsdBitCacheSync(pStrmData, pCache) != HANTRO_OK)
+            return(END_OF_STREAM);
+        h264bsdBitCacheInit(pStrmData, pCache);
+    }
+    return (u32)(pCache->value >> (64 - numBits));
+}
+
+/* Remove numBits bits previously shown with h264bsdBitCacheShow */
+static inline void h264bsdBitCacheFlush(bitCache_t *pCache, u32 numBits)
+{
+    pCache->value <<= numBits;
+    pCache->bits -= numBits;
+    pCache->used += numBits;
+}
+
+/* Read and remove numBits (1 to 31) bits, returns END_OF_STREAM if the
+ * refill runs past the end of the stream */
+static inline u32 h264bsdBitCacheGet(strmData_t *pStrmData, bitCache_t *pCache,
+    u32 numBits)
+{
+    u32 out = h264bsdBitCacheShow(pStrmData, pCache, numBits);
+
+    if (out != END_OF_STREAM)
+        h264bsdBitCacheFlush(pCache, numBits);
+    return(out);
+}
+
 #endif /* #ifdef H264SWDEC_STREAM_H */
 
@@ -0,0 +1,1569 @@
+/*------------------------------------------------------------------------------
+
+    Table of contents
+
+     1. Include headers
+     2. External compiler flags
+     3. Module defines
+     4. Local function prototypes
+     5. Functions
+          h264bsdInitThreads
+          h264bsdShutdownThreads
+          h264bsdCanQueueSlice
+          h264bsdSliceQueueFull
+          h264bsdQueueSlice
+          h264bsdSyncSlices
+          h264bsdStartWavefront
+          h264bsdWavefrontRecord
+          h264bsdWavefrontParsed
+          h264bsdFinishWavefront
+          h264bsdSyncPicture
+          h264bsdWaitRefRows
+          SliceWorker
+          RunJob
+          NextRow
+          WavefrontRow
+          FilterRows
+          CompletePicture
+          DiscardMacroblocks
+          PrepareDetach
+          WaitProgress
+          SetProgress
+          AddStats
+
+------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+    1. Include headers
+------------------------------------------------------------------------------*/
+
+#include "h264bsd_threads.h"
+
+#ifdef H264DEC_THREADS
+
+#include "h264bsd_slice_data.h"
+#include "h264bsd_macroblock_layer.h"
+#include "h264bsd_deblocking.h"
+#include "h264bsd_conceal.h"
+#include "h264bsd_neighbour.h"
+#include "h264bsd_image.h"
+#include "h264bsd_util.h"
+
+/*------------------------------------------------------------------------------
+    2. External compiler flags
+--------------------------------------------------------------------------------
+
+H264DEC_THREADS     see h264bsd_threads.h
+
+--------------------------------------------------------------------------------
+    3. Module defines
+------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+    4. Local function prototypes
+------------------------------------------------------------------------------*/
+
+static void *SliceWorker(void *arg);
+static void RunJob(sliceJob_t *job, macroblockLayer_t *mbLayer);
+static wavefront_t *NextRow(sliceThreads_t *threads, u32 *row);
+static void WavefrontRow(sliceThreads_t *threads, wavefront_t *wf, u32 row);
+static void FilterRows(sliceThreads_t *threads, wavefront_t *wf);
+static void CompletePicture(sliceThreads_t *threads, wavefront_t *wf);
+static void DiscardMacroblocks(storage_t *pStorage, wavefront_t *wf);
+static u32 PrepareDetach(storage_t *pStorage, wavefront_t *wf);
+static u32 WaitProgress(sliceThreads_t *threads, wavefront_t *wf,
+    u32 *pCounter, u32 value, u32 mbAddr);
+static void SetProgress(sliceThreads_t *threads, u32 *pCounter, u32 value);
+#ifdef H264DEC_STATS
+static void AddStats(H264SwDecStats *pStats, H264SwDecStats *pJobStats);
+#endif
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdInitThreads
+
+        Functional description:
+            Allocate slice job storage and start the worker threads.
+
+        Inputs:
+            pStorage    pointer to storage structure
+
+        Outputs:
+            pStorage->threads   initialized thread pool
+
+        Returns:
+            HANTRO_OK   success
+            HANTRO_NOK  memory allocation or thread creation failed
+
+------------------------------------------------------------------------------*/
+
+u32 h264bsdInitThreads(storage_t *pStorage)
+{
+
+/* Variables */
+
+    u32 i, size;
+    sliceThreads_t *threads;
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    ALLOCATE(threads, 1, sliceThreads_t);
+    if (threads == NULL)
+        return(HANTRO_NOK);
+    H264SwDecMemset(threads, 0, sizeof(sliceThreads_t));
+
+    pthread_mutex_init(&threads->mutex, NULL);
+    pthread_cond_init(&threads->jobReady, NULL);
+    pthread_cond_init(&threads->jobDone, NULL);
+    pthread_cond_init(&threads->wfProgress, NULL);
+    pStorage->threads = threads;
+    pStorage->dpb->threads = threads;
+
+    /* same size as the macroblock layer of the decoder, see h264bsdInit */
+    size = (sizeof(macroblockLayer_t) + 63) & ~0x3F;
+    threads->wfRecordSize = size;
+
+    for (i = 0; i < H264DEC_THREADS; i++)
+    {
+        threads->worker[i].threads = threads;
+        threads->worker[i].mbLayer =
+            (macroblockLayer_t*)H264SwDecMalloc(size, 1);
+        if (threads->worker[i].mbLayer == NULL)
+            return(HANTRO_NOK);
+        if (pthread_create(&threads->worker[i].thread, NULL, SliceWorker,
+                threads->worker + i))
+        {
+            FREE(threads->worker[i].mbLayer);
+            return(HANTRO_NOK);
+        }
+        threads->numWorkers++;
+    }
+
+    return(HANTRO_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdShutdownThreads
+
+        Functional description:
+            Stop the worker threads and free the memories allocated by
+            h264bsdInitThreads. Also works for a partially initialized
+            thread pool.
+
+        Inputs:
+            pStorage    pointer to storage structure
+
+        Outputs:
+            none
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdShutdownThreads(storage_t *pStorage)
+{
+
+/* Variables */
+
+    u32 i;
+    sliceThreads_t *threads;
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    threads = pStorage->threads;
+    if (threads == NULL)
+        return;
+
+    (void)h264bsdSyncSlices(pStorage);
+    h264bsdSyncPicture(pStorage, NULL);
+
+    pthread_mutex_lock(&threads->mutex);
+    threads->quit = HANTRO_TRUE;
+    pthread_cond_broadcast(&threads->jobReady);
+    pthread_mutex_unlock(&threads->mutex);
+
+    for (i = 0; i < threads->numWorkers; i++)
+    {
+        pthread_join(threads->worker[i].thread, NULL);
+        FREE(threads->worker[i].mbLayer);
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        FREE(threads->wf[i].records);
+        FREE(threads->wf[i].rowDone);
+        FREE(threads->wf[i].sliceGroupMap);
+    }
+    FREE(threads->spareMb);
+
+    pthread_cond_destroy(&threads->wfProgress);
+    pthread_cond_destroy(&threads->jobDone);
+    pthread_cond_destroy(&threads->jobReady);
+    pthread_mutex_destroy(&threads->mutex);
+
+    FREE(pStorage->threads);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdCanQueueSlice
+
+        Functional description:
+            Determine if a slice can be decoded in parallel with the slices
+            already queued. This is the case for primary slices of pictures
+            with one slice group when all the preceding slices of the picture
+            have been queued and the slice starts after them in raster scan
+            order, i.e. macroblocks of the slices cannot overlap.
+
+        Inputs:
+            pStorage        pointer to storage structure
+            pSliceHeader    pointer to decoded header of the slice
+
+        Outputs:
+            none
+
+        Returns:
+            HANTRO_TRUE     slice can be queued
+            HANTRO_FALSE    slice shall be decoded after the queued ones
+
+------------------------------------------------------------------------------*/
+
+u32 h264bsdCanQueueSlice(storage_t *pStorage, sliceHeader_t *pSliceHeader)
+{
+
+/* Variables */
+
+    sliceThreads_t *threads;
+
+/* Code */
+
+    ASSERT(pStorage);
+    ASSERT(pSliceHeader);
+
+    threads = pStorage->threads;
+
+    if (pStorage->activePps->numSliceGroups != 1 ||
+        pSliceHeader->redundantPicCnt)
+        return(HANTRO_FALSE);
+
+    /* first slice of the picture */
+    if (!pStorage->slice->sliceId)
+        return(HANTRO_TRUE);
+
+    if (threads->numPicJobs == pStorage->slice->sliceId &&
+        pSliceHeader->firstMbInSlice > threads->lastFirstMb)
+        return(HANTRO_TRUE);
+
+    return(HANTRO_FALSE);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdSliceQueueFull
+
+        Functional description:
+            Determine if queued slices have to be finished before another
+            one can be queued.
+
+        Returns:
+            HANTRO_TRUE     queue full
+            HANTRO_FALSE    otherwise
+
+------------------------------------------------------------------------------*/
+
+u32 h264bsdSliceQueueFull(storage_t *pStorage)
+{
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    return(pStorage->threads->numJobs == MAX_SLICE_JOBS ?
+        HANTRO_TRUE : HANTRO_FALSE);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdQueueSlice
+
+        Functional description:
+            Queue the slice whose header is stored in pStorage->sliceHeader
+            for decoding. The slice is not started before its last possible
+            macroblock is known, i.e. before the next slice is queued or
+            h264bsdSyncSlices is called. Reference picture list and current
+            image have to be set up for the slice before calling this
+            function, the data pointed by pStrmData has to remain valid until
+            h264bsdSyncSlices returns. Macroblock rows of a picture with
+            several queued slices are deblocked when the whole picture is
+            ready.
+
+        Inputs:
+            pStorage    pointer to storage structure
+            pStrmData   stream positioned at the start of the slice data
+
+        Outputs:
+            pStorage    sliceId incremented as if the slice was decoded
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdQueueSlice(storage_t *pStorage, strmData_t *pStrmData)
+{
+
+/* Variables */
+
+    u32 firstMb;
+    sliceThreads_t *threads;
+    sliceJob_t *job;
+
+/* Code */
+
+    ASSERT(pStorage);
+    ASSERT(pStrmData);
+    ASSERT(pStorage->threads->numJobs < MAX_SLICE_JOBS);
+
+    threads = pStorage->threads;
+    firstMb = pStorage->sliceHeader->firstMbInSlice;
+
+    job = threads->job + threads->numJobs;
+    job->storage = *pStorage;
+    H264SwDecMemcpy(job->refPicList, pStorage->dpb->list,
+        sizeof(job->refPicList));
+    job->storage.dpb->list = job->refPicList;
+    job->storage.slice->endMbAddr = 0;
+    job->storage.slice->overrun = HANTRO_FALSE;
+#ifdef H264DEC_STATS
+    H264SwDecMemset(&job->storage.stats, 0, sizeof(H264SwDecStats));
+#endif
+    job->strm = *pStrmData;
+
+    if (!pStorage->slice->sliceId)
+        threads->numPicJobs = 0;
+    threads->numPicJobs++;
+    threads->lastFirstMb = firstMb;
+
+    /* slice id of the job is incremented when the job is started, next
+     * slice shall get the one after that. Rows cannot be deblocked during
+     * decoding of the remaining slices of the picture */
+    pStorage->slice->sliceId++;
+    pStorage->slice->outOfOrder = HANTRO_TRUE;
+
+    pthread_mutex_lock(&threads->mutex);
+    /* previous queued slice ends where this one starts -> it can be started.
+     * Macroblocks decoded before it are not known, macroblock count of the
+     * job is added to the storage when finished */
+    if (threads->numReady < threads->numJobs)
+    {
+        job = threads->job + threads->numReady;
+        job->storage.slice->endMbAddr = firstMb;
+        job->storage.slice->numDecodedMbs = 0;
+        job->storage.slice->outOfOrder = HANTRO_TRUE;
+        threads->numReady++;
+        pthread_cond_signal(&threads->jobReady);
+    }
+    threads->numJobs++;
+    pthread_mutex_unlock(&threads->mutex);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdSyncSlices
+
+        Functional description:
+            Finish all queued slices. The calling thread decodes the slices
+            not yet started by the workers and waits for the rest. Results
+            are then collected in decoding order: macroblock counts of
+            successfully decoded slices are added to the storage and the
+            erroneous slices are marked corrupted, as is done when slices are
+            decoded one after another.
+
+            A slice of a corrupted stream may run into the first macroblock
+            of the next one, where decoding stops (slice->overrun). Decoded
+            one after another the slice would have continued over the next
+            slice instead, so the macroblocks of that slice and the
+            following ones are reset and the slices are decoded again by the
+            calling thread, without a limit. The result does not depend on
+            H264DEC_THREADS.
+
+            A single queued slice is decoded in wavefront order by the
+            calling thread and the workers. The slice then continues
+            decoding state of the storage (macroblock count, deblocked rows)
+            as if it was decoded directly. If the slice completed the
+            picture and the picture was detached (see
+            h264bsdFinishWavefront) the picture previously detached is
+            finished first and the storage gets new macroblock storage for
+            the next picture. Time spent waiting for the workers is added
+            to syncTime of the statistics, as in h264bsdSyncPicture.
+
+        Inputs:
+            pStorage    pointer to storage structure
+
+        Outputs:
+            pStorage    numDecodedMbs, macroblock data and statistics updated
+
+        Returns:
+            HANTRO_TRUE     queued slices were finished
+            HANTRO_FALSE    nothing was queued
+
+------------------------------------------------------------------------------*/
+
+u32 h264bsdSyncSlices(storage_t *pStorage)
+{
+
+/* Variables */
+
+    u32 i, mbAddr, numJobs;
+    u32 redecode;
+    sliceThreads_t *threads;
+    sliceJob_t *job;
+    wavefront_t *wf;
+#ifdef H264DEC_STATS
+    u64 statsTime;
+#endif
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    threads = pStorage->threads;
+    if (!threads->numJobs)
+        return(HANTRO_FALSE);
+
+    wf = NULL;
+    pthread_mutex_lock(&threads->mutex);
+    if (threads->numJobs == 1)
+    {
+        /* parsed by the calling thread, macroblock rows reconstructed by
+         * the workers. The job is moved to a wavefront not in use, the
+         * picture may still be finished after the next one is queued */
+        wf = threads->wf + (threads->wfPending == threads->wf ? 1 : 0);
+        wf->job = threads->job[0];
+        for (i = 0; i < MAX_NUM_REF_IDX_L0_ACTIVE + 1; i++)
+        {
+            if (wf->job.refPicList[i] != NULL)
+            {
+                wf->refPics[i] = *wf->job.refPicList[i];
+                wf->job.refPicList[i] = wf->refPics + i;
+            }
+        }
+        wf->job.storage.dpb->list = wf->job.refPicList;
+        wf->job.storage.slice->wavefront = HANTRO_TRUE;
+        threads->wfActive = wf;
+        threads->numReady = threads->numStarted = 1;
+        pthread_mutex_unlock(&threads->mutex);
+        RunJob(&wf->job, pStorage->mbLayer);
+        pthread_mutex_lock(&threads->mutex);
+        threads->numDone++;
+    }
+    else
+    {
+        /* last queued slice may extend to the end of the picture */
+        job = threads->job + threads->numJobs - 1;
+        job->storage.slice->numDecodedMbs = 0;
+        job->storage.slice->outOfOrder = HANTRO_TRUE;
+        threads->numReady = threads->numJobs;
+        pthread_cond_broadcast(&threads->jobReady);
+    }
+    while (threads->numStarted < threads->numJobs)
+    {
+        job = threads->job + threads->numStarted++;
+        pthread_mutex_unlock(&threads->mutex);
+        RunJob(job, pStorage->mbLayer);
+        pthread_mutex_lock(&threads->mutex);
+        threads->numDone++;
+    }
+    /* slices decoded above are in the statistics of their jobs, only the
+     * time spent waiting for the workers is added here */
+    STATS_START(statsTime);
+    while (threads->numDone < threads->numJobs)
+        pthread_cond_wait(&threads->jobDone, &threads->mutex);
+    STATS_STOP(pStorage, syncTime, statsTime);
+    numJobs = threads->numJobs;
+    threads->numJobs = threads->numReady = 0;
+    threads->numStarted = threads->numDone = 0;
+    threads->wfActive = NULL;
+    pthread_mutex_unlock(&threads->mutex);
+
+    redecode = HANTRO_FALSE;
+    for (i = 0; i < numJobs; i++)
+    {
+        job = wf != NULL ? &wf->job : threads->job + i;
+        /* macroblocks decoded by this and the following slices get the
+         * state they had before the slices, macroblocks of the previous
+         * ones (lower slice ids) are kept */
+        if (job->storage.slice->overrun && !redecode)
+        {
+            redecode = HANTRO_TRUE;
+            for (mbAddr = job->storage.sliceHeader->firstMbInSlice;
+                 mbAddr < pStorage->picSizeInMbs; mbAddr++)
+            {
+                if (pStorage->mb[mbAddr].sliceId >=
+                    job->storage.slice->sliceId)
+                {
+                    pStorage->mb[mbAddr].sliceId = 0;
+                    pStorage->mb[mbAddr].decoded = 0;
+                }
+            }
+        }
+        if (redecode)
+        {
+            job->storage.slice->sliceId--;
+            job->storage.slice->endMbAddr = 0;
+            job->storage.slice->numDecodedMbs = 0;
+            RunJob(job, pStorage->mbLayer);
+        }
+        if (job->storage.slice->wavefront)
+        {
+            pStorage->slice->numDecodedMbs = job->storage.slice->numDecodedMbs;
+            pStorage->slice->numFilteredRows =
+                job->storage.slice->numFilteredRows;
+            pStorage->slice->outOfOrder = job->storage.slice->outOfOrder;
+        }
+        else if (job->result == HANTRO_OK)
+            pStorage->slice->numDecodedMbs +=
+                job->storage.slice->numDecodedMbs;
+        if (job->result != HANTRO_OK)
+            h264bsdMarkSliceCorrupted(&job->storage,
+                job->storage.sliceHeader->firstMbInSlice);
+#ifdef H264DEC_STATS
+        AddStats(&pStorage->stats, &job->storage.stats);
+#endif
+    }
+
+    if (wf != NULL && wf->detached)
+    {
+        /* one picture finished by the workers at a time */
+        h264bsdSyncPicture(pStorage, NULL);
+
+        wf->mb = pStorage->mb;
+        pStorage->mb = threads->spareMb;
+        threads->spareMb = NULL;
+        threads->wfPending = wf;
+        __atomic_store_n(&wf->data, pStorage->currImage->data,
+            __ATOMIC_RELEASE);
+    }
+
+    return(HANTRO_TRUE);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdStartWavefront
+
+        Functional description:
+            Start wavefront decoding of the slice whose header is stored in
+            pStorage->sliceHeader. Macroblock rows from the one containing
+            the first macroblock of the slice to the end of the picture are
+            handed to the workers, each row is reconstructed as far as the
+            macroblocks have been parsed (h264bsdWavefrontParsed) and the
+            row above has been reconstructed, i.e. macroblock (x,y) waits
+            for (x+1,y-1). Called by h264bsdDecodeSliceData.
+
+        Inputs:
+            pStorage    pointer to storage structure, slice->outOfOrder and
+                        slice->numFilteredRows determine if the rows are
+                        deblocked during reconstruction (H264DEC_ROW_DEBLOCK)
+
+        Outputs:
+            none
+
+        Returns:
+            HANTRO_OK   success
+            HANTRO_NOK  memory allocation failed, slice shall be decoded
+                        by the calling thread only
+
+------------------------------------------------------------------------------*/
+
+u32 h264bsdStartWavefront(storage_t *pStorage)
+{
+
+/* Variables */
+
+    u32 i, width, height;
+    u32 firstMb, firstRow;
+    sliceThreads_t *threads;
+    wavefront_t *wf;
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    threads = pStorage->threads;
+    wf = threads->wfActive;
+    width = pStorage->activeSps->picWidthInMbs;
+    height = pStorage->picSizeInMbs / width;
+
+    ASSERT(wf);
+    ASSERT(wf->data == NULL);
+
+    if (WAVEFRONT_ROWS * width > wf->numRecords)
+    {
+        FREE(wf->records);
+        wf->numRecords = 0;
+        wf->records = (u8*)H264SwDecMalloc(threads->wfRecordSize,
+            WAVEFRONT_ROWS * width);
+        if (wf->records == NULL)
+            return(HANTRO_NOK);
+        wf->numRecords = WAVEFRONT_ROWS * width;
+    }
+    if (height > wf->numRows)
+    {
+        FREE(wf->rowDone);
+        wf->numRows = 0;
+        ALLOCATE(wf->rowDone, height, u32);
+        if (wf->rowDone == NULL)
+            return(HANTRO_NOK);
+        wf->numRows = height;
+    }
+
+    firstMb = pStorage->sliceHeader->firstMbInSlice;
+    firstRow = firstMb / width;
+
+    /* macroblocks preceding the slice are not needed by the slice, treat
+     * them as reconstructed */
+    for (i = 0; i < height; i++)
+        wf->rowDone[i] = i < firstRow ? width : 0;
+    wf->rowDone[firstRow] = firstMb - firstRow * width;
+
+    wf->width = width;
+    wf->height = height;
+    wf->firstMb = firstMb;
+    wf->parsed = firstMb;
+    wf->limit = pStorage->picSizeInMbs;
+    wf->error = pStorage->picSizeInMbs;
+    wf->rowsDone = 0;
+#ifdef H264DEC_ROW_DEBLOCK
+    wf->filter = pStorage->slice->outOfOrder ? HANTRO_FALSE : HANTRO_TRUE;
+#else
+    /* rows become usable as reference only when the picture is complete,
+     * see H264DEC_THREADS in h264bsd_threads.h */
+    wf->filter = HANTRO_FALSE;
+#endif
+    wf->filterRow = pStorage->slice->numFilteredRows;
+    wf->detached = HANTRO_FALSE;
+    /* rows above the last deblocked one are final */
+    wf->refRows = wf->filterRow ? wf->filterRow - 1 : 0;
+    wf->done = HANTRO_FALSE;
+#ifdef H264DEC_STATS
+    H264SwDecMemset(&wf->stats, 0, sizeof(H264SwDecStats));
+#endif
+
+    pthread_mutex_lock(&threads->mutex);
+    wf->seq = threads->wfSeq++;
+    wf->nextRow = firstRow;
+    wf->endRow = height;
+    pthread_cond_broadcast(&threads->jobReady);
+    pthread_mutex_unlock(&threads->mutex);
+
+    return(HANTRO_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdWavefrontRecord
+
+        Functional description:
+            Get the macroblock layer record the macroblock is parsed into.
+            Records form a ring of WAVEFRONT_ROWS macroblock rows, the first
+            macroblock of a row waits until the row previously using the
+            records has been reconstructed.
+
+        Inputs:
+            pStorage    pointer to storage structure
+            mbAddr      address of the macroblock
+
+        Outputs:
+            none
+
+        Returns:
+            pointer to the record, NULL if reconstruction of a preceding
+            macroblock failed and the slice shall not be parsed further
+
+------------------------------------------------------------------------------*/
+
+macroblockLayer_t *h264bsdWavefrontRecord(storage_t *pStorage, u32 mbAddr)
+{
+
+/* Variables */
+
+    u32 row, col;
+    sliceThreads_t *threads;
+    wavefront_t *wf;
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    threads = pStorage->threads;
+    wf = threads->wfActive;
+    row = mbAddr / wf->width;
+    col = mbAddr - row * wf->width;
+
+    if (__atomic_load_n(&wf->limit, __ATOMIC_RELAXED) <= mbAddr)
+        return(NULL);
+
+    if (!col && row >= WAVEFRONT_ROWS &&
+        !WaitProgress(threads, wf, wf->rowDone + row - WAVEFRONT_ROWS,
+            wf->width, mbAddr))
+        return(NULL);
+
+    return((macroblockLayer_t*)(wf->records + threads->wfRecordSize *
+        ((row % WAVEFRONT_ROWS) * wf->width + col)));
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdWavefrontParsed
+
+        Functional description:
+            Hand a parsed macroblock over to reconstruction. Macroblock
+            parameters have to be stored (h264bsdStoreMacroblockParams)
+            before calling this function.
+
+        Inputs:
+            pStorage    pointer to storage structure
+            mbAddr      address of the macroblock
+
+        Outputs:
+            none
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdWavefrontParsed(storage_t *pStorage, u32 mbAddr)
+{
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    SetProgress(pStorage->threads, &pStorage->threads->wfActive->parsed,
+        mbAddr + 1);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdFinishWavefront
+
+        Functional description:
+            Finish wavefront decoding of a slice after all of its macroblocks
+            have been parsed or parsing failed.
+
+            A slice successfully parsed to the last macroblock of the
+            picture, following slices decoded in raster scan order and not
+            failed in reconstruction so far, is detached: the workers finish
+            and deblock the rows (all of them once reconstructed unless
+            H264DEC_ROW_DEBLOCK) while the decoding thread continues with the
+            next picture, all rows are reported deblocked. Otherwise the
+            calling thread helps with the remaining rows and waits for the
+            workers. If
+            reconstruction of a macroblock failed the state is made the same
+            as if the slice was decoded sequentially: later macroblocks
+            parsed meanwhile are marked not decoded and last successfully
+            decoded macroblock of an I slice is stored for error
+            concealment.
+
+        Inputs:
+            pStorage    pointer to storage structure
+            result      result of parsing
+
+        Outputs:
+            pStorage    slice->numFilteredRows, slice->lastMbAddr and
+                        statistics updated
+
+        Returns:
+            HANTRO_OK   success
+            HANTRO_NOK  parsing or reconstruction of the slice failed
+
+------------------------------------------------------------------------------*/
+
+u32 h264bsdFinishWavefront(storage_t *pStorage, u32 result)
+{
+
+/* Variables */
+
+    u32 row, numRows;
+    sliceThreads_t *threads;
+    wavefront_t *wf, *next;
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    threads = pStorage->threads;
+    wf = threads->wfActive;
+    numRows = wf->height - wf->firstMb / wf->width;
+
+    pthread_mutex_lock(&threads->mutex);
+    /* macroblocks not parsed do not belong to the slice */
+    if (wf->parsed < wf->limit)
+        __atomic_store_n(&wf->limit, wf->parsed, __ATOMIC_SEQ_CST);
+    pthread_cond_broadcast(&threads->wfProgress);
+    pthread_mutex_unlock(&threads->mutex);
+
+    if (result == HANTRO_OK && !pStorage->slice->outOfOrder &&
+        wf->parsed == pStorage->picSizeInMbs &&
+        PrepareDetach(pStorage, wf) == HANTRO_OK)
+    {
+        pthread_mutex_lock(&threads->mutex);
+        if (wf->error == pStorage->picSizeInMbs && wf->rowsDone < numRows)
+            wf->detached = HANTRO_TRUE;
+        pthread_mutex_unlock(&threads->mutex);
+        if (wf->detached)
+        {
+            pStorage->slice->numFilteredRows = wf->height;
+            return(HANTRO_OK);
+        }
+    }
+
+    /* rows of a detached picture are taken first as this one may depend
+     * on them */
+    pthread_mutex_lock(&threads->mutex);
+    while (wf->rowsDone < numRows)
+    {
+        if ((next = NextRow(threads, &row)) != NULL)
+        {
+            pthread_mutex_unlock(&threads->mutex);
+            WavefrontRow(threads, next, row);
+            pthread_mutex_lock(&threads->mutex);
+        }
+        else
+            pthread_cond_wait(&threads->jobDone, &threads->mutex);
+    }
+    pthread_mutex_unlock(&threads->mutex);
+
+    pStorage->slice->numFilteredRows = wf->filterRow;
+#ifdef H264DEC_STATS
+    AddStats(&pStorage->stats, &wf->stats);
+#endif
+
+    if (wf->error < pStorage->picSizeInMbs)
+    {
+        EPRINT("MACRO_BLOCK");
+        DiscardMacroblocks(pStorage, wf);
+        return(HANTRO_NOK);
+    }
+
+    return(result);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdSyncPicture
+
+        Functional description:
+            Wait until the picture detached from the decoding thread has
+            been finished by the workers, if the picture data or the given
+            picture buffer is used by it. The calling thread helps with the
+            remaining rows. Number of concealed macroblocks of the picture
+            is then updated to the DPB and the macroblock storage of the
+            picture is kept for the next detached picture. Called before
+            a picture buffer is decoded into or output, before concealment
+            and parameter set changes. Time spent waiting for the workers is
+            added to syncTime of the statistics.
+
+        Inputs:
+            pStorage    pointer to storage structure
+            data        picture buffer to be used, NULL to finish the
+                        picture in any case
+
+        Outputs:
+            pStorage    dpb and statistics updated
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdSyncPicture(storage_t *pStorage, u8 *data)
+{
+
+/* Variables */
+
+    u32 i, row, numErrMbs;
+    sliceThreads_t *threads;
+    wavefront_t *wf, *next;
+    dpbStorage_t *dpb;
+#ifdef H264DEC_STATS
+    u64 statsTime;
+#endif
+
+/* Code */
+
+    ASSERT(pStorage);
+
+    threads = pStorage->threads;
+    wf = threads->wfPending;
+    if (wf == NULL)
+        return;
+
+    if (data != NULL && data != wf->data)
+    {
+        for (i = 0; i < MAX_NUM_REF_IDX_L0_ACTIVE + 1; i++)
+            if (wf->job.refPicList[i] != NULL && wf->refPics[i].data == data)
+                break;
+        if (i == MAX_NUM_REF_IDX_L0_ACTIVE + 1)
+            return;
+    }
+
+    pthread_mutex_lock(&threads->mutex);
+    while (!wf->done)
+    {
+        if ((next = NextRow(threads, &row)) != NULL)
+        {
+            pthread_mutex_unlock(&threads->mutex);
+            WavefrontRow(threads, next, row);
+            pthread_mutex_lock(&threads->mutex);
+        }
+        else
+        {
+            /* rows reconstructed above are in the statistics of the
+             * picture, only the time spent waiting is added here */
+            STATS_START(statsTime);
+            pthread_cond_wait(&threads->jobDone, &threads->mutex);
+            STATS_STOP(pStorage, syncTime, statsTime);
+        }
+    }
+    pthread_mutex_unlock(&threads->mutex);
+
+    data = wf->data;
+    __atomic_store_n(&wf->data, NULL, __ATOMIC_RELEASE);
+    threads->wfPending = NULL;
+
+    /* picture was stored to the DPB before it was concealed */
+    numErrMbs = wf->job.storage.numConcealedMbs;
+    if (numErrMbs)
+    {
+        dpb = pStorage->dpb;
+        for (i = 0; i < dpb->dpbSize + 1; i++)
+            if (dpb->buffer[i].data == data)
+                dpb->buffer[i].numErrMbs = numErrMbs;
+        for (i = 0; i < dpb->numOut; i++)
+            if (dpb->outBuf[i].data == data)
+                dpb->outBuf[i].numErrMbs = numErrMbs;
+    }
+#ifdef H264DEC_STATS
+    AddStats(&pStorage->stats, &wf->stats);
+    pStorage->stats.numConcealedMbs += numErrMbs;
+#endif
+
+    ASSERT(threads->spareMb == NULL);
+    threads->spareMb = wf->mb;
+    threads->spareWidth = wf->width;
+    threads->spareSize = wf->width * wf->height;
+    wf->mb = NULL;
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdWaitRefRows
+
+        Functional description:
+            Wait until the given number of macroblock rows of a reference
+            picture can be used for inter prediction, i.e. the rows have
+            been reconstructed and deblocked. Returns immediately unless
+            the picture is being finished by the workers.
+
+        Inputs:
+            dpb         pointer to the DPB of the picture using the
+                        reference
+            data        reference picture data
+            numRows     number of rows from the top of the picture
+
+        Outputs:
+            none
+
+        Returns:
+            none
+
+------------------------------------------------------------------------------*/
+
+void h264bsdWaitRefRows(dpbStorage_t *dpb, u8 *data, u32 numRows)
+{
+
+/* Variables */
+
+    u32 i;
+    sliceThreads_t *threads;
+
+/* Code */
+
+    ASSERT(dpb);
+
+    threads = dpb->threads;
+    for (i = 0; i < 2; i++)
+        if (__atomic_load_n(&threads->wf[i].data, __ATOMIC_ACQUIRE) == data)
+            (void)WaitProgress(threads, NULL, &threads->wf[i].refRows,
+                numRows, 0);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: SliceWorker
+
+        Functional description:
+            Worker thread main loop, decode queued slices and macroblock
+            rows of wavefronts as they become ready until the thread pool
+            is shut down. Rows are taken first, those of the oldest
+            wavefront first.
+
+------------------------------------------------------------------------------*/
+
+void *SliceWorker(void *arg)
+{
+
+/* Variables */
+
+    u32 row;
+    sliceWorker_t *worker;
+    sliceThreads_t *threads;
+    sliceJob_t *job;
+    wavefront_t *wf;
+
+/* Code */
+
+    worker = (sliceWorker_t*)arg;
+    threads = worker->threads;
+
+    pthread_mutex_lock(&threads->mutex);
+    for (;;)
+    {
+        wf = NULL;
+        while (!threads->quit && (wf = NextRow(threads, &row)) == NULL &&
+               threads->numStarted == threads->numReady)
+            pthread_cond_wait(&threads->jobReady, &threads->mutex);
+        if (threads->quit)
+            break;
+
+        if (wf != NULL)
+        {
+            pthread_mutex_unlock(&threads->mutex);
+            WavefrontRow(threads, wf, row);
+            pthread_mutex_lock(&threads->mutex);
+            continue;
+        }
+
+        job = threads->job + threads->numStarted++;
+        pthread_mutex_unlock(&threads->mutex);
+        RunJob(job, worker->mbLayer);
+        pthread_mutex_lock(&threads->mutex);
+        threads->numDone++;
+        pthread_cond_signal(&threads->jobDone);
+    }
+    pthread_mutex_unlock(&threads->mutex);
+
+    return(NULL);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: RunJob
+
+        Functional description:
+            Decode slice data of a queued slice using given macroblock layer
+            scratch.
+
+------------------------------------------------------------------------------*/
+
+void RunJob(sliceJob_t *job, macroblockLayer_t *mbLayer)
+{
+
+/* Variables */
+
+    strmData_t strm;
+
+/* Code */
+
+    /* stream of the job is kept for decoding the slice again */
+    strm = job->strm;
+    job->storage.mbLayer = mbLayer;
+    job->result = h264bsdDecodeSliceData(&strm, &job->storage,
+        job->storage.currImage, job->storage.sliceHeader);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: NextRow
+
+        Functional description:
+            Take the next row not yet started from the oldest wavefront
+            having one. Called with the mutex locked.
+
+        Returns:
+            pointer to the wavefront, NULL if no rows available
+
+------------------------------------------------------------------------------*/
+
+wavefront_t *NextRow(sliceThreads_t *threads, u32 *row)
+{
+
+/* Variables */
+
+    u32 i;
+    wavefront_t *wf;
+
+/* Code */
+
+    wf = NULL;
+    for (i = 0; i < 2; i++)
+    {
+        if (threads->wf[i].nextRow < threads->wf[i].endRow &&
+            (wf == NULL || (i32)(threads->wf[i].seq - wf->seq) < 0))
+            wf = threads->wf + i;
+    }
+
+    if (wf != NULL)
+        *row = wf->nextRow++;
+
+    return(wf);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: WavefrontRow
+
+        Functional description:
+            Reconstruct one macroblock row of a slice decoded in wavefront
+            order, see h264bsdStartWavefront. Stops at the first macroblock
+            not belonging to the slice or failing to reconstruct, in which
+            case the rest of the slice is cancelled. Deblocks the rows that
+            have become ready. The thread finishing the last row of a
+            detached picture finishes the picture.
+
+------------------------------------------------------------------------------*/
+
+void WavefrontRow(sliceThreads_t *threads, wavefront_t *wf, u32 row)
+{
+
+/* Variables */
+
+    u8 mbData[384 + 15 + 32];
+    u8 *data;
+    u32 tmp, col, width, mbAddr, last;
+    storage_t *pStorage;
+    image_t image;
+    macroblockLayer_t *mbLayer;
+#ifdef H264DEC_STATS
+    u64 statsTime, intraMbTime = 0, interMbTime = 0;
+#endif
+
+/* Code */
+
+    /* ensure 16-byte alignment */
+    data = (u8*)ALIGN(mbData, 16);
+
+    pStorage = &wf->job.storage;
+    width = wf->width;
+    /* macroblock pointers of the image are private to the thread */
+    image = *pStorage->currImage;
+
+    mbAddr = MAX(row * width, wf->firstMb);
+    col = mbAddr - row * width;
+    mbLayer = (macroblockLayer_t*)(wf->records + threads->wfRecordSize *
+        ((row % WAVEFRONT_ROWS) * width + col));
+
+    for (; col < width; col++, mbAddr++)
+    {
+        if (!WaitProgress(threads, wf, &wf->parsed, mbAddr + 1, mbAddr) ||
+            (row && !WaitProgress(threads, wf, wf->rowDone + row - 1,
+                MIN(col + 2, width), mbAddr)))
+            break;
+
+        STATS_START(statsTime);
+        tmp = h264bsdDecodeMacroblock(pStorage->mb + mbAddr, mbLayer, &image,
+            pStorage->dpb, mbAddr,
+            pStorage->activePps->constrainedIntraPredFlag, data);
+#ifdef H264DEC_STATS
+        if (IS_INTRA_MB(*mbLayer))
+            intraMbTime += h264bsdStatsTime() - statsTime;
+        else
+            interMbTime += h264bsdStatsTime() - statsTime;
+#endif
+        if (tmp != HANTRO_OK)
+        {
+            /* following macroblocks are not decoded */
+            pthread_mutex_lock(&threads->mutex);
+            if (mbAddr < wf->error)
+                wf->error = mbAddr;
+            if (mbAddr + 1 < wf->limit)
+                __atomic_store_n(&wf->limit, mbAddr + 1, __ATOMIC_SEQ_CST);
+            pthread_cond_broadcast(&threads->wfProgress);
+            pthread_mutex_unlock(&threads->mutex);
+            break;
+        }
+
+        SetProgress(threads, wf->rowDone + row, col + 1);
+        mbLayer = (macroblockLayer_t*)((u8*)mbLayer + threads->wfRecordSize);
+    }
+
+    if (col == width)
+        FilterRows(threads, wf);
+
+    pthread_mutex_lock(&threads->mutex);
+#ifdef H264DEC_STATS
+    wf->stats.intraMbTime += intraMbTime;
+    wf->stats.interMbTime += interMbTime;
+#endif
+    wf->rowsDone++;
+    last = wf->detached &&
+        wf->rowsDone == wf->height - wf->firstMb / width ?
+        HANTRO_TRUE : HANTRO_FALSE;
+    pthread_cond_broadcast(&threads->jobDone);
+    pthread_mutex_unlock(&threads->mutex);
+
+    if (last)
+        CompletePicture(threads, wf);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: FilterRows
+
+        Functional description:
+            Deblock the rows of a wavefront whose row below has been
+            reconstructed, in order. Only one thread deblocks at a time,
+            others return immediately, the deblocking thread checks for
+            newly finished rows before it stops. Rows above the deblocked
+            one are final and usable as reference.
+
+------------------------------------------------------------------------------*/
+
+void FilterRows(sliceThreads_t *threads, wavefront_t *wf)
+{
+
+/* Variables */
+
+    u32 row;
+#ifdef H264DEC_STATS
+    u64 statsTime;
+#endif
+
+/* Code */
+
+    pthread_mutex_lock(&threads->mutex);
+    if (wf->filter && !wf->filtering)
+    {
+        wf->filtering = HANTRO_TRUE;
+        while (wf->filterRow + 1 < wf->height &&
+               __atomic_load_n(wf->rowDone + wf->filterRow + 1,
+                   __ATOMIC_ACQUIRE) == wf->width)
+        {
+            row = wf->filterRow;
+            pthread_mutex_unlock(&threads->mutex);
+            STATS_START(statsTime);
+            h264bsdFilterMbRows(wf->job.storage.currImage,
+                wf->job.storage.mb, row, 1);
+            SetProgress(threads, &wf->refRows, row);
+            pthread_mutex_lock(&threads->mutex);
+#ifdef H264DEC_STATS
+            wf->stats.deblockTime += h264bsdStatsTime() - statsTime;
+#endif
+            wf->filterRow++;
+        }
+        wf->filtering = HANTRO_FALSE;
+    }
+    pthread_mutex_unlock(&threads->mutex);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: CompletePicture
+
+        Functional description:
+            Finish a detached picture once all of its rows have been
+            processed. If reconstruction of a macroblock failed the
+            picture is concealed as an incomplete picture would be, then
+            the remaining rows are deblocked, after which all rows can be
+            used as reference.
+
+------------------------------------------------------------------------------*/
+
+void CompletePicture(sliceThreads_t *threads, wavefront_t *wf)
+{
+
+/* Variables */
+
+    storage_t *pStorage;
+#ifdef H264DEC_STATS
+    u64 statsTime;
+#endif
+
+/* Code */
+
+    pStorage = &wf->job.storage;
+
+    if (wf->error < pStorage->picSizeInMbs)
+    {
+        EPRINT("MACRO_BLOCK");
+        DiscardMacroblocks(pStorage, wf);
+        h264bsdMarkSliceCorrupted(pStorage, wf->firstMb);
+        STATS_START(statsTime);
+        (void)h264bsdConceal(pStorage, pStorage->currImage,
+            pStorage->sliceHeader->sliceType);
+#ifdef H264DEC_STATS
+        wf->stats.concealTime += h264bsdStatsTime() - statsTime;
+#endif
+    }
+
+    STATS_START(statsTime);
+    h264bsdFilterMbRows(pStorage->currImage, pStorage->mb, wf->filterRow,
+        wf->height - wf->filterRow);
+#ifdef H264DEC_STATS
+    wf->stats.deblockTime += h264bsdStatsTime() - statsTime;
+#endif
+
+    SetProgress(threads, &wf->refRows, wf->height);
+
+    pthread_mutex_lock(&threads->mutex);
+    wf->done = HANTRO_TRUE;
+    pthread_cond_broadcast(&threads->jobDone);
+    pthread_mutex_unlock(&threads->mutex);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: DiscardMacroblocks
+
+        Functional description:
+            Mark the macroblocks of a wavefront following the one failed
+            to reconstruct not decoded and store the last decoded
+            macroblock of an I slice for error concealment, as if the slice
+            was decoded sequentially.
+
+------------------------------------------------------------------------------*/
+
+void DiscardMacroblocks(storage_t *pStorage, wavefront_t *wf)
+{
+
+/* Variables */
+
+    u32 i, sliceId;
+
+/* Code */
+
+    sliceId = pStorage->slice->sliceId;
+    for (i = wf->error + 1; i < pStorage->picSizeInMbs &&
+         pStorage->mb[i].sliceId == sliceId; i++)
+    {
+        pStorage->mb[i].sliceId = 0;
+        pStorage->mb[i].decoded = 0;
+    }
+    if (IS_I_SLICE(pStorage->sliceHeader->sliceType))
+        pStorage->slice->lastMbAddr =
+            wf->error > wf->firstMb ? wf->error - 1 : 0;
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: PrepareDetach
+
+        Functional description:
+            Allocate the memories needed to detach the picture of a
+            wavefront: macroblock storage for the next picture, unless the
+            one of the picture currently detached can be used, and a slice
+            group map of the picture for error concealment, the map of the
+            storage is recomputed for the next picture.
+
+        Returns:
+            HANTRO_OK   success
+            HANTRO_NOK  memory allocation failed
+
+------------------------------------------------------------------------------*/
+
+u32 PrepareDetach(storage_t *pStorage, wavefront_t *wf)
+{
+
+/* Variables */
+
+    u32 picSize;
+    sliceThreads_t *threads;
+
+/* Code */
+
+    threads = pStorage->threads;
+    picSize = pStorage->picSizeInMbs;
+
+    if (threads->wfPending == NULL &&
+        (threads->spareMb == NULL || threads->spareSize != picSize ||
+         threads->spareWidth != wf->width))
+    {
+        FREE(threads->spareMb);
+        ALLOCATE(threads->spareMb, picSize, mbStorage_t);
+        if (threads->spareMb == NULL)
+            return(HANTRO_NOK);
+        H264SwDecMemset(threads->spareMb, 0, picSize * sizeof(mbStorage_t));
+        h264bsdInitMbNeighbours(threads->spareMb, wf->width, picSize);
+        threads->spareWidth = wf->width;
+        threads->spareSize = picSize;
+    }
+
+    if (picSize > wf->numMaps)
+    {
+        FREE(wf->sliceGroupMap);
+        wf->numMaps = 0;
+        ALLOCATE(wf->sliceGroupMap, picSize, u32);
+        if (wf->sliceGroupMap == NULL)
+            return(HANTRO_NOK);
+        wf->numMaps = picSize;
+    }
+    /* single slice group */
+    H264SwDecMemset(wf->sliceGroupMap, 0, picSize * sizeof(u32));
+    pStorage->sliceGroupMap = wf->sliceGroupMap;
+
+    return(HANTRO_OK);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: WaitProgress
+
+        Functional description:
+            Wait until a wavefront progress counter reaches the given value.
+            The counter is polled WAVEFRONT_SPIN times before the thread
+            blocks on wfProgress.
+
+        Inputs:
+            wf          wavefront the thread is decoding, NULL if waiting
+                        cannot be cancelled
+            pCounter    counter to wait for
+            value       value to wait for
+            mbAddr      macroblock the thread waits to process, waiting is
+                        cancelled if decoding of the slice stops before it
+
+        Returns:
+            HANTRO_TRUE     counter reached the value
+            HANTRO_FALSE    waiting cancelled
+
+------------------------------------------------------------------------------*/
+
+u32 WaitProgress(sliceThreads_t *threads, wavefront_t *wf, u32 *pCounter,
+    u32 value, u32 mbAddr)
+{
+
+/* Variables */
+
+    u32 i, ret;
+
+/* Code */
+
+    for (i = WAVEFRONT_SPIN; i--;)
+    {
+        if (__atomic_load_n(pCounter, __ATOMIC_ACQUIRE) >= value)
+            return(HANTRO_TRUE);
+        if (wf != NULL &&
+            __atomic_load_n(&wf->limit, __ATOMIC_ACQUIRE) <= mbAddr)
+            return(HANTRO_FALSE);
+    }
+
+    pthread_mutex_lock(&threads->mutex);
+    /* waiter count is incremented before checking the counter, see
+     * SetProgress */
+    (void)__atomic_add_fetch(&threads->wfWaiters, 1, __ATOMIC_SEQ_CST);
+    for (;;)
+    {
+        if (__atomic_load_n(pCounter, __ATOMIC_SEQ_CST) >= value)
+        {
+            ret = HANTRO_TRUE;
+            break;
+        }
+        if (wf != NULL &&
+            __atomic_load_n(&wf->limit, __ATOMIC_SEQ_CST) <= mbAddr)
+        {
+            ret = HANTRO_FALSE;
+            break;
+        }
+        pthread_cond_wait(&threads->wfProgress, &threads->mutex);
+    }
+    (void)__atomic_sub_fetch(&threads->wfWaiters, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&threads->mutex);
+
+    return(ret);
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: SetProgress
+
+        Functional description:
+            Update a wavefront progress counter and wake up the blocked
+            threads, if any. Locking is avoided when no thread is blocked.
+
+------------------------------------------------------------------------------*/
+
+void SetProgress(sliceThreads_t *threads, u32 *pCounter, u32 value)
+{
+
+/* Code */
+
+    __atomic_store_n(pCounter, value, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&threads->wfWaiters, __ATOMIC_SEQ_CST))
+    {
+        pthread_mutex_lock(&threads->mutex);
+        pthread_cond_broadcast(&threads->wfProgress);
+        pthread_mutex_unlock(&threads->mutex);
+    }
+
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: AddStats
+
+        Functional description:
+            Add statistics collected during slice data decoding of a job to
+            the statistics of the decoder. Times of the jobs are summed, i.e.
+            they add up to the processing time of all threads.
+
+------------------------------------------------------------------------------*/
+
+#ifdef H264DEC_STATS
+void AddStats(H264SwDecStats *pStats, H264SwDecStats *pJobStats)
+{
+
+/* Code */
+
+    pStats->mbLayerTime   += pJobStats->mbLayerTime;
+    pStats->intraMbTime   += pJobStats->intraMbTime;
+    pStats->interMbTime   += pJobStats->interMbTime;
+    pStats->deblockTime   += pJobStats->deblockTime;
+    pStats->concealTime   += pJobStats->concealTime;
+    pStats->numIntraMbs   += pJobStats->numIntraMbs;
+    pStats->numPcmMbs     += pJobStats->numPcmMbs;
+    pStats->numInterMbs   += pJobStats->numInterMbs;
+    pStats->numSkippedMbs += pJobStats->numSkippedMbs;
+
+}
+#endif
+
+#endif /* H264DEC_THREADS */
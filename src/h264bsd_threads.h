@@ -0,0 +1,219 @@
+/*------------------------------------------------------------------------------
+
+    Table of contents
+
+    1. Include headers
+    2. Module defines
+    3. Data types
+    4. Function prototypes
+
+------------------------------------------------------------------------------*/
+
+#ifndef H264SWDEC_THREADS_H
+#define H264SWDEC_THREADS_H
+
+/*------------------------------------------------------------------------------
+    1. Include headers
+------------------------------------------------------------------------------*/
+
+#include "basetype.h"
+#include "h264bsd_storage.h"
+#include "h264bsd_stream.h"
+
+#ifdef H264DEC_THREADS
+
+#include <pthread.h>
+
+/*------------------------------------------------------------------------------
+    2. Module defines
+--------------------------------------------------------------------------------
+
+H264DEC_THREADS     Number of worker threads used to decode the slices of a
+                    picture in parallel. Slices are queued as their headers
+                    are decoded and reconstructed by the workers and the
+                    decoding thread, deblocking is performed once all slices
+                    of the picture have been finished. Slices are decoded in
+                    parallel only within one H264SwDecDecode call, so whole
+                    access units should be passed to the decoder. Requires
+                    pthreads (Emscripten: -pthread, decoder running in a web
+                    worker).
+
+                    A slice queued alone (a picture consisting of a single
+                    slice, or slices passed one per call) is decoded in
+                    wavefront order instead: the decoding thread only parses
+                    the macroblocks into a ring of macroblock records, the
+                    workers reconstruct one macroblock row each, every
+                    macroblock once the one above-right of it is ready. The
+                    ring has a single producer and its progress counters are
+                    updated without locking, the parser waits only when the
+                    ring is full. With H264DEC_ROW_DEBLOCK rows are deblocked
+                    as soon as the row below them has been reconstructed,
+                    otherwise once the whole picture has been reconstructed.
+
+                    Once the last macroblock of a picture has been parsed by
+                    such a slice, the preceding slices of the picture having
+                    been decoded in raster scan order, the picture is stored
+                    to the DPB and decoding continues with the next picture
+                    while the workers finish it (frame pipelining), i.e.
+                    entropy decoding of the next picture overlaps
+                    reconstruction of the previous one. The picture gets its
+                    own macroblock storage, inter prediction of the
+                    following pictures waits until the reference rows it
+                    reads have been reconstructed and deblocked. Picture
+                    buffers used by the unfinished picture are not handed
+                    out, nor output, before it is finished.
+
+                    Reference rows become usable row by row only with
+                    H264DEC_ROW_DEBLOCK. Without it a row is final only once
+                    the whole picture has been deblocked, so the first inter
+                    macroblock of the next picture waits for all of the
+                    previous one: only parsing of the next picture and intra
+                    macroblocks preceding its first inter macroblock overlap
+                    reconstruction of the previous picture. Row deblocking is
+                    not the default as it changes the output of corrupted
+                    streams (see h264bsdDecodeSliceData), a slice failing to
+                    decode is concealed over rows already deblocked. Builds
+                    using frame pipelining for throughput should define
+                    H264DEC_ROW_DEBLOCK together with H264DEC_THREADS.
+
+------------------------------------------------------------------------------*/
+
+/* maximum number of slices queued before the decoding thread waits for them
+ * to be finished */
+#define MAX_SLICE_JOBS 16
+
+/* number of macroblock rows parsed into the wavefront ring of macroblock
+ * records, the decoding thread may be ahead of the oldest row being
+ * reconstructed by this many rows */
+#define WAVEFRONT_ROWS (2 * (H264DEC_THREADS + 1))
+
+/* number of polls of a progress counter before blocking */
+#define WAVEFRONT_SPIN 1000
+
+/*------------------------------------------------------------------------------
+    3. Data types
+------------------------------------------------------------------------------*/
+
+/* slice queued for decoding. Storage is a copy of the decoder storage at the
+ * time the slice was queued, slice, image and reference picture list state
+ * of the copy are private to the job, macroblock and picture data shared */
+typedef struct
+{
+    storage_t storage;
+    dpbPicture_t *refPicList[MAX_NUM_REF_IDX_L0_ACTIVE + 1];
+    strmData_t strm;
+    u32 result;
+} sliceJob_t;
+
+/* worker thread and its macroblock layer scratch */
+typedef struct
+{
+    struct sliceThreads *threads;
+    pthread_t thread;
+    macroblockLayer_t *mbLayer;
+} sliceWorker_t;
+
+/* picture decoded in wavefront order. The job is a copy of the queued slice
+ * with reference picture list pointing to a copy of the reference pictures,
+ * picture may be finished after the DPB has been modified. Progress counters
+ * are accessed with atomic operations */
+typedef struct
+{
+    sliceJob_t job;
+    dpbPicture_t refPics[MAX_NUM_REF_IDX_L0_ACTIVE + 1];
+    u32 seq;                    /* order of the wavefronts started */
+    u8 *records;                /* ring of WAVEFRONT_ROWS rows of records */
+    u32 numRecords;
+    u32 *rowDone;               /* number of reconstructed mbs of each row */
+    u32 numRows;
+    u32 width;                  /* picture size in macroblocks */
+    u32 height;
+    u32 firstMb;
+    u32 parsed;                 /* address of the next mb to be parsed */
+    u32 limit;                  /* mbs starting from this are not decoded */
+    u32 error;                  /* first mb failed to reconstruct */
+    u32 nextRow;                /* next row to be reconstructed */
+    u32 endRow;
+    u32 rowsDone;               /* number of rows finished */
+    u32 filter;                 /* rows deblocked during reconstruction */
+    u32 filtering;              /* set while a thread is deblocking */
+    u32 filterRow;              /* next row to be deblocked */
+
+    /* frame pipelining: set when the picture is finished by the workers,
+     * picture data while it is in the DPB unfinished, number of rows
+     * usable as reference, macroblock storage and slice group map of the
+     * picture and set when finished */
+    u32 detached;
+    u8 *data;
+    u32 refRows;
+    mbStorage_t *mb;
+    u32 *sliceGroupMap;
+    u32 numMaps;
+    u32 done;
+#ifdef H264DEC_STATS
+    H264SwDecStats stats;
+#endif
+} wavefront_t;
+
+typedef struct sliceThreads
+{
+    sliceWorker_t worker[H264DEC_THREADS];
+    u32 numWorkers;
+    pthread_mutex_t mutex;
+    pthread_cond_t jobReady;
+    pthread_cond_t jobDone;
+    u32 quit;
+
+    sliceJob_t job[MAX_SLICE_JOBS];
+    /* jobs queued, ready to be started (extent known), started and finished
+     * since the last synchronization */
+    u32 numJobs;
+    u32 numReady;
+    u32 numStarted;
+    u32 numDone;
+
+    /* number of queued slices of the current picture and first macroblock
+     * of the last one */
+    u32 numPicJobs;
+    u32 lastFirstMb;
+
+    /* wavefront of the picture being parsed and the one being finished by
+     * the workers, if any. Waiting threads block on wfProgress after
+     * polling the counters for a while */
+    wavefront_t wf[2];
+    wavefront_t *wfActive;
+    wavefront_t *wfPending;
+    u32 wfSeq;
+    u32 wfRecordSize;
+    u32 wfWaiters;
+    pthread_cond_t wfProgress;
+
+    /* macroblock storage given to the decoder when a picture is detached */
+    mbStorage_t *spareMb;
+    u32 spareWidth;
+    u32 spareSize;
+} sliceThreads_t;
+
+/*------------------------------------------------------------------------------
+    4. Function prototypes
+------------------------------------------------------------------------------*/
+
+u32 h264bsdInitThreads(storage_t *pStorage);
+void h264bsdShutdownThreads(storage_t *pStorage);
+
+u32 h264bsdCanQueueSlice(storage_t *pStorage, sliceHeader_t *pSliceHeader);
+u32 h264bsdSliceQueueFull(storage_t *pStorage);
+void h264bsdQueueSlice(storage_t *pStorage, strmData_t *pStrmData);
+u32 h264bsdSyncSlices(storage_t *pStorage);
+
+u32 h264bsdStartWavefront(storage_t *pStorage);
+macroblockLayer_t *h264bsdWavefrontRecord(storage_t *pStorage, u32 mbAddr);
+void h264bsdWavefrontParsed(storage_t *pStorage, u32 mbAddr);
+u32 h264bsdFinishWavefront(storage_t *pStorage, u32 result);
+
+void h264bsdSyncPicture(storage_t *pStorage, u8 *data);
+void h264bsdWaitRefRows(dpbStorage_t *dpb, u8 *data, u32 numRows);
+
+#endif /* H264DEC_THREADS */
+
+#endif /* #ifdef H264SWDEC_THREADS_H */
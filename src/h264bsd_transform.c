@@ -36,6 +36,7 @@
 #include "basetype.h"
 #include "h264bsd_transform.h"
 #include "h264bsd_util.h"
+#include "h264bsd_simd.h"
 
 /*------------------------------------------------------------------------------
     2. External compiler flags
@@ -67,6 +68,163 @@ static const u8 qpDiv6[52] = {0,0,0,0,0,0,1,1,1,1,1,1,2,2,2,2,2,2,3,3,3,3,3,3,
     4. Local function prototypes
 ------------------------------------------------------------------------------*/
 
+#ifdef H264DEC_SIMD
+
+/*------------------------------------------------------------------------------
+
+    Function: Transpose4x4
+
+        Functional description:
+            Transpose a 4x4 block held in four row vectors.
+
+------------------------------------------------------------------------------*/
+
+static inline void Transpose4x4(v4i32 *r0, v4i32 *r1, v4i32 *r2, v4i32 *r3)
+{
+    v4i32 a, b, c, d;
+
+    a = __builtin_shufflevector(*r0, *r1, 0, 4, 1, 5);
+    b = __builtin_shufflevector(*r2, *r3, 0, 4, 1, 5);
+    c = __builtin_shufflevector(*r0, *r1, 2, 6, 3, 7);
+    d = __builtin_shufflevector(*r2, *r3, 2, 6, 3, 7);
+
+    *r0 = __builtin_shufflevector(a, b, 0, 1, 4, 5);
+    *r1 = __builtin_shufflevector(a, b, 2, 3, 6, 7);
+    *r2 = __builtin_shufflevector(c, d, 0, 1, 4, 5);
+    *r3 = __builtin_shufflevector(c, d, 2, 3, 6, 7);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: LoadZigZag
+
+        Functional description:
+            Load 16 coefficients in zig-zag scan order and return them as
+            rows of the 4x4 block in raster order.
+
+------------------------------------------------------------------------------*/
+
+static inline void LoadZigZag(const i32 *data, v4i32 *r0, v4i32 *r1,
+    v4i32 *r2, v4i32 *r3)
+{
+    v4i32 v0, v1, v2, v3, t;
+
+    memcpy(&v0, data, 16);
+    memcpy(&v1, data + 4, 16);
+    memcpy(&v2, data + 8, 16);
+    memcpy(&v3, data + 12, 16);
+
+    /* scan positions of rows 0..3: {0,1,5,6} {2,4,7,12} {3,8,11,13}
+     * {9,10,14,15} */
+    *r0 = __builtin_shufflevector(v0, v1, 0, 1, 5, 6);
+    t = __builtin_shufflevector(v0, v1, 2, 4, 7, 7);
+    *r1 = __builtin_shufflevector(t, v3, 0, 1, 2, 4);
+    t = __builtin_shufflevector(v0, v2, 3, 4, 7, 7);
+    *r2 = __builtin_shufflevector(t, v3, 0, 1, 2, 5);
+    *r3 = __builtin_shufflevector(v2, v3, 1, 2, 6, 7);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: StoreRows
+
+        Functional description:
+            Store four row vectors of a 4x4 block in raster order.
+
+------------------------------------------------------------------------------*/
+
+static inline void StoreRows(i32 *data, v4i32 r0, v4i32 r1, v4i32 r2,
+    v4i32 r3)
+{
+    memcpy(data, &r0, 16);
+    memcpy(data + 4, &r1, 16);
+    memcpy(data + 8, &r2, 16);
+    memcpy(data + 12, &r3, 16);
+}
+
+/*------------------------------------------------------------------------------
+
+    Function: ProcessBlockSimd
+
+        Functional description:
+            Vector version of the general case of h264bsdProcessBlock.
+            Coefficients are kept in 32-bit lanes so that results, including
+            the range check of out-of-spec input, are identical with the
+            scalar code. Each pass works on four rows or columns at once,
+            the 1-D transforms across lanes are done by transposing.
+
+        Inputs:
+            data            pointer to data to be processed, data[0] already
+                            scaled or handled separately
+            scale0          levelScale for positions (even, even)
+            scale1          levelScale for positions (even, odd)
+            scale2          levelScale for positions (odd, odd)
+
+        Outputs:
+            data            processed data
+
+        Returns:
+            HANTRO_OK       success
+            HANTRO_NOK      processed data not in valid range [-512, 511]
+
+------------------------------------------------------------------------------*/
+
+static u32 ProcessBlockSimd(i32 *data, i32 scale0, i32 scale1, i32 scale2)
+{
+
+/* Variables */
+
+    v4i32 r0, r1, r2, r3, tmp0, tmp1, tmp2, tmp3;
+    v4u32 range;
+
+/* Code */
+
+    /* inverse zig-zag scan and inverse quantization, data[0] is left
+     * unscaled */
+    LoadZigZag(data, &r0, &r1, &r2, &r3);
+    r0 *= (v4i32){1, scale1, scale0, scale1};
+    r1 *= (v4i32){scale1, scale2, scale1, scale2};
+    r2 *= (v4i32){scale0, scale1, scale0, scale1};
+    r3 *= (v4i32){scale1, scale2, scale1, scale2};
+
+    /* horizontal transform, on columns after transposing */
+    Transpose4x4(&r0, &r1, &r2, &r3);
+    tmp0 = r0 + r2;
+    tmp1 = r0 - r2;
+    tmp2 = (r1 >> 1) - r3;
+    tmp3 = r1 + (r3 >> 1);
+    r0 = tmp0 + tmp3;
+    r1 = tmp1 + tmp2;
+    r2 = tmp1 - tmp2;
+    r3 = tmp0 - tmp3;
+
+    /* then vertical transform, on rows after transposing back */
+    Transpose4x4(&r0, &r1, &r2, &r3);
+    tmp0 = r0 + r2;
+    tmp1 = r0 - r2;
+    tmp2 = (r1 >> 1) - r3;
+    tmp3 = r1 + (r3 >> 1);
+    r0 = (tmp0 + tmp3 + 32) >> 6;
+    r1 = (tmp1 + tmp2 + 32) >> 6;
+    r2 = (tmp1 - tmp2 + 32) >> 6;
+    r3 = (tmp0 - tmp3 + 32) >> 6;
+
+    StoreRows(data, r0, r1, r2, r3);
+
+    /* check that each value is in the range [-512,511], i.e. that no bits
+     * above bit 9 are set in any (value + 512) */
+    range = (v4u32)(r0 + 512) | (v4u32)(r1 + 512) |
+            (v4u32)(r2 + 512) | (v4u32)(r3 + 512);
+    range &= ~1023U;
+    if (range[0] | range[1] | range[2] | range[3])
+        return(HANTRO_NOK);
+
+    return(HANTRO_OK);
+
+}
+
+#endif /* H264DEC_SIMD */
+
 /*------------------------------------------------------------------------------
 
     Function: h264bsdProcessBlock
@@ -97,10 +255,12 @@ u32 h264bsdProcessBlock(i32 *data, u32 qp, u32 skip, u32 coeffMap)
 /* Variables */
 
     i32 tmp0, tmp1, tmp2, tmp3;
+#ifndef H264DEC_SIMD
     i32 d1, d2, d3;
     u32 row,col;
-    u32 qpDiv;
     i32 *ptr;
+#endif
+    u32 qpDiv;
 
 /* Code */
 
@@ -116,6 +276,9 @@ u32 h264bsdProcessBlock(i32 *data, u32 qp, u32 skip, u32 coeffMap)
      * the scanning order into account */
     if (coeffMap & 0xFF9C)
     {
+#ifdef H264DEC_SIMD
+        return(ProcessBlockSimd(data, tmp1, tmp2, tmp3));
+#else
         /* do the zig-zag scan and inverse quantization */
         d1 = data[1];
         d2 = data[14];
@@ -184,6 +347,7 @@ u32 h264bsdProcessBlock(i32 *data, u32 qp, u32 skip, u32 coeffMap)
                 ((u32)(data[12] + 512) > 1023) )
                 return(HANTRO_NOK);
         }
+#endif /* H264DEC_SIMD */
     }
     else /* rows 1, 2 and 3 are zero */
     {
@@ -230,6 +394,7 @@ u32 h264bsdProcessBlock(i32 *data, u32 qp, u32 skip, u32 coeffMap)
 
 }
 
+#ifndef H264DEC_SIMD
 /*------------------------------------------------------------------------------
 
     Function: h264bsdProcessLumaDc
@@ -334,6 +499,79 @@ void h264bsdProcessLumaDc(i32 *data, u32 qp)
 
 }
 
+#else /* H264DEC_SIMD */
+
+/*------------------------------------------------------------------------------
+
+    Function: h264bsdProcessLumaDc
+
+        Functional description:
+            Vector version of the function above, see ProcessBlockSimd.
+
+------------------------------------------------------------------------------*/
+
+void h264bsdProcessLumaDc(i32 *data, u32 qp)
+{
+
+/* Variables */
+
+    v4i32 r0, r1, r2, r3, tmp0, tmp1, tmp2, tmp3;
+    u32 qpDiv;
+    i32 levScale, rnd;
+
+/* Code */
+
+    qpDiv = qpDiv6[qp];
+    levScale = levelScale[qpMod6[qp]][0];
+
+    /* zig-zag scan and horizontal transform, on columns after
+     * transposing */
+    LoadZigZag(data, &r0, &r1, &r2, &r3);
+    Transpose4x4(&r0, &r1, &r2, &r3);
+    tmp0 = r0 + r2;
+    tmp1 = r0 - r2;
+    tmp2 = r1 - r3;
+    tmp3 = r1 + r3;
+    r0 = tmp0 + tmp3;
+    r1 = tmp1 + tmp2;
+    r2 = tmp1 - tmp2;
+    r3 = tmp0 - tmp3;
+
+    /* then vertical transform and inverse scaling, on rows after
+     * transposing back */
+    Transpose4x4(&r0, &r1, &r2, &r3);
+    tmp0 = r0 + r2;
+    tmp1 = r0 - r2;
+    tmp2 = r1 - r3;
+    tmp3 = r1 + r3;
+    r0 = tmp0 + tmp3;
+    r1 = tmp1 + tmp2;
+    r2 = tmp1 - tmp2;
+    r3 = tmp0 - tmp3;
+
+    if (qp >= 12)
+    {
+        levScale <<= (qpDiv-2);
+        r0 *= levScale;
+        r1 *= levScale;
+        r2 *= levScale;
+        r3 *= levScale;
+    }
+    else
+    {
+        rnd = ((1 - qpDiv) == 0) ? 1 : 2;
+        r0 = (r0 * levScale + rnd) >> (i32)(2-qpDiv);
+        r1 = (r1 * levScale + rnd) >> (i32)(2-qpDiv);
+        r2 = (r2 * levScale + rnd) >> (i32)(2-qpDiv);
+        r3 = (r3 * levScale + rnd) >> (i32)(2-qpDiv);
+    }
+
+    StoreRows(data, r0, r1, r2, r3);
+
+}
+
+#endif /* H264DEC_SIMD */
+
 /*------------------------------------------------------------------------------
 
     Function: h264bsdProcessChromaDc
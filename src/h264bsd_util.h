@@ -64,9 +64,6 @@
 #define MEMORY_ALLOCATION_ERROR 0xFFFF
 #define PARAM_SET_ERROR 0xFFF0
 
-/* value to be returned by GetBits if stream buffer is empty */
-#define END_OF_STREAM 0xFFFFFFFFU
-
 #define EMPTY_RESIDUAL_INDICATOR 0xFFFFFF
 
 /* macro to mark a residual block empty, i.e. contain zero coefficients */
@@ -138,6 +135,15 @@
 /* macro to clip a value z, so that 0 <= z =< 255 */
 #define CLIP1(z) (((z) < 0) ? 0 : (((z) > 255) ? 255 : (z)))
 
+/* macro to count leading zeros of a non-zero 32-bit value */
+#if defined(__GNUC__) || defined(__clang__)
+#define COUNT_LEADING_ZEROS(value) ((u32)__builtin_clz(value))
+#elif defined(H264DEC_NEON)
+#define COUNT_LEADING_ZEROS(value) h264bsdCountLeadingZeros(value)
+#else
+#define COUNT_LEADING_ZEROS(value) h264bsdCountLeadingZeros(value, 32)
+#endif
+
 /* macro to allocate memory */
 #define ALLOCATE(ptr, count, type) \
 { \
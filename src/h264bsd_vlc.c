@@ -52,6 +52,11 @@
  * function */
 #define BIG_CODE_NUM 0xFFFFFFFFU
 
+/* maximum number of leading zeros of a code word decoded without falling
+ * back to the bit-by-bit path, code length 2*28+1 = 57 bits is the number
+ * of bits guaranteed to be valid in h264bsdShowBits64 */
+#define MAX_FAST_ZEROS 28
+
 /* Mapping tables for coded_block_pattern, used for decoding of mapped
  * Exp-Golomb codes */
 static const u8 codedBlockPatternIntra4x4[48] = {
@@ -87,6 +92,10 @@ static const u8 codedBlockPatternInter[48] = {
             Symbol 2^32 is out of unsigned 32-bit range but is needed for
             DecodeExpGolombSigned to express value -2^31.
 
+            Code words with at most 28 leading zeros are decoded from a
+            single 64-bit read with one count of leading zeros, longer ones
+            take the bit-by-bit path.
+
         Inputs:
             pStrmData       pointer to stream data structure
 
@@ -105,49 +114,32 @@ u32 h264bsdDecodeExpGolombUnsigned(strmData_t *pStrmData, u32 *codeNum)
 
 /* Variables */
 
-    u32 bits, numZeros;
+    u32 bits, numZeros, len;
+    u64 bits64;
 
 /* Code */
 
     ASSERT(pStrmData);
     ASSERT(codeNum);
 
-    bits = h264bsdShowBits32(pStrmData);
+    bits64 = h264bsdShowBits64(pStrmData);
 
-    /* first bit is 1 -> code length 1 */
-    if (bits >= 0x80000000)
-    {
-        h264bsdFlushBits(pStrmData, 1);
-        *codeNum = 0;
-        return(HANTRO_OK);
-    }
-    /* second bit is 1 -> code length 3 */
-    else if (bits >= 0x40000000)
-    {
-        if (h264bsdFlushBits(pStrmData, 3) == END_OF_STREAM)
-            return(HANTRO_NOK);
-        *codeNum = 1 + ((bits >> 29) & 0x1);
-        return(HANTRO_OK);
-    }
-    /* third bit is 1 -> code length 5 */
-    else if (bits >= 0x20000000)
-    {
-        if (h264bsdFlushBits(pStrmData, 5) == END_OF_STREAM)
-            return(HANTRO_NOK);
-        *codeNum = 3 + ((bits >> 27) & 0x3);
-        return(HANTRO_OK);
-    }
-    /* fourth bit is 1 -> code length 7 */
-    else if (bits >= 0x10000000)
+    /* at most MAX_FAST_ZEROS leading zeros -> whole code word (2*numZeros+1
+     * bits) is within the 57 valid bits of bits64. Code num is the value of
+     * the code word minus one */
+    if (bits64 >= ((u64)1 << (63 - MAX_FAST_ZEROS)))
     {
-        if (h264bsdFlushBits(pStrmData, 7) == END_OF_STREAM)
+        numZeros = COUNT_LEADING_ZEROS((u32)(bits64 >> 32));
+        len = 2 * numZeros + 1;
+        if (h264bsdFlushBits(pStrmData, len) == END_OF_STREAM)
             return(HANTRO_NOK);
-        *codeNum = 7 + ((bits >> 25) & 0x7);
+        *codeNum = (u32)(bits64 >> (64 - len)) - 1;
         return(HANTRO_OK);
     }
     /* other code lengths */
     else
     {
+        bits = (u32)(bits64 >> 32);
 #ifndef H264DEC_NEON
         numZeros = 4 + h264bsdCountLeadingZeros(bits, 28);
 #else
@@ -232,7 +224,7 @@ u32 h264bsdDecodeExpGolombSigned(strmData_t *pStrmData, i32 *value)
 
 /* Variables */
 
-    u32 status, codeNum = 0;
+    u32 status, codeNum = 0, sign;
 
 /* Code */
 
@@ -259,13 +251,10 @@ u32 h264bsdDecodeExpGolombSigned(strmData_t *pStrmData, i32 *value)
     else if (status == HANTRO_OK)
     {
         /* (-1)^(codeNum+1) results in positive sign if codeNum is odd,
-         * negative when it is even. (codeNum+1)/2 is obtained as
-         * (codeNum+1)>>1 when value is positive and as (-codeNum)>>1 for
-         * negative value */
-        /*lint -e702 */
-        *value = (codeNum & 0x1) ? (i32)((codeNum + 1) >> 1) :
-                                  -(i32)((codeNum + 1) >> 1);
-        /*lint +e702 */
+         * negative when it is even. Negation is done without a branch as
+         * (x ^ sign) - sign where sign is all ones for even codeNum */
+        sign = (codeNum & 0x1) - 1;
+        *value = (i32)((((codeNum + 1) >> 1) ^ sign) - sign);
         return(HANTRO_OK);
     }
 
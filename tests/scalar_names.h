@@ -0,0 +1,50 @@
+/*------------------------------------------------------------------------------
+
+    Names of the external symbols of the decoder sources built a second time
+    with H264DEC_NO_SIMD for h264simdtest, included before anything else in
+    those sources. The scalar copies get the suffix Scalar so that they can
+    be linked together with the vector versions of the native library.
+
+------------------------------------------------------------------------------*/
+
+#ifndef H264SWDEC_SCALAR_NAMES_H
+#define H264SWDEC_SCALAR_NAMES_H
+
+/* h264bsd_reconstruct.c */
+#define h264bsdPredictSamples           h264bsdPredictSamplesScalar
+#define h264bsdCopyMacroblock           h264bsdCopyMacroblockScalar
+#define h264bsdFillBlock                h264bsdFillBlockScalar
+#define h264bsdFillRow7                 h264bsdFillRow7Scalar
+#define h264bsdInterpolateChromaHor     h264bsdInterpolateChromaHorScalar
+#define h264bsdInterpolateChromaVer     h264bsdInterpolateChromaVerScalar
+#define h264bsdInterpolateChromaHorVer  h264bsdInterpolateChromaHorVerScalar
+#define h264bsdInterpolateVerHalf       h264bsdInterpolateVerHalfScalar
+#define h264bsdInterpolateVerQuarter    h264bsdInterpolateVerQuarterScalar
+#define h264bsdInterpolateHorHalf       h264bsdInterpolateHorHalfScalar
+#define h264bsdInterpolateHorQuarter    h264bsdInterpolateHorQuarterScalar
+#define h264bsdInterpolateHorVerQuarter h264bsdInterpolateHorVerQuarterScalar
+#define h264bsdInterpolateMidHalf       h264bsdInterpolateMidHalfScalar
+#define h264bsdInterpolateMidVerQuarter h264bsdInterpolateMidVerQuarterScalar
+#define h264bsdInterpolateMidHorQuarter h264bsdInterpolateMidHorQuarterScalar
+
+/* h264bsd_transform.c */
+#define h264bsdProcessBlock             h264bsdProcessBlockScalar
+#define h264bsdProcessLumaDc            h264bsdProcessLumaDcScalar
+#define h264bsdProcessChromaDc          h264bsdProcessChromaDcScalar
+
+/* h264bsd_intra_prediction.c */
+#define h264bsdBlockX                   h264bsdBlockXScalar
+#define h264bsdBlockY                   h264bsdBlockYScalar
+#define h264bsdClip                     h264bsdClipScalar
+#define h264bsdAddResidual              h264bsdAddResidualScalar
+#define h264bsdGetNeighbourPels         h264bsdGetNeighbourPelsScalar
+#define h264bsdIntraPrediction          h264bsdIntraPredictionScalar
+#define h264bsdIntra4x4Prediction       h264bsdIntra4x4PredictionScalar
+#define h264bsdIntra16x16Prediction     h264bsdIntra16x16PredictionScalar
+#define h264bsdIntraChromaPrediction    h264bsdIntraChromaPredictionScalar
+
+/* h264bsd_deblocking.c */
+#define h264bsdFilterMbRows             h264bsdFilterMbRowsScalar
+#define InnerBoundaryStrength2          InnerBoundaryStrength2Scalar
+
+#endif /* #ifdef H264SWDEC_SCALAR_NAMES_H */
@@ -0,0 +1,433 @@
+#include "h264bsd_reconstruct.h"
+#include "h264bsd_intra_prediction.h"
+#include "h264bsd_neighbour.h"
+#include "h264bsd_deblocking.h"
+#include "h264bsd_transform.h"
+#include "h264bsd_image.h"
+#include "h264bsd_util.h"
+#include "h264bsd_simd.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Compares the vector kernels of the native library (H264DEC_SIMD) with the
+// scalar ones (H264DEC_NO_SIMD) on random input. The scalar versions are
+// built from the same sources with the names of scalar_names.h. Exits with
+// status 1 if any output differs. Options:
+//   -s <seed>   random seed (default 1)
+//   -n <count>  number of random cases per test (default 100000)
+
+void h264bsdPredictSamplesScalar(u8 *data, mv_t *mv, image_t *refPic,
+                                 u32 xA, u32 yA, u32 partX, u32 partY,
+                                 u32 partWidth, u32 partHeight);
+u32 h264bsdIntraPredictionScalar(mbStorage_t *pMb, macroblockLayer_t *mbLayer,
+                                 image_t *image, u32 mbNum,
+                                 u32 constrainedIntraPred, u8 *data);
+void h264bsdFilterMbRowsScalar(image_t *image, mbStorage_t *mb, u32 firstRow,
+                               u32 numRows);
+u32 h264bsdProcessBlockScalar(i32 *data, u32 qp, u32 skip, u32 coeffMap);
+void h264bsdProcessLumaDcScalar(i32 *data, u32 qp);
+
+typedef struct {
+    uint32_t seed;
+    long count;
+} test_options;
+
+static uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// random value in [0, n)
+static u32 random_below(uint32_t *state, u32 n) {
+    return (u32) (((uint64_t) xorshift32(state) * n) >> 32);
+}
+
+static i32 random_range(uint32_t *state, i32 min, i32 max) {
+    return min + (i32) random_below(state, (u32) (max - min + 1));
+}
+
+// Fill samples with random content of one of the kinds seen in pictures:
+// noise, binary (edges at full contrast) or low-entropy (flat areas)
+static void random_samples(uint32_t *state, u8 *data, size_t size) {
+    u32 kind = random_below(state, 3);
+    u32 base = random_below(state, 256);
+
+    for (size_t i = 0; i < size; i++) {
+        u32 r = xorshift32(state);
+        if (kind == 0) {
+            data[i] = (u8) r;
+        } else if (kind == 1) {
+            data[i] = (r & 1) ? 255 : 0;
+        } else {
+            data[i] = (u8) CLIP3(0, 255, (i32) base + (i32) (r & 7) - 4);
+        }
+    }
+}
+
+static int report(const char *test, long n, const u8 *simd, const u8 *scalar,
+                  size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (simd[i] != scalar[i]) {
+            fprintf(stderr, "%s: case %ld differs at byte %zu: %u != %u\n",
+                    test, n, i, simd[i], scalar[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*---------------------------- inter prediction ----------------------------*/
+
+// h264bsdPredictSamples, luma 6-tap and chroma bilinear interpolation, for
+// all partition sizes and fractional positions. Motion vectors reach up to
+// 48 pixels outside the picture so that overfill is covered.
+static int test_predict_samples(const test_options *options) {
+    static const u32 partSizes[7][2] = {
+        {16, 16}, {16, 8}, {8, 16}, {8, 8}, {8, 4}, {4, 8}, {4, 4}};
+    uint32_t state = options->seed;
+    u8 simd[384], scalar[384];
+    int errors = 0;
+
+    for (long n = 0; n < options->count && errors < 10; n++) {
+        u32 width = 1 + random_below(&state, 4);
+        u32 height = 1 + random_below(&state, 4);
+        size_t size = 384 * width * height;
+        image_t ref = {malloc(size), width, height, NULL, NULL, NULL};
+        if (!ref.data) return 1;
+        random_samples(&state, ref.data, size);
+
+        const u32 *part = partSizes[random_below(&state, 7)];
+        u32 xA = 16 * random_below(&state, width);
+        u32 yA = 16 * random_below(&state, height);
+        u32 partX = part[0] * random_below(&state, 16 / part[0]);
+        u32 partY = part[1] * random_below(&state, 16 / part[1]);
+        i32 range = 4 * (16 * (i32) MAX(width, height) + 48);
+        mv_t mv;
+        mv.hor = (i16) random_range(&state, -range, range);
+        mv.ver = (i16) random_range(&state, -range, range);
+
+        random_samples(&state, simd, sizeof(simd));
+        memcpy(scalar, simd, sizeof(scalar));
+        h264bsdPredictSamples(simd, &mv, &ref, xA, yA, partX, partY, part[0],
+                              part[1]);
+        h264bsdPredictSamplesScalar(scalar, &mv, &ref, xA, yA, partX, partY,
+                                    part[0], part[1]);
+        if (report("predict samples", n, simd, scalar, sizeof(simd))) {
+            fprintf(stderr, "  %ux%u picture, %ux%u partition at (%u,%u), "
+                    "mv (%d,%d)\n", width, height, part[0], part[1],
+                    xA + partX, yA + partY, mv.hor, mv.ver);
+            errors++;
+        }
+        free(ref.data);
+    }
+    return errors;
+}
+
+/*---------------------------- inverse transform ---------------------------*/
+
+// Coefficient block with a random number of non-zero coefficients at
+// random scan positions, small, medium or large enough for the output of
+// the inverse transform to leave [-512, 511]. Returns the coefficient map.
+static u32 random_coeffs(uint32_t *state, i32 *data) {
+    u32 numCoeffs = random_below(state, 17);
+    i32 range = random_below(state, 4) ? 1 << random_below(state, 7) : 2047;
+    u32 coeffMap = 0;
+
+    memset(data, 0, 16 * sizeof(i32));
+    for (u32 i = 0; i < numCoeffs; i++) {
+        u32 pos = random_below(state, 16);
+        i32 level = random_range(state, -range, range);
+        data[pos] = level ? level : 1;
+        coeffMap |= 1U << pos;
+    }
+    return coeffMap;
+}
+
+// h264bsdProcessBlock and h264bsdProcessLumaDc for every qp in turn, on
+// random coefficient blocks, with and without a separately decoded DC
+// coefficient. The return value of h264bsdProcessBlock decides whether
+// the macroblock is concealed, so it is compared first and the output
+// only if the block is valid (it is left partly processed otherwise).
+static int test_transform(const test_options *options) {
+    uint32_t state = options->seed;
+    i32 simd[16], scalar[16];
+    int errors = 0;
+
+    for (long n = 0; n < options->count && errors < 10; n++) {
+        u32 qp = (u32) (n % 52);
+        u32 skip = random_below(&state, 2);
+        u32 coeffMap = random_coeffs(&state, simd);
+
+        if (skip) {
+            // output of the luma or chroma DC transform
+            simd[0] = random_range(&state, -(1 << 16), 1 << 16);
+            coeffMap = (coeffMap & ~1U) | random_below(&state, 2);
+        }
+        memcpy(scalar, simd, sizeof(scalar));
+        u32 simdRet = h264bsdProcessBlock(simd, qp, skip, coeffMap);
+        u32 scalarRet = h264bsdProcessBlockScalar(scalar, qp, skip,
+                                                  coeffMap);
+        int differs = simdRet != scalarRet;
+        if (differs) {
+            fprintf(stderr, "process block: case %ld returns %u != %u\n", n,
+                    simdRet, scalarRet);
+        } else if (simdRet == HANTRO_OK) {
+            differs = report("process block", n, (const u8 *) simd,
+                             (const u8 *) scalar, sizeof(simd));
+        }
+        if (differs) {
+            fprintf(stderr, "  qp %u, skip %u, coeffMap 0x%04x\n", qp, skip,
+                    coeffMap);
+            errors++;
+        }
+
+        (void) random_coeffs(&state, simd);
+        memcpy(scalar, simd, sizeof(scalar));
+        h264bsdProcessLumaDc(simd, qp);
+        h264bsdProcessLumaDcScalar(scalar, qp);
+        if (report("process luma dc", n, (const u8 *) simd,
+                   (const u8 *) scalar, sizeof(simd))) {
+            fprintf(stderr, "  qp %u\n", qp);
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/*---------------------------- intra prediction ----------------------------*/
+
+// Residual of one 4x4 block, empty or random within the range of the
+// inverse transform output
+static void random_residual(uint32_t *state, i32 *residual) {
+    if (random_below(state, 4) == 0) {
+        MARK_RESIDUAL_EMPTY(residual);
+        return;
+    }
+    i32 range = (i32) 1 << random_below(state, 10);
+    for (u32 i = 0; i < 16; i++) {
+        residual[i] = CLIP3(-512, 511, random_range(state, -range, range));
+    }
+}
+
+// h264bsdIntraPrediction of the centre macroblock of a 3x3 picture. Goes
+// through every combination of neighbour availability (A, B, C and D),
+// luma prediction (Intra 4x4, four Intra 16x16 modes), chroma mode and
+// constrained intra prediction, count cases in total, with random
+// neighbour samples, residual, neighbour types and 4x4 prediction modes.
+// Compares the return value, the macroblock buffer, the picture and the
+// 4x4 prediction modes.
+static int test_intra_prediction(const test_options *options) {
+    enum { combinations = 16 * 5 * 4 * 2, picSize = 9 * 384 };
+    static macroblockLayer_t mbLayer;
+    static mbStorage_t mb[2][9];
+    uint32_t state = options->seed;
+    u8 picture[3][picSize];
+    u8 buffer[2][384 + 15];
+    u8 *simd = ALIGN(buffer[0], 16), *scalar = ALIGN(buffer[1], 16);
+    int errors = 0;
+
+    for (long n = 0; n < options->count && errors < 10; n++) {
+        u32 combination = (u32) (n % combinations);
+        u32 available = combination & 15;
+        u32 lumaMode = (combination >> 4) % 5;
+        u32 chromaMode = (combination / 80) & 3;
+        u32 constrainedIntraPred = combination / 320;
+
+        // neighbours A, B, C and D are macroblocks 3, 1, 2 and 0, a
+        // neighbour of another slice is not available
+        static const u32 neighbourMb[4] = {3, 1, 2, 0};
+        memset(mb[0], 0, sizeof(mb[0]));
+        h264bsdInitMbNeighbours(mb[0], 3, 9);
+        for (u32 i = 0; i < 9; i++) {
+            mbStorage_t *pMb = mb[0] + i;
+            u32 kind = random_below(&state, 3);
+            pMb->mbType = kind == 0 ? P_L0_16x16 :
+                          kind == 1 ? I_4x4 : I_16x16_0_0_0;
+            for (u32 j = 0; j < 16; j++) {
+                pMb->intra4x4PredMode[j] = (u8) random_below(&state, 9);
+            }
+        }
+        for (u32 i = 0; i < 4; i++) {
+            mb[0][neighbourMb[i]].sliceId = (available >> i) & 1 ? 0 : 1;
+        }
+        mbStorage_t *pMb = mb[0] + 4;
+        pMb->mbType = lumaMode ? (mbType_e) (I_16x16_0_0_0 + lumaMode - 1) :
+                                 I_4x4;
+        memcpy(mb[1], mb[0], sizeof(mb[0]));
+        h264bsdInitMbNeighbours(mb[1], 3, 9);
+
+        for (u32 i = 0; i < 16; i++) {
+            mbLayer.mbPred.prevIntra4x4PredModeFlag[i] =
+                random_below(&state, 2);
+            mbLayer.mbPred.remIntra4x4PredMode[i] = random_below(&state, 8);
+        }
+        mbLayer.mbPred.intraChromaPredMode = chromaMode;
+        for (u32 i = 0; i < 24; i++) {
+            random_residual(&state, mbLayer.residual.level[i]);
+        }
+
+        random_samples(&state, picture[0], picSize);
+        memcpy(picture[1], picture[0], picSize);
+        memcpy(picture[2], picture[0], picSize);
+        random_samples(&state, simd, 384);
+        memcpy(scalar, simd, 384);
+
+        image_t image[2] = {{picture[1], 3, 3, NULL, NULL, NULL},
+                            {picture[2], 3, 3, NULL, NULL, NULL}};
+        h264bsdSetCurrImageMbPointers(&image[0], 4);
+        h264bsdSetCurrImageMbPointers(&image[1], 4);
+        u32 simdResult = h264bsdIntraPrediction(mb[0] + 4, &mbLayer,
+            &image[0], 4, constrainedIntraPred, simd);
+        u32 scalarResult = h264bsdIntraPredictionScalar(mb[1] + 4, &mbLayer,
+            &image[1], 4, constrainedIntraPred, scalar);
+
+        int failed = simdResult != scalarResult;
+        if (failed) {
+            fprintf(stderr, "intra prediction: case %ld returns %u != %u\n",
+                    n, simdResult, scalarResult);
+        }
+        failed = failed ||
+            report("intra prediction", n, simd, scalar, 384) ||
+            report("intra prediction", n, picture[1], picture[2], picSize) ||
+            report("intra prediction", n, mb[0][4].intra4x4PredMode,
+                   mb[1][4].intra4x4PredMode, 16);
+        if (failed) {
+            fprintf(stderr, "  available %c%c%c%c, %s, chroma mode %u%s\n",
+                    available & 1 ? 'A' : '-', available & 2 ? 'B' : '-',
+                    available & 4 ? 'C' : '-', available & 8 ? 'D' : '-',
+                    lumaMode ? "Intra 16x16" : "Intra 4x4", chromaMode,
+                    constrainedIntraPred ? ", constrained" : "");
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/*------------------------------- deblocking -------------------------------*/
+
+// Random macroblock of a P slice: type, coefficients, motion vectors and
+// reference pictures chosen so that all boundary strengths 0 to 4 occur,
+// motion vectors of neighbouring blocks differ by less or more than a pixel
+static void random_mb(uint32_t *state, mbStorage_t *pMb, u8 *refs) {
+    static const mbType_e types[] = {P_Skip, P_L0_16x16, P_L0_L0_16x8,
+        P_L0_L0_8x16, P_8x8, I_4x4, I_16x16_2_0_0};
+    u32 uniform = random_below(state, 2);
+    mv_t mv = {(i16) random_range(state, -6, 6),
+               (i16) random_range(state, -6, 6)};
+
+    pMb->mbType = types[random_below(state, 7)];
+    pMb->qpY = random_below(state, 52);
+    for (u32 i = 0; i < 27; i++) {
+        pMb->totalCoeff[i] =
+            pMb->mbType != P_Skip && random_below(state, 4) == 0 ?
+            (i16) (1 + random_below(state, 16)) : 0;
+    }
+    for (u32 i = 0; i < 16; i++) {
+        if (!uniform) {
+            mv.hor = (i16) random_range(state, -6, 6);
+            mv.ver = (i16) random_range(state, -6, 6);
+        }
+        pMb->mv[i] = mv;
+    }
+    u32 ref = random_below(state, 2);
+    for (u32 i = 0; i < 4; i++) {
+        if (!uniform) ref = random_below(state, 2);
+        pMb->refPic[i] = ref;
+        pMb->refAddr[i] = refs + ref;
+    }
+}
+
+// h264bsdFilterMbRows over a whole random picture of up to 5x5 macroblocks
+// in one to three slices, each with its own filter control: filtering
+// disabled or not, disabled on slice edges, random alpha/beta offsets and
+// chroma qp offset. Compares the filtered pictures.
+static int test_deblocking(const test_options *options) {
+    static mbStorage_t mb[25];
+    static u8 picture[2][25 * 384];
+    static u8 refs[2];
+    uint32_t state = options->seed;
+    int errors = 0;
+
+    // fewer cases, a case filters a whole picture
+    for (long n = 0; n < options->count / 10 && errors < 10; n++) {
+        u32 width = 1 + random_below(&state, 5);
+        u32 height = 1 + random_below(&state, 5);
+        u32 picSize = width * height;
+        mbStorage_t slice;
+
+        memset(mb, 0, sizeof(mb));
+        h264bsdInitMbNeighbours(mb, width, picSize);
+        for (u32 i = 0, sliceId = 0; i < picSize; i++) {
+            if (!i || random_below(&state, picSize) == 0) {
+                slice.sliceId = sliceId++;
+                slice.disableDeblockingFilterIdc = random_below(&state, 3);
+                slice.filterOffsetA = 2 * random_range(&state, -6, 6);
+                slice.filterOffsetB = 2 * random_range(&state, -6, 6);
+                slice.chromaQpIndexOffset = random_range(&state, -12, 12);
+            }
+            mb[i].sliceId = slice.sliceId;
+            mb[i].disableDeblockingFilterIdc =
+                slice.disableDeblockingFilterIdc;
+            mb[i].filterOffsetA = slice.filterOffsetA;
+            mb[i].filterOffsetB = slice.filterOffsetB;
+            mb[i].chromaQpIndexOffset = slice.chromaQpIndexOffset;
+            random_mb(&state, mb + i, refs);
+        }
+
+        random_samples(&state, picture[0], picSize * 384);
+        memcpy(picture[1], picture[0], picSize * 384);
+        image_t image[2] = {{picture[0], width, height, NULL, NULL, NULL},
+                            {picture[1], width, height, NULL, NULL, NULL}};
+        h264bsdFilterMbRows(&image[0], mb, 0, height);
+        h264bsdFilterMbRowsScalar(&image[1], mb, 0, height);
+
+        if (report("deblocking", n, picture[0], picture[1], picSize * 384)) {
+            fprintf(stderr, "  %ux%u picture\n", width, height);
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/*--------------------------------- driver ---------------------------------*/
+
+int main(int argc, char **argv) {
+    static const struct {
+        const char *name;
+        int (*run)(const test_options *);
+    } tests[] = {
+        {"predict samples", test_predict_samples},
+        {"transform", test_transform},
+        {"intra prediction", test_intra_prediction},
+        {"deblocking", test_deblocking},
+    };
+    test_options options = {1, 100000};
+    int result = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            options.seed = (uint32_t) strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            options.count = atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: h264simdtest [-s seed] [-n count]\n");
+            return 2;
+        }
+    }
+    if (!options.seed) options.seed = 1;
+
+#ifndef H264DEC_SIMD
+    printf("built without H264DEC_SIMD, comparing scalar with scalar\n");
+#endif
+    for (size_t t = 0; t < sizeof(tests) / sizeof(tests[0]); t++) {
+        int errors = tests[t].run(&options);
+        printf("%-20s %s\n", tests[t].name, errors ? "FAILED" : "ok");
+        if (errors) result = 1;
+    }
+    return result;
+}